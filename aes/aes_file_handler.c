@@ -13,6 +13,7 @@
 #include "aes_file_handler.h"
 #include "aes.h"
 #include "..\file_header\file_header.h"
+#include "../rng/rng.h"
 
 int aesEncryptFile(char *filePath, uc* key, int Nk, modeOfOperation mode)
 {
@@ -105,8 +106,7 @@ int aesDecryptFile(char *filePath, uc* key, int Nk, modeOfOperation mode)
     out = fopen(outPath, "rb");
     if (out != NULL) {
         fclose(out);
-        srand(time(NULL));
-        sprintf(get_filename_from_path(outPath), "%d\0", rand());
+        sprintf(get_filename_from_path(outPath), "%d\0", (int) (rngU32() >> 1));
         strcat(outPath, (char*) header.fileName);
     }
 
@@ -0,0 +1,750 @@
+/**
+* @file
+* @brief Funkcije za paralelnu enkripciju/dekripciju vise fajlova. Svaki zadati fajl dobija redni broj
+* i mesto u kruznom nizu rezultata. Radna nit koja zavrsi fajl ispisuje sve uzastopno zavrsene
+* rezultate, tako da je redosled poruka u logu isti kao redosled zadavanja fajlova.
+* @details Zadaci su tri vrste: jedan fajl, grupa malih fajlova i deo velikog fajla. Veliki fajl
+* otvara nit koja ga je uzela, zadaje njegove delove u svoj red (odakle ih ostale niti kradu), a
+* nit koja zavrsi poslednji deo spaja CRC-ove delova, upisuje heder i zatvara fajl.
+*/
+
+#include "batch.h"
+#include "process.h"
+#include "global.h"
+#include "io/stream.h"
+#include "io/checkpoint.h"
+#include "io/smallfile.h"
+#include "io/inplace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+* @brief Grupa malih fajlova koju obradjuje jedan zadatak.
+*/
+typedef struct BatchGroup {
+    DevQueue *queue;
+    int len;
+    BatchItem *items[GROUP_MAX_FILES];
+} BatchGroup;
+
+struct SplitFile;
+
+static void process_split(void *arg);
+static void process_item(void *arg);
+static void submit_task(BatchRun *run, DevQueue *queue, TaskFunc func, void *arg);
+
+/**
+* @brief Jedan deo velikog fajla.
+*/
+typedef struct SplitChunk {
+    struct SplitFile *split;
+    long index;
+} SplitChunk;
+
+/**
+* @brief Veliki fajl podeljen na delove.
+*/
+typedef struct SplitFile {
+    BatchItem *item;
+    streamjob_t job;
+    long n_chunks;
+    uint64_t chunk_blocks;
+    uint32_t *crcs;
+    SplitChunk *chunks;
+    atomic_long remaining;
+    atomic_int status;
+} SplitFile;
+
+/*********************** INTERNAL FUNCTIONS ***********************/
+/**
+* @brief Funkcija koja vraca trenutno vreme u sekundama.
+*/
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+* @brief Funkcija koja predaje logu zapis o ishodu obrade jednog fajla.
+* @param[in] run Pokazivac na stanje obrade
+* @param[in] item Pokazivac na obradjeni fajl
+*/
+static void log_item(BatchRun *run, BatchItem *item) {
+    LogRecord rec;
+
+    if (!run->sink)
+        return;
+
+    rec.type = LOG_FILE;
+    rec.seq = item->seq;
+    rec.encr_flag = run->encr_flag;
+    rec.algo = run->algo;
+    rec.result = item->exit_code;
+    rec.bytes = item->bytes;
+    rec.duration = item->duration;
+    rec.unchanged = item->unchanged;
+    snprintf(rec.file, sizeof(rec.file), "%s", item->file);
+    snprintf(rec.error_msg, sizeof(rec.error_msg), "%s", item->error_msg);
+    log_push(run->sink, &rec);
+}
+
+/**
+* @brief Funkcija koja posle uspesne obrade brise ili premesta original, u zavisnosti od opcija.
+* @param[in] run Pokazivac na stanje obrade
+* @param[in] item Pokazivac na obradjeni fajl
+* @return 0 ili IO_ERR
+*/
+static int finish_original(BatchRun *run, BatchItem *item) {
+    char path[BATCH_PATH_MAX];
+    int len;
+
+    if (run->after_success == AFTER_DELETE)
+        return unlink(item->file) ? IO_ERR : 0;
+
+    if (run->after_success == AFTER_MOVE) {
+        len = snprintf(path, sizeof(path), "%s/%s", run->move_dir, get_filename_from_path(item->file));
+        if (len < 0 || (size_t)len >= sizeof(path))
+            return IO_ERR;
+        return rename(item->file, path) ? IO_ERR : 0;
+    }
+    return 0;
+}
+
+/**
+* @brief Funkcija koja pravi podrazumevanu putanju izlaza enkripcije.
+* @param[in] item Pokazivac na fajl
+* @param[out] path Bafer za putanju
+* @param[in] len Velicina bafera
+*/
+static void encrypt_output_path(BatchItem *item, char *path, size_t len) {
+    if (item->out[0])
+        snprintf(path, len, "%s", item->out);
+    else
+        snprintf(path, len, "%s.dat", item->file);
+}
+
+/**
+* @brief Funkcija koja predaje logu rezultat fajla i oznacava fajl kao zavrsen. Log ispisuje zapise
+* redom rednih brojeva, pa se zapis predaje van run->lock, odmah po zavrsetku fajla.
+* @param[in] item Pokazivac na zavrseni fajl
+*/
+static void complete_item(BatchItem *item) {
+    BatchRun *run = item->run;
+    char out_path[BATCH_PATH_MAX + 4];
+
+    if (!item->exit_code && !item->unchanged && run->manifest && item->has_stat) {
+        encrypt_output_path(item, out_path, sizeof(out_path));
+        manifest_record(run->manifest, item->file, &item->st, item->crc, out_path, run->key->key_name);
+    }
+    if (!item->exit_code && !item->unchanged)
+        item->exit_code = finish_original(run, item);
+    if (!item->exit_code && run->journal)
+        journal_finished(run->journal, run->encr_flag, item->file);
+    set_error_msg(item->exit_code, item->error_msg);
+    item->duration = now_sec() - item->start;
+    log_item(run, item);
+
+    pthread_mutex_lock(&run->lock);
+    run->unchanged += item->unchanged;
+    item->done = 1;
+    while (run->next_print < run->next_seq && run->items[run->next_print % run->window].done) {
+        run->items[run->next_print % run->window].done = 0;
+        run->next_print++;
+    }
+    pthread_cond_broadcast(&run->slot_free);
+    pthread_mutex_unlock(&run->lock);
+}
+
+/**
+* @brief Funkcija koja proverava da li se fajl enkriptuje sa kontrolnim tackama (io/checkpoint.h).
+* Kontrolne tacke imaju smisla samo uz zurnal, jer se samo tada prekinuta obrada nastavlja; zurnal
+* se vodi samo na zahtev (-J ili --resume), pa podrazumevana obrada nema ni imenovan privremeni
+* izlaz ni fdatasync na svakih CHECKPOINT_INTERVAL bajtova.
+*/
+static int use_checkpoints(BatchRun *run, const char *file) {
+    struct stat st;
+
+    return run->encr_flag && run->ctx.cbc && run->journal &&
+           !stat(file, &st) && (uint64_t)st.st_size >= CHECKPOINT_MIN_SIZE;
+}
+
+/**
+* @brief Funkcija koja enkriptuje veliki fajl sa kontrolnim tackama.
+* @param[in] item Pokazivac na fajl
+* @return 0 ili kod greske
+*/
+static int run_checkpointed(BatchItem *item) {
+    BatchRun *run = item->run;
+    char out_path[BATCH_PATH_MAX + 4];
+    fileheader_t header;
+    int status;
+
+    encrypt_output_path(item, out_path, sizeof(out_path));
+    journal_started(run->journal, run->encr_flag, item->file, out_path);
+
+    status = checkpointEncryptFile(&run->ctx, item->file, out_path, run->resume, &item->bytes);
+    if (!status && run->manifest && !streamReadHeader(&run->ctx, out_path, &header))
+        item->crc = header.crc;
+    return status;
+}
+
+/**
+* @brief Funkcija koja u inkrementalnom modu proverava fajl u manifestu. Nepromenjen fajl se zavrsava
+* bez obrade, a promenjen fajl se predaje redu svog uredjaja (veliki fajl koji moze da se podeli na
+* delove funkciji process_split).
+* @param[in] item Pokazivac na fajl
+* @return 1 ukoliko je fajl predat ili zavrsen, 0 ukoliko ga treba obraditi u tekucoj niti
+*/
+static int check_manifest(BatchItem *item) {
+    BatchRun *run = item->run;
+    char out_path[BATCH_PATH_MAX + 4];
+
+    if (stat(item->file, &item->st) || !S_ISREG(item->st.st_mode))
+        return 0;
+    item->has_stat = 1;
+
+    encrypt_output_path(item, out_path, sizeof(out_path));
+    if (manifest_unchanged(run->manifest, item->file, &item->st, out_path, run->key->key_name)) {
+        item->unchanged = 1;
+        complete_item(item);
+        return 1;
+    }
+
+    if (run->devices)
+        item->queue = devq_get(run->devices, item->st.st_dev, run->has_out_dev ? run->out_dev : item->st.st_dev);
+
+    if (item->st.st_size >= SPLIT_FILE_LIMIT && cipherIsParallel(&run->ctx, run->encr_flag)) {
+        submit_task(run, item->queue, process_split, item);
+        return 1;
+    }
+    if (item->queue) {
+        submit_task(run, item->queue, process_item, item);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+* @brief Funkcija koja obradjuje ceo fajl u tekucoj niti.
+* @param[in] item Pokazivac na fajl
+*/
+static void run_item(BatchItem *item) {
+    BatchRun *run = item->run;
+    const char *out = item->out[0] ? item->out : NULL;
+    streamjob_t job;
+    uc iv[CIPHER_BLOCK_MAX];
+    uint32_t crc = ~0U;
+    int status;
+
+    item->start = now_sec();
+    if (run->manifest && !run->ctx_status && !item->has_stat && check_manifest(item))
+        return;
+
+    if (run->ctx_status)
+        status = run->ctx_status;
+    else if (run->in_place) {
+        /// izlaz je sam ulaz, pa ga nastavak prekinute obrade ne brise
+        if (run->journal)
+            journal_started(run->journal, run->encr_flag, item->file, item->file);
+        if (run->encr_flag)
+            item->exit_code = inplaceEncryptFile(&run->ctx, item->file, &item->bytes);
+        else
+            item->exit_code = inplaceDecryptFile(&run->ctx, item->file, &item->bytes);
+        complete_item(item);
+        return;
+    }
+    else if (use_checkpoints(run, item->file)) {
+        item->exit_code = run_checkpointed(item);
+        complete_item(item);
+        return;
+    }
+    else if (run->encr_flag)
+        status = streamEncryptOpen(&job, &run->ctx, item->file, out);
+    else
+        status = streamDecryptOpen(&job, &run->ctx, item->file, out);
+
+    if (!status) {
+        item->bytes = job.length;
+        if (run->journal)
+            journal_started(run->journal, run->encr_flag, item->file, job.outPath);
+
+        if (run->encr_flag) {
+            memcpy(iv, job.header.IV, run->ctx.blockSize);
+            status = streamEncryptRange(&job, 0, job.blocks, iv, &crc);
+            status = streamEncryptClose(&job, crc, status);
+            item->crc = crc;
+        }
+        else {
+            status = streamDecryptRange(&job, 0, job.blocks, &crc);
+            status = streamDecryptClose(&job, crc, status);
+        }
+    }
+
+    item->exit_code = status;
+    complete_item(item);
+}
+
+/**
+* @brief Funkcija koju izvrsava radna nit za jedan fajl.
+* @param[in] arg Pokazivac na BatchItem
+*/
+static void process_item(void *arg) {
+    run_item((BatchItem*)arg);
+}
+
+/**
+* @brief Funkcija koja belezi u zurnalu izlaz malog fajla (smallstartfunc_t).
+* @param[in] arg Pokazivac na niz BatchItem pokazivaca grupe
+* @param[in] index Redni broj fajla u nizu
+* @param[in] out_path Putanja izlaza
+*/
+static void small_started(void *arg, int index, const char *out_path) {
+    BatchItem *item = ((BatchItem**)arg)[index];
+
+    journal_started(item->run->journal, item->run->encr_flag, item->file, out_path);
+}
+
+/**
+* @brief Funkcija koja obradjuje grupu malih fajlova preko io/smallfile.h. Fajlovi koji ne mogu tim
+* putem se obradjuju pojedinacno.
+* @param[in] group Pokazivac na grupu
+*/
+static void run_small_group(BatchGroup *group) {
+    BatchRun *run = group->items[0]->run;
+    smallfile_t files[GROUP_MAX_FILES];
+    BatchItem *items[GROUP_MAX_FILES], *item;
+    int i, n = 0;
+
+    for (i = 0; i < group->len; i++) {
+        item = group->items[i];
+        item->start = now_sec();
+        /// u inkrementalnom modu velicina postaje poznata tek posle provere manifesta
+        if (run->manifest && !item->has_stat && check_manifest(item))
+            continue;
+        if (run->manifest && (!item->has_stat || item->st.st_size >= SMALL_FILE_LIMIT)) {
+            run_item(item);
+            continue;
+        }
+
+        files[n].inPath = item->file;
+        files[n].outArg = item->out[0] ? item->out : NULL;
+        items[n++] = item;
+    }
+
+    if (!n)
+        return;
+    if (smallProcessFiles(&run->ctx, run->encr_flag, files, n, run->journal ? small_started : NULL, items)) {
+        for (i = 0; i < n; i++)
+            run_item(items[i]);
+        return;
+    }
+
+    for (i = 0; i < n; i++) {
+        if (files[i].status == SMALLFILE_FALLBACK) {
+            run_item(items[i]);
+            continue;
+        }
+        items[i]->exit_code = files[i].status;
+        items[i]->bytes = files[i].length;
+        items[i]->crc = files[i].crc;
+        complete_item(items[i]);
+    }
+}
+
+/**
+* @brief Funkcija koju izvrsava radna nit za grupu malih fajlova.
+* @param[in] arg Pokazivac na BatchGroup
+*/
+static void process_group(void *arg) {
+    BatchGroup *group = (BatchGroup*)arg;
+    BatchRun *run = group->items[0]->run;
+    int i;
+
+    if (run->small_files && !run->ctx_status)
+        run_small_group(group);
+    else
+        for (i = 0; i < group->len; i++)
+            run_item(group->items[i]);
+    free(group);
+}
+
+/**
+* @brief Funkcija koja zavrsava podeljeni fajl kada su obradjeni svi delovi.
+* @param[in] split Pokazivac na podeljeni fajl
+*/
+static void finish_split(SplitFile *split) {
+    BatchRun *run = split->item->run;
+    uint64_t chunk_len = split->chunk_blocks * run->ctx.blockSize, len;
+    uint32_t crc = split->crcs[0];
+    int status = atomic_load(&split->status);
+    long i;
+
+    for (i = 1; i < split->n_chunks && !status && i * chunk_len < split->job.length; i++) {
+        len = split->job.length - i * chunk_len;
+        crc = crc32Combine(crc, split->crcs[i], len < chunk_len ? len : chunk_len);
+    }
+
+    split->item->crc = crc;
+    if (run->encr_flag)
+        split->item->exit_code = streamEncryptClose(&split->job, crc, status);
+    else
+        split->item->exit_code = streamDecryptClose(&split->job, crc, status);
+
+    complete_item(split->item);
+    free(split->crcs);
+    free(split->chunks);
+    free(split);
+}
+
+/**
+* @brief Funkcija koju izvrsava radna nit za jedan deo velikog fajla.
+* @param[in] arg Pokazivac na SplitChunk
+*/
+static void process_chunk(void *arg) {
+    SplitChunk *chunk = (SplitChunk*)arg;
+    SplitFile *split = chunk->split;
+    uint64_t first = chunk->index * split->chunk_blocks, count = split->chunk_blocks;
+    int status = 0;
+
+    if (first + count > split->job.blocks)
+        count = split->job.blocks - first;
+
+    if (!atomic_load(&split->status)) {
+        if (split->item->run->encr_flag)
+            status = streamEncryptRange(&split->job, first, count, NULL, &split->crcs[chunk->index]);
+        else
+            status = streamDecryptRange(&split->job, first, count, &split->crcs[chunk->index]);
+        if (status)
+            atomic_store(&split->status, status);
+    }
+
+    if (atomic_fetch_sub(&split->remaining, 1) == 1)
+        finish_split(split);
+}
+
+/**
+* @brief Funkcija koju izvrsava radna nit za veliki fajl: otvara ga i zadaje njegove delove.
+* @param[in] arg Pokazivac na BatchItem
+*/
+static void process_split(void *arg) {
+    BatchItem *item = (BatchItem*)arg;
+    BatchRun *run = item->run;
+    SplitFile *split;
+    int status;
+    long i;
+
+    split = (SplitFile*) calloc(1, sizeof(SplitFile));
+    ALLOC_CHECK(split);
+    split->item = item;
+    item->start = now_sec();
+
+    if (run->encr_flag)
+        status = streamEncryptOpen(&split->job, &run->ctx, item->file, item->out[0] ? item->out : NULL);
+    else
+        status = streamDecryptOpen(&split->job, &run->ctx, item->file, item->out[0] ? item->out : NULL);
+
+    if (status || !split->job.blocks) {
+        if (!status)
+            status = run->encr_flag ? streamEncryptClose(&split->job, ~0U, 0)
+                                    : streamDecryptClose(&split->job, ~0U, 0);
+        item->exit_code = status;
+        complete_item(item);
+        free(split);
+        return;
+    }
+
+    item->bytes = split->job.length;
+    if (run->journal)
+        journal_started(run->journal, run->encr_flag, item->file, split->job.outPath);
+    split->chunk_blocks = SPLIT_CHUNK_LEN / run->ctx.blockSize;
+    split->n_chunks = (split->job.blocks + split->chunk_blocks - 1) / split->chunk_blocks;
+    split->crcs = (uint32_t*) malloc(sizeof(uint32_t) * split->n_chunks);
+    split->chunks = (SplitChunk*) malloc(sizeof(SplitChunk) * split->n_chunks);
+    ALLOC_CHECK(split->crcs);
+    ALLOC_CHECK(split->chunks);
+    atomic_init(&split->remaining, split->n_chunks);
+    atomic_init(&split->status, 0);
+
+    for (i = 0; i < split->n_chunks; i++) {
+        split->chunks[i].split = split;
+        split->chunks[i].index = i;
+    }
+    for (i = split->n_chunks - 1; i >= 0; i--)
+        submit_task(run, item->queue, process_chunk, &split->chunks[i]);
+}
+
+/**
+* @brief Funkcija koja vraca grupu koja se puni za red uredjaja i pravi je ukoliko ne postoji.
+* Poziva se dok je run->lock zakljucan.
+* @param[in] run Pokazivac na stanje obrade
+* @param[in] queue Red uredjaja, NULL za skup niti
+* @return Pokazivac na grupu
+*/
+static DeviceGroup* get_device_group(BatchRun *run, DevQueue *queue) {
+    DeviceGroup *dg;
+
+    for (dg = run->groups; dg; dg = dg->next)
+        if (dg->queue == queue)
+            return dg;
+
+    dg = (DeviceGroup*) calloc(1, sizeof(DeviceGroup));
+    ALLOC_CHECK(dg);
+    dg->queue = queue;
+    dg->next = run->groups;
+    run->groups = dg;
+    return dg;
+}
+
+/**
+* @brief Funkcija koja preuzima grupu malih fajlova koja se puni. Poziva se dok je run->lock zakljucan,
+* a preuzetu grupu treba zadati funkcijom submit_group posle otkljucavanja.
+* @param[in] run Pokazivac na stanje obrade
+* @param[in] dg Grupa koju treba preuzeti, NULL za bilo koju neprazniu
+* @return Pokazivac na grupu, NULL ukoliko je grupa prazna
+*/
+static BatchGroup* take_group(BatchRun *run, DeviceGroup *dg) {
+    BatchGroup *group;
+
+    if (!dg)
+        for (dg = run->groups; dg && !dg->len; dg = dg->next)
+            ;
+    if (!dg || !dg->len)
+        return NULL;
+
+    group = (BatchGroup*) malloc(sizeof(BatchGroup));
+    ALLOC_CHECK(group);
+    group->queue = dg->queue;
+    group->len = dg->len;
+    memcpy(group->items, dg->items, sizeof(BatchItem*) * dg->len);
+    dg->len = 0;
+    dg->bytes = 0;
+    return group;
+}
+
+/**
+* @brief Funkcija koja zadaje zadatak u red uredjaja ili, ukoliko red nije zadat, direktno skupu niti.
+* @param[in] run Pokazivac na stanje obrade
+* @param[in] queue Red uredjaja, moze biti NULL
+* @param[in] func Funkcija zadatka
+* @param[in] arg Argument funkcije
+*/
+static void submit_task(BatchRun *run, DevQueue *queue, TaskFunc func, void *arg) {
+    if (queue)
+        devq_submit(queue, func, arg);
+    else
+        pool_submit(run->pool, func, arg);
+}
+
+/**
+* @brief Funkcija koja zadaje preuzetu grupu malih fajlova.
+* @param[in] run Pokazivac na stanje obrade
+* @param[in] group Pokazivac na grupu, moze biti NULL
+*/
+static void submit_group(BatchRun *run, BatchGroup *group) {
+    if (group)
+        submit_task(run, group->queue, process_group, group);
+}
+
+/**
+* @brief Funkcija koja dodaje mali fajl u grupu koja se puni za njegov red i zadaje grupu kada se napuni.
+* @param[in] run Pokazivac na stanje obrade
+* @param[in] item Pokazivac na fajl
+* @param[in] size Velicina fajla, 0 ukoliko nije poznata
+*/
+static void add_to_group(BatchRun *run, BatchItem *item, long size) {
+    DeviceGroup *dg;
+    BatchGroup *group;
+
+    pthread_mutex_lock(&run->lock);
+    dg = get_device_group(run, item->queue);
+    dg->items[dg->len++] = item;
+    dg->bytes += size;
+    group = dg->len == GROUP_MAX_FILES || dg->bytes >= GROUP_MAX_BYTES ? take_group(run, dg) : NULL;
+    pthread_mutex_unlock(&run->lock);
+    submit_group(run, group);
+}
+
+/*********************** EXTERNAL FUNCTIONS ***********************/
+void init_batch_options(BatchOptions *opts) {
+    memset(opts, 0, sizeof(*opts));
+    opts->jobs = DEFAULT_JOBS;
+}
+
+BatchRun* batch_begin(Key *key, int encr_flag, FILE *log, BatchOptions *opts) {
+    BatchRun *run = (BatchRun*) calloc(1, sizeof(BatchRun));
+    BatchOptions default_opts;
+    struct stat st;
+    int jobs;
+    ALLOC_CHECK(run);
+
+    if (!opts) {
+        init_batch_options(&default_opts);
+        opts = &default_opts;
+    }
+    jobs = opts->jobs > 0 ? opts->jobs : pool_cpu_count();
+
+    run->key = key;
+    run->encr_flag = encr_flag;
+    run->after_success = opts->after_success;
+    run->move_dir = opts->move_dir;
+    run->log = log;
+    run->window = jobs * BATCH_WINDOW_PER_JOB;
+    run->items = (BatchItem*) calloc(run->window, sizeof(BatchItem));
+    ALLOC_CHECK(run->items);
+
+    run->algo = select_algorithm(key);
+    run->ctx_status = cipherInit(&run->ctx, run->algo, key->key[0], key->key[1], key->key[2]);
+    if (log)
+        run->sink = log_open(log, opts->log_format, 0);
+    if (opts->journal_path)
+        run->journal = journal_open(opts->journal_path, opts->resume);
+    run->resume = opts->resume;
+    run->small_files = opts->io_engine == STREAM_ENGINE_URING && !opts->in_place;
+    run->in_place = opts->in_place;
+    if (opts->manifest_path && encr_flag)
+        run->manifest = manifest_open(opts->manifest_path);
+
+    pthread_mutex_init(&run->lock, NULL);
+    pthread_cond_init(&run->slot_free, NULL);
+
+    run->pool = pool_create(jobs, run->window);
+    if (pool_workers(run->pool))
+        run->devices = devq_create(run->pool, opts->device_jobs);
+    if (opts->out_root && !stat(opts->out_root, &st)) {
+        run->has_out_dev = 1;
+        run->out_dev = st.st_dev;
+    }
+    return run;
+}
+
+void batch_submit(BatchRun *run, const char *file_path, const char *out_path) {
+    BatchItem *item;
+    BatchGroup *group;
+    struct stat st;
+
+    if (run->journal && journal_is_done(run->journal, run->encr_flag, file_path))
+        return;
+
+    pthread_mutex_lock(&run->lock);
+    while (run->next_seq - run->next_print >= run->window) {
+        if ((group = take_group(run, NULL))) {
+            pthread_mutex_unlock(&run->lock);
+            submit_group(run, group);
+            pthread_mutex_lock(&run->lock);
+            continue;
+        }
+        pthread_cond_wait(&run->slot_free, &run->lock);
+    }
+
+    item = &run->items[run->next_seq % run->window];
+    item->run = run;
+    item->seq = run->next_seq++;
+    item->done = 0;
+    item->exit_code = 0;
+    item->bytes = 0;
+    item->error_msg[0] = '\0';
+    item->has_stat = 0;
+    item->unchanged = 0;
+    item->crc = ~0U;
+    item->queue = NULL;
+    snprintf(item->file, sizeof(item->file), "%s", file_path);
+    snprintf(item->out, sizeof(item->out), "%s", out_path ? out_path : "");
+    pthread_mutex_unlock(&run->lock);
+
+    /// bez radnih niti se grupisu samo mali fajlovi za io/smallfile.h; fajl u mestu se ne deli na delove
+    if ((!pool_workers(run->pool) && !run->small_files) || run->ctx_status || run->in_place) {
+        pool_submit(run->pool, process_item, item);
+        return;
+    }
+
+    /// u inkrementalnom modu stat i provera manifesta se rade u radnim nitima, pa se grupise po broju fajlova
+    if (run->manifest) {
+        add_to_group(run, item, 0);
+        return;
+    }
+
+    if (stat(file_path, &st) || !S_ISREG(st.st_mode)) {
+        pool_submit(run->pool, process_item, item);
+        return;
+    }
+
+    if (run->devices)
+        item->queue = devq_get(run->devices, st.st_dev, run->has_out_dev ? run->out_dev : st.st_dev);
+    if (st.st_size < SMALL_FILE_LIMIT)
+        add_to_group(run, item, st.st_size);
+    else if (!pool_workers(run->pool))
+        pool_submit(run->pool, process_item, item);
+    else if (st.st_size >= SPLIT_FILE_LIMIT && cipherIsParallel(&run->ctx, run->encr_flag))
+        submit_task(run, item->queue, process_split, item);
+    else
+        submit_task(run, item->queue, process_item, item);
+}
+
+void batch_flush(BatchRun *run) {
+    BatchGroup *group;
+
+    do {
+        pthread_mutex_lock(&run->lock);
+        group = take_group(run, NULL);
+        pthread_mutex_unlock(&run->lock);
+        submit_group(run, group);
+    } while (group);
+}
+
+void batch_end(BatchRun *run) {
+    PoolStats stats;
+    LogRecord rec;
+    DeviceGroup *dg;
+    long seq;
+
+    batch_flush(run);
+    pool_destroy(run->pool, &stats);
+    if (run->devices)
+        devq_destroy(run->devices);
+    while ((dg = run->groups)) {
+        run->groups = dg->next;
+        free(dg);
+    }
+
+    if (run->manifest)
+        manifest_close(run->manifest);
+
+    if (run->sink) {
+        seq = run->next_seq;
+        if (run->manifest) {
+            memset(&rec, 0, sizeof(rec));
+            rec.type = LOG_INCREMENTAL;
+            rec.seq = seq++;
+            rec.unchanged = run->unchanged;
+            log_push(run->sink, &rec);
+        }
+        if (stats.n_workers) {
+            memset(&rec, 0, sizeof(rec));
+            rec.type = LOG_SCHEDULER;
+            rec.seq = seq;
+            rec.workers = stats.n_workers;
+            rec.tasks = stats.tasks;
+            rec.steals = stats.steals;
+            rec.idle_sec = stats.idle_sec;
+            log_push(run->sink, &rec);
+        }
+        log_close(run->sink);
+        fflush(run->log);
+    }
+
+    /// poslednja grupa se spusta na disk; zurnal zadrzava zapise D njenih fajlova do tada
+    streamSyncFlush();
+    if (run->journal)
+        journal_close(run->journal);
+    if (!run->ctx_status)
+        cipherFree(&run->ctx);
+    pthread_mutex_destroy(&run->lock);
+    pthread_cond_destroy(&run->slot_free);
+    free(run->items);
+    free(run);
+}
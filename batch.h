@@ -0,0 +1,216 @@
+/**
+* @file
+* @brief Zaglavlje za paralelnu enkripciju/dekripciju vise fajlova. Fajlovi se zadaju jedan po jedan
+* funkcijom batch_submit, obradjuju se u skupu radnih niti, a poruke o ishodu se ispisuju u log
+* redosledom kojim su fajlovi zadati.
+* @details Mali fajlovi se grupisu tako da jedan zadatak obradi vise njih, a veliki fajlovi kod kojih
+* je blokove moguce obradjivati nezavisno (ECB, CBC dekripcija) se dele na delove koje radne niti
+* medjusobno kradu. Zadaci se predaju redovima po uredjaju (devq.h), a mali fajlovi se grupisu
+* posebno za svaki red. Na kraju obrade u log se ispisuje statistika rada niti.
+*/
+
+#ifndef _BATCH_H
+#define _BATCH_H
+
+#include "keys.h"
+#include "pool.h"
+#include "devq.h"
+#include "cmd_line.h"
+#include "cipher/cipher.h"
+#include "io/throttle.h"
+#include "io/stream.h"
+#include "walker.h"
+#include "log_ring.h"
+#include "journal.h"
+#include "manifest.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+/**
+* @brief Podrazumevani broj radnih niti (1 znaci da se fajlovi obradjuju redom, kao ranije).
+*/
+#define DEFAULT_JOBS 1
+
+/**
+* @brief Broj zadatih a jos neispisanih fajlova po radnoj niti. Ogranicava memoriju potrebnu
+* za cuvanje rezultata koji cekaju da budu ispisani po redu.
+*/
+#define BATCH_WINDOW_PER_JOB 64
+
+/**
+* @brief Fajlovi manji od ove velicine (u bajtovima) se grupisu. Ne sme biti vece od SMALLFILE_MAX_BYTES.
+*/
+#define SMALL_FILE_LIMIT (64 * 1024)
+
+/**
+* @brief Najveci broj fajlova u jednoj grupi. Ne sme biti vece od SMALLFILE_MAX_FILES.
+*/
+#define GROUP_MAX_FILES 32
+
+/**
+* @brief Grupa se zadaje kada ukupna velicina njenih fajlova dostigne ovu vrednost (u bajtovima).
+*/
+#define GROUP_MAX_BYTES (1024 * 1024)
+
+/**
+* @brief Fajlovi od ove velicine (u bajtovima) navise se dele na delove.
+*/
+#define SPLIT_FILE_LIMIT (64 * 1024 * 1024)
+
+/**
+* @brief Velicina jednog dela velikog fajla u bajtovima (umnozak svih velicina bloka).
+*/
+#define SPLIT_CHUNK_LEN (8 * 1024 * 1024)
+
+/**
+* @brief Sta uraditi sa originalnim fajlom posle uspesne obrade.
+*/
+typedef enum AfterSuccess {
+    AFTER_KEEP,     /**< Original ostaje gde jeste */
+    AFTER_DELETE,   /**< Original se brise (-rm) */
+    AFTER_MOVE      /**< Original se premesta u move_dir (-mv), na istom fajl sistemu */
+} AfterSuccess;
+
+/**
+* @brief Maksimalna duzina putanje fajla u obradi.
+*/
+#define BATCH_PATH_MAX 4096
+
+/**
+* @brief Opcije za obradu vise fajlova.
+*/
+typedef struct BatchOptions {
+    int jobs;
+    int n_include, n_exclude;           /**< Obrasci za obilazak stabla (-i/-x) */
+    char *include[WALK_MAX_GLOBS];
+    char *exclude[WALK_MAX_GLOBS];
+    char *out_root;                     /**< Izlazni koren za obilazak stabla (-o), NULL za isti direktorijum */
+    LogFormat log_format;               /**< Oblik zapisa u logu (-f text/json) */
+    AfterSuccess after_success;
+    char *move_dir;
+    char *journal_path;                 /**< Zurnal za nastavak prekinute obrade (journal.h), NULL bez zurnala */
+    int resume;                         /**< Preskacu se fajlovi koji su u zurnalu zavrseni (--resume) */
+    char *manifest_path;                /**< Manifest za inkrementalnu enkripciju (manifest.h, -u), NULL bez njega */
+    double limits[THROTTLE_KINDS];      /**< Ogranicenja iz io/throttle.h (MB/s za citanje i pisanje, fajlova/s), 0 bez */
+    char *throttle_file;                /**< Kontrolni fajl za promenu ogranicenja tokom rada (-tc) */
+    int device_jobs;                    /**< Ogranicenje istovremenih zadataka po uredjaju (-dj), 0 prema vrsti (devq.h) */
+    int physical_order;                 /**< -[e/d][m/r] obradjuju fajlove redom na disku (layout.h, --physical) */
+    int prefetch;                       /**< -[e/d][m/r] unapred citaju sledece fajlove (prefetch.h, --prefetch) */
+    streamengine_t io_engine;           /**< Nacin prenosa podataka iz io/stream.h (-io) */
+    streamcache_t cache_mode;           /**< Odnos prema kesu stranica iz io/stream.h (-pc) */
+    streamsync_t sync_mode;             /**< Trajnost izlaza iz io/stream.h (-fs) */
+    long sync_files;                    /**< Broj izlaza u grupi uz -fs group, 0 za podrazumevani */
+    double sync_mb;                     /**< MB izlaza u grupi uz -fs group, 0 za podrazumevani */
+    cipherbackend_t cipher_backend;     /**< Implementacija algoritama iz cipher/cipher.h (-ce) */
+    int in_place;                       /**< Fajlovi se prepisuju rezultatom preko io/inplace.h (--in-place) */
+    int sparse;                         /**< Enkripcija cuva rupe ulaza (io/stream.h, --sparse) */
+} BatchOptions;
+
+/**
+* @brief Stanje jednog fajla u obradi. Svaki fajl ima svoj bafer za poruku o gresci,
+* tako da radne niti ne dele bafere.
+*/
+typedef struct BatchItem {
+    struct BatchRun *run;
+    long seq;
+    int done;
+    int exit_code;
+    uint64_t bytes;
+    double start, duration;
+    char file[BATCH_PATH_MAX];
+    char out[BATCH_PATH_MAX];   /**< Putanja izlaza (io/stream.h), prazan string za podrazumevanu */
+    char error_msg[MAX_STR_LEN];
+
+    struct stat st;             /**< Stanje ulaza pre obrade, samo u inkrementalnom modu */
+    int has_stat;
+    int unchanged;              /**< Fajl je preskocen jer je nepromenjen (manifest.h) */
+    uint32_t crc;               /**< CRC registar originala posle uspesne enkripcije */
+    DevQueue *queue;            /**< Red uredjaja kome se predaju zadaci fajla, NULL za skup niti */
+} BatchItem;
+
+/**
+* @brief Grupa malih fajlova sa istog uredjaja koja se jos puni.
+*/
+typedef struct DeviceGroup {
+    DevQueue *queue;
+    BatchItem *items[GROUP_MAX_FILES];
+    int len;
+    long bytes;
+    struct DeviceGroup *next;
+} DeviceGroup;
+
+/**
+* @brief Stanje jedne obrade vise fajlova.
+*/
+typedef struct BatchRun {
+    Key *key;
+    int encr_flag;
+    AfterSuccess after_success;
+    char *move_dir;
+    FILE *log;
+    LogSink *sink;
+    ThreadPool *pool;
+    Algorithm algo;
+    cipherctx_t ctx;
+    int ctx_status;     /**< Rezultat cipherInit; ukoliko nije 0 svaki fajl zavrsava sa ovom greskom */
+    Journal *journal;   /**< NULL ukoliko se zurnal ne vodi */
+    int resume;         /**< Veliki CBC fajlovi se nastavljaju od kontrolne tacke (io/checkpoint.h) */
+    Manifest *manifest; /**< NULL ukoliko enkripcija nije inkrementalna */
+    long unchanged;     /**< Broj preskocenih nepromenjenih fajlova */
+    int small_files;    /**< Grupe malih fajlova se obradjuju preko io/smallfile.h (-io uring) */
+    int in_place;       /**< Fajlovi se obradjuju u mestu, ceo fajl u jednoj niti (io/inplace.h) */
+
+    BatchItem *items;
+    int window;
+    long next_seq, next_print;
+
+    DevQueues *devices; /**< NULL ukoliko se zadaci ne rasporedjuju po uredjajima */
+    int has_out_dev;
+    dev_t out_dev;      /**< Uredjaj izlaznog korena (-o) */
+    DeviceGroup *groups;
+
+    pthread_mutex_t lock;
+    pthread_cond_t slot_free;
+} BatchRun;
+
+/**
+* @brief Funkcija koja postavlja podrazumevane vrednosti opcija.
+* @param[out] opts Pokazivac na opcije
+*/
+void init_batch_options(BatchOptions *opts);
+
+/**
+* @brief Funkcija koja zapocinje obradu vise fajlova.
+* @param[in] key Pokazivac na kljuc koji treba koristiti
+* @param[in] encr_flag 1 za enkripciju, 0 za dekripciju
+* @param[out] log Pokazivac na fajl u koji se ispisuju poruke o ishodu (moze biti NULL)
+* @param[in] opts Opcije obrade, NULL za podrazumevane
+* @return Pokazivac na stanje obrade
+*/
+BatchRun* batch_begin(Key *key, int encr_flag, FILE *log, BatchOptions *opts);
+
+/**
+* @brief Funkcija koja zadaje jedan fajl za obradu. Blokira ukoliko previse fajlova ceka na ispis.
+* Moze se pozivati istovremeno iz vise niti.
+* @param[in] run Pokazivac na stanje obrade
+* @param[in] file_path Putanja do fajla
+* @param[in] out_path Putanja izlaza, NULL za podrazumevanu (za dekripciju moze biti direktorijum sa '/' na kraju)
+*/
+void batch_submit(BatchRun *run, const char *file_path, const char *out_path);
+
+/**
+* @brief Funkcija koja odmah zadaje nepotpunu grupu malih fajlova, umesto da ceka da se grupa popuni.
+* @param[in] run Pokazivac na stanje obrade
+*/
+void batch_flush(BatchRun *run);
+
+/**
+* @brief Funkcija koja ceka kraj obrade svih zadatih fajlova, ispisuje statistiku rada niti u log
+* i oslobadja stanje obrade.
+* @param[in] run Pokazivac na stanje obrade
+*/
+void batch_end(BatchRun *run);
+
+#endif // _BATCH_H
@@ -0,0 +1,161 @@
+/**
+* @file
+* @brief Omotac za kriptografski API jezgra Linux-a (AF_ALG).
+*/
+
+/// accept4
+#define _GNU_SOURCE
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "afalg.h"
+
+#ifdef __linux__
+
+#include <sys/socket.h>
+#include <linux/if_alg.h>
+
+#ifndef AF_ALG
+#define AF_ALG 38
+#endif
+#ifndef SOL_ALG
+#define SOL_ALG 279
+#endif
+
+/**
+* @brief Funkcija koja vraca naziv algoritma u jezgru.
+* @private
+*/
+static const char* kernelName(Algorithm algo)
+{
+    switch (algo)
+    {
+        case des_ecb:    return "ecb(des)";
+        case des_cbc:    return "cbc(des)";
+        case tdes_ecb:   return "ecb(des3_ede)";
+        case tdes_cbc:   return "cbc(des3_ede)";
+        case aes128_ecb:
+        case aes192_ecb:
+        case aes256_ecb: return "ecb(aes)";
+        case aes128_cbc:
+        case aes192_cbc:
+        case aes256_cbc: return "cbc(aes)";
+        default:         return NULL;
+    }
+}
+
+int afalgOpen(Algorithm algo, const uc *key, int keyLen)
+{
+    struct sockaddr_alg sa;
+    const char *name = kernelName(algo);
+    int fd;
+
+    if (!name)
+        return -1;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.salg_family = AF_ALG;
+    strcpy((char*)sa.salg_type, "skcipher");
+    strcpy((char*)sa.salg_name, name);
+
+    if ((fd = socket(AF_ALG, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)) < 0)
+        return -1;
+    if (bind(fd, (struct sockaddr*)&sa, sizeof(sa)) || setsockopt(fd, SOL_ALG, ALG_SET_KEY, key, keyLen))
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void afalgClose(int fd)
+{
+    if (fd >= 0)
+        close(fd);
+}
+
+int afalgAccept(int fd)
+{
+    return accept4(fd, NULL, NULL, SOCK_CLOEXEC);
+}
+
+int afalgCrypt(int opFd, int encrypt, uc *buf, size_t len, const uc *iv, int ivLen)
+{
+    char control[CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(struct af_alg_iv) + AFALG_IV_MAX)];
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    struct af_alg_iv *algIv;
+    struct iovec iov;
+    size_t done = 0;
+    ssize_t n;
+
+    if (len > AFALG_REQUEST_MAX || ivLen > AFALG_IV_MAX)
+        return -1;
+
+    memset(control, 0, sizeof(control));
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = buf;
+    iov.iov_len = len;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int)) + (iv ? CMSG_SPACE(sizeof(struct af_alg_iv) + ivLen) : 0);
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_ALG;
+    cmsg->cmsg_type = ALG_SET_OP;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    *(int*)CMSG_DATA(cmsg) = encrypt ? ALG_OP_ENCRYPT : ALG_OP_DECRYPT;
+
+    if (iv)
+    {
+        cmsg = CMSG_NXTHDR(&msg, cmsg);
+        cmsg->cmsg_level = SOL_ALG;
+        cmsg->cmsg_type = ALG_SET_IV;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(struct af_alg_iv) + ivLen);
+        algIv = (struct af_alg_iv*)CMSG_DATA(cmsg);
+        algIv->ivlen = ivLen;
+        memcpy(algIv->iv, iv, ivLen);
+    }
+
+    do
+        n = sendmsg(opFd, &msg, 0);
+    while (n < 0 && errno == EINTR);
+    if (n != (ssize_t)len)
+        return -1;
+
+    /// jezgro vraca rezultat tek kada je ceo zahtev obradjen, pa se bafer ne menja pre toga
+    while (done < len)
+    {
+        n = read(opFd, buf + done, len - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        done += n;
+    }
+    return 0;
+}
+
+#else
+
+int afalgOpen(Algorithm algo, const uc *key, int keyLen)
+{
+    return -1;
+}
+
+void afalgClose(int fd)
+{
+}
+
+int afalgAccept(int fd)
+{
+    return -1;
+}
+
+int afalgCrypt(int opFd, int encrypt, uc *buf, size_t len, const uc *iv, int ivLen)
+{
+    return -1;
+}
+
+#endif
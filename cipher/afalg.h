@@ -0,0 +1,68 @@
+/**
+* @file
+* @brief Omotac za kriptografski API jezgra Linux-a (AF_ALG, skcipher).
+* @details Za kljuc se jednom pravi socket transformacije (bind na "ecb(aes)", "cbc(des3_ede)"...,
+* pa setsockopt ALG_SET_KEY). Jezgro pri tome samo bira implementaciju najveceg prioriteta koju ima
+* (npr. aesni_intel umesto aes-generic). Za obradu se sa accept pravi socket operacije, koji ne sme da
+* se koristi iz vise niti istovremeno; socket transformacije moze.
+*
+* Bafer se salje jednim sendmsg pozivom (operacija i IV su u kontrolnim porukama) i rezultat se cita
+* nazad u isti bafer, u delovima od najvise AFALG_REQUEST_MAX bajtova.
+*
+* Na sistemima bez AF_ALG-a (ili ukoliko jezgro nema algoritam) afalgOpen vraca -1, a pozivaoci
+* koriste ugradjene implementacije.
+*/
+
+#ifndef _AFALG_H_
+#define _AFALG_H_
+
+#include <stddef.h>
+#include "../global.h"
+#include "../encryption.h"
+
+/**
+* @brief Najveci broj bajtova jednog zahteva jezgru (ogranicen baferom socketa).
+*/
+#define AFALG_REQUEST_MAX (64 * 1024)
+
+/**
+* @brief Najveca duzina vektora ulancavanja.
+*/
+#define AFALG_IV_MAX 16
+
+/**
+* @brief Funkcija koja pravi socket transformacije za algoritam i postavlja kljuc.
+* @param[in] algo Algoritam.
+* @param[in] key Kljuc u obliku koji ocekuje jezgro (za DES sa bitovima parnosti, za tDES tri
+* takva kljuca jedan za drugim).
+* @param[in] keyLen Duzina kljuca u bajtovima.
+* @return Deskriptor socketa ili -1 ukoliko AF_ALG ili algoritam nisu dostupni.
+*/
+int  afalgOpen(Algorithm algo, const uc *key, int keyLen);
+
+/**
+* @brief Funkcija koja zatvara socket transformacije ili operacije.
+* @param[in] fd Deskriptor iz afalgOpen ili afalgAccept.
+*/
+void afalgClose(int fd);
+
+/**
+* @brief Funkcija koja pravi socket operacije za pozivajucu nit.
+* @param[in] fd Deskriptor iz afalgOpen.
+* @return Deskriptor socketa operacije ili -1.
+*/
+int  afalgAccept(int fd);
+
+/**
+* @brief Funkcija za enkripciju/dekripciju bafera u mestu preko socketa operacije.
+* @param[in] opFd Deskriptor iz afalgAccept.
+* @param[in] encrypt 1 za enkripciju, 0 za dekripciju.
+* @param[in,out] buf Bafer, duzina mora biti umnozak velicine bloka.
+* @param[in] len Duzina bafera, najvise AFALG_REQUEST_MAX.
+* @param[in] iv Vektor ulancavanja za CBC ili NULL za ECB.
+* @param[in] ivLen Duzina vektora ulancavanja.
+* @return 0 ili -1 (tada bafer nije izmenjen, a socket operacije vise ne treba koristiti).
+*/
+int  afalgCrypt(int opFd, int encrypt, uc *buf, size_t len, const uc *iv, int ivLen);
+
+#endif // _AFALG_H_
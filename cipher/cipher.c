@@ -0,0 +1,354 @@
+/**
+* @file
+* @brief Zajednicki interfejs za sve algoritme enkripcije na nivou bafera.
+*/
+
+#include <string.h>
+#include "cipher.h"
+#include "afalg.h"
+#include "evp.h"
+#include "../aes/aes.h"
+#include "../des/des.h"
+
+/**
+* @brief Velicina hedera bez IV-a (ime, duzina, CRC i pad).
+*/
+#define HEADER_BASE_SIZE (FILENAME_LEN_MAX + 16)
+
+/**
+* @brief Izabrana implementacija.
+*/
+static cipherbackend_t backend = CIPHER_BACKEND_BUILTIN;
+
+void cipherSetBackend(cipherbackend_t value)
+{
+    backend = value;
+}
+
+/**
+* @brief Funkcija koja enkriptuje jedan blok bez ulancavanja.
+* @private
+*/
+static void encryptBlockEcb(cipherctx_t *ctx, uc *block)
+{
+    switch (ctx->algo)
+    {
+        case des_ecb:
+        case des_cbc:
+            desEncodeBlock(block, ctx->subKeys[0], 0, block);
+            break;
+        case tdes_ecb:
+        case tdes_cbc:
+            tdesEncodeBlock(block, ctx->subKeys[0], ctx->subKeys[1], ctx->subKeys[2], 0, block);
+            break;
+        default:
+            encryptBlockRoundKeys(block, ctx->roundKeys, ctx->Nr);
+            break;
+    }
+}
+
+/**
+* @brief Funkcija koja dekriptuje jedan blok bez ulancavanja.
+* @private
+*/
+static void decryptBlockEcb(cipherctx_t *ctx, uc *block)
+{
+    switch (ctx->algo)
+    {
+        case des_ecb:
+        case des_cbc:
+            desEncodeBlock(block, ctx->subKeys[0], 1, block);
+            break;
+        case tdes_ecb:
+        case tdes_cbc:
+            tdesEncodeBlock(block, ctx->subKeys[0], ctx->subKeys[1], ctx->subKeys[2], 1, block);
+            break;
+        default:
+            decryptBlockRoundKeys(block, ctx->invRoundKeys, ctx->Nr);
+            break;
+    }
+}
+
+/**
+* @brief Funkcija koja priprema DES podkljuceve.
+* @private
+*/
+static uc** desSubKeys(uc *key)
+{
+    uc ekey[8];
+    desExpandKey(key, ekey);
+    return keyGenerate(ekey);
+}
+
+/**
+* @brief Funkcija koja transponuje AES blokove bafera. Ugradjeni AES puni stanje bloka po vrstama, a
+* standardni (i jezgro) po kolonama, pa je ugradjeni rezultat jednak transponovanom standardnom
+* rezultatu transponovanog bloka. Transponovanje je linearno, pa isto vazi i za CBC lanac.
+* @private
+*/
+static void transposeBlocks(uc *buf, size_t len)
+{
+    size_t off;
+    int r, c;
+    uc t;
+
+    for (off = 0; off < len; off += BLOCK_SIZE)
+        for (r = 0; r < 4; r++)
+            for (c = r + 1; c < 4; c++)
+            {
+                t = buf[off + 4 * r + c];
+                buf[off + 4 * r + c] = buf[off + 4 * c + r];
+                buf[off + 4 * c + r] = t;
+            }
+}
+
+/**
+* @brief Funkcija koja priprema izabranu implementaciju sa kljucem u standardnom obliku.
+* @private
+*/
+static void openBackend(cipherctx_t *ctx, int Nk, uc *key1, uc *key2, uc *key3)
+{
+    uc key[32];
+    int keyLen;
+
+    if (Nk)
+    {
+        keyLen = Nk * 4;
+        memcpy(key, key1, keyLen);
+    }
+    else if (ctx->subKeys[1])
+    {
+        keyLen = 24;
+        desExpandKey(key1, key);
+        desExpandKey(key2, key + 8);
+        desExpandKey(key3, key + 16);
+    }
+    else
+    {
+        keyLen = 8;
+        desExpandKey(key1, key);
+    }
+
+    if (backend == CIPHER_BACKEND_AFALG)
+        ctx->kernelFd = afalgOpen(ctx->algo, key, keyLen);
+    else if (backend == CIPHER_BACKEND_OPENSSL)
+    {
+        ctx->evp[0] = evpOpen(ctx->algo, key, 0);
+        ctx->evp[1] = evpOpen(ctx->algo, key, 1);
+        if (!ctx->evp[0] || !ctx->evp[1])
+        {
+            evpClose(ctx->evp[0]);
+            evpClose(ctx->evp[1]);
+            ctx->evp[0] = ctx->evp[1] = NULL;
+        }
+    }
+    memset(key, 0, sizeof(key));
+}
+
+/**
+* @brief Funkcija koja obradjuje pocetak bafera izabranom implementacijom: u jezgru u delovima od
+* AFALG_REQUEST_MAX bajtova, a u libcrypto odjednom.
+* @return Broj obradjenih bajtova; ostatak (bez druge implementacije ili posle greske) obradjuje
+* ugradjena implementacija, a iv tada sadrzi vektor ulancavanja za njega.
+* @private
+*/
+static size_t backendCrypt(cipherctx_t *ctx, int encrypt, uc *buf, size_t len, uc *iv)
+{
+    int bs = ctx->blockSize, aes = ctx->Nr != 0, opFd = -1, status;
+    uc chain[CIPHER_BLOCK_MAX], next[CIPHER_BLOCK_MAX];
+    size_t done, n, pieceMax = len;
+    uc *piece;
+
+    if (len < CIPHER_BACKEND_MIN || (ctx->kernelFd < 0 && !ctx->evp[encrypt]))
+        return 0;
+    if (ctx->kernelFd >= 0)
+    {
+        if ((opFd = afalgAccept(ctx->kernelFd)) < 0)
+            return 0;
+        pieceMax = AFALG_REQUEST_MAX;
+    }
+
+    if (ctx->cbc)
+    {
+        memcpy(chain, iv, bs);
+        if (aes)
+            transposeBlocks(chain, bs);
+    }
+
+    for (done = 0; done < len; done += n)
+    {
+        n = len - done < pieceMax ? len - done : pieceMax;
+        piece = buf + done;
+
+        if (aes)
+            transposeBlocks(piece, n);
+        if (ctx->cbc && !encrypt)
+            memcpy(next, piece + n - bs, bs);
+
+        if (opFd >= 0)
+            status = afalgCrypt(opFd, encrypt, piece, n, ctx->cbc ? chain : NULL, bs);
+        else
+            status = evpCrypt(ctx->evp[encrypt], piece, n, ctx->cbc ? chain : NULL);
+        if (status)
+        {
+            if (aes)
+                transposeBlocks(piece, n);
+            break;
+        }
+
+        if (ctx->cbc)
+            memcpy(chain, encrypt ? piece + n - bs : next, bs);
+        if (aes)
+            transposeBlocks(piece, n);
+    }
+    afalgClose(opFd);
+
+    if (ctx->cbc)
+    {
+        if (aes)
+            transposeBlocks(chain, bs);
+        memcpy(iv, chain, bs);
+    }
+    return done;
+}
+
+int cipherInit(cipherctx_t *ctx, Algorithm algo, uc *key1, uc *key2, uc *key3)
+{
+    int Nk = 0;
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->algo = algo;
+    ctx->kernelFd = -1;
+
+    switch (algo)
+    {
+        case des_ecb:
+        case des_cbc:
+            ctx->blockSize = 8;
+            ctx->subKeys[0] = desSubKeys(key1);
+            break;
+        case tdes_ecb:
+        case tdes_cbc:
+            ctx->blockSize = 8;
+            ctx->subKeys[0] = desSubKeys(key1);
+            ctx->subKeys[1] = desSubKeys(key2);
+            ctx->subKeys[2] = desSubKeys(key3);
+            break;
+        case aes128_ecb:
+        case aes128_cbc:
+            Nk = 4;
+            break;
+        case aes192_ecb:
+        case aes192_cbc:
+            Nk = 6;
+            break;
+        case aes256_ecb:
+        case aes256_cbc:
+            Nk = 8;
+            break;
+        default:
+            return UNKNOWN_ALG;
+    }
+
+    ctx->cbc = algo == des_cbc || algo == tdes_cbc || algo == aes128_cbc ||
+               algo == aes192_cbc || algo == aes256_cbc;
+
+    if (Nk)
+    {
+        ctx->blockSize = BLOCK_SIZE;
+        ctx->Nr = Nk + 6;
+        getRoundKeys(key1, ctx->roundKeys, Nk, REGULAR);
+        getRoundKeys(key1, ctx->invRoundKeys, Nk, INVERSE);
+        ctx->headerSize = sizeof(fileheader_t);
+    }
+    else
+        ctx->headerSize = HEADER_BASE_SIZE + (ctx->cbc ? ctx->blockSize : 0);
+
+    if (backend != CIPHER_BACKEND_BUILTIN)
+        openBackend(ctx, Nk, key1, key2, key3);
+
+    return 0;
+}
+
+void cipherFree(cipherctx_t *ctx)
+{
+    int i;
+    for (i = 0; i < 3; i++)
+        if (ctx->subKeys[i])
+            freeKeys(ctx->subKeys[i]);
+    afalgClose(ctx->kernelFd);
+    evpClose(ctx->evp[0]);
+    evpClose(ctx->evp[1]);
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->kernelFd = -1;
+}
+
+void cipherEncrypt(cipherctx_t *ctx, uc *buf, size_t len, uc *iv)
+{
+    int bs = ctx->blockSize, i;
+    uc *end = buf + len;
+
+    buf += backendCrypt(ctx, 1, buf, len, iv);
+
+    for (; buf < end; buf += bs)
+    {
+        if (ctx->cbc)
+            for (i = 0; i < bs; i++)
+                buf[i] ^= iv[i];
+
+        encryptBlockEcb(ctx, buf);
+
+        if (ctx->cbc)
+            memcpy(iv, buf, bs);
+    }
+}
+
+void cipherDecrypt(cipherctx_t *ctx, uc *buf, size_t len, uc *iv)
+{
+    int bs = ctx->blockSize, i;
+    uc *end = buf + len;
+    uc prev[CIPHER_BLOCK_MAX];
+
+    buf += backendCrypt(ctx, 0, buf, len, iv);
+
+    for (; buf < end; buf += bs)
+    {
+        if (ctx->cbc)
+            memcpy(prev, buf, bs);
+
+        decryptBlockEcb(ctx, buf);
+
+        if (ctx->cbc)
+        {
+            for (i = 0; i < bs; i++)
+                buf[i] ^= iv[i];
+            memcpy(iv, prev, bs);
+        }
+    }
+}
+
+int cipherIsParallel(cipherctx_t *ctx, int encrypt)
+{
+    return !ctx->cbc || !encrypt;
+}
+
+void cipherSealHeader(cipherctx_t *ctx, fileheader_t *header, uc *out)
+{
+    int i;
+
+    memcpy(out, header, ctx->headerSize);
+    for (i = 0; i < ctx->headerSize; i += ctx->blockSize)
+        encryptBlockEcb(ctx, out + i);
+}
+
+void cipherOpenHeader(cipherctx_t *ctx, const uc *in, fileheader_t *header)
+{
+    int i;
+
+    memset(header, 0, sizeof(*header));
+    memcpy(header, in, ctx->headerSize);
+    for (i = 0; i < ctx->headerSize; i += ctx->blockSize)
+        decryptBlockEcb(ctx, (uc*) header + i);
+
+    header->fileName[FILENAME_LEN_MAX - 1] = '\0';
+}
@@ -0,0 +1,129 @@
+/**
+* @file
+* @brief Zajednicki interfejs za sve algoritme enkripcije na nivou bafera.
+* @details Kontekst cuva vec pripremljene kljuceve runde (AES) odnosno podkljuceve (DES/tDES),
+* tako da se priprema kljuca radi jednom po kljucu, a ne jednom po fajlu. Kontekst se posle
+* inicijalizacije samo cita, pa ga vise niti moze koristiti istovremeno.
+*
+* Podaci se obradjuju ugradjenim implementacijama, kriptografskim API-jem jezgra (CIPHER_BACKEND_AFALG,
+* afalg.h) ili bibliotekom libcrypto (CIPHER_BACKEND_OPENSSL, evp.h, samo uz USE_OPENSSL). Druge
+* implementacije se koriste samo za bafere od najmanje CIPHER_BACKEND_MIN bajtova; ukoliko nisu
+* dostupne ili zahtev ne uspe, ostatak bafera obradjuje ugradjena implementacija, pa je rezultat
+* (kao i heder, koji se uvek sifruje ugradjenom) isti bajt za bajt.
+*/
+
+#ifndef _CIPHER_H_
+#define _CIPHER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../global.h"
+#include "../encryption.h"
+#include "../file_header/file_header.h"
+
+/**
+* @brief Najveca velicina bloka od svih podrzanih algoritama.
+*/
+#define CIPHER_BLOCK_MAX 16
+
+/**
+* @brief Najmanja duzina bafera koji se predaje drugoj implementaciji; kraci baferi (npr. poslednji
+* blok) se obradjuju ugradjenom.
+*/
+#define CIPHER_BACKEND_MIN 4096
+
+/**
+* @brief Implementacija kojom se obradjuju podaci.
+*/
+typedef enum
+{
+    CIPHER_BACKEND_BUILTIN, /**< Ugradjene implementacije (podrazumevano) */
+    CIPHER_BACKEND_AFALG,   /**< Kriptografski API jezgra Linux-a (AF_ALG) */
+    CIPHER_BACKEND_OPENSSL  /**< EVP interfejs biblioteke libcrypto (USE_OPENSSL) */
+} cipherbackend_t;
+
+/**
+* @brief Kontekst algoritma sa pripremljenim kljucevima.
+*/
+typedef struct
+{
+    Algorithm algo;
+    int blockSize;          /**< 8 za DES/tDES, 16 za AES */
+    int cbc;                /**< 1 za CBC mod, 0 za ECB */
+    int headerSize;         /**< Broj bajtova hedera na pocetku .dat fajla */
+    int Nr;                 /**< Broj rundi za AES */
+    uc roundKeys[15][16];
+    uc invRoundKeys[15][16];
+    uc **subKeys[3];        /**< Podkljucevi za DES (samo prvi) i tDES */
+    int kernelFd;           /**< Socket transformacije u jezgru (afalg.h) ili -1 */
+    void *evp[2];           /**< EVP konteksti za dekripciju i enkripciju (evp.h) ili NULL */
+} cipherctx_t;
+
+/**
+* @brief Funkcija koja bira implementaciju za kontekste koji se inicijalizuju posle poziva.
+* @param[in] value Implementacija.
+*/
+void cipherSetBackend(cipherbackend_t value);
+
+/**
+* @brief Funkcija za inicijalizaciju konteksta.
+* @param[out] ctx Kontekst koji se inicijalizuje.
+* @param[in] algo Algoritam.
+* @param[in] key1 Kljuc za sve algoritme.
+* @param[in] key2 Drugi kljuc u slucaju Triple-DES algoritma.
+* @param[in] key3 Treci kljuc u slucaju Triple-DES algoritma.
+* @return 0 ili UNKNOWN_ALG.
+*/
+int  cipherInit(cipherctx_t *ctx, Algorithm algo, uc *key1, uc *key2, uc *key3);
+
+/**
+* @brief Funkcija koja oslobadja memoriju konteksta.
+* @param[in] ctx Kontekst.
+*/
+void cipherFree(cipherctx_t *ctx);
+
+/**
+* @brief Funkcija za enkripciju bafera u mestu.
+* @param[in] ctx Kontekst.
+* @param[in,out] buf Bafer, duzina mora biti umnozak velicine bloka.
+* @param[in] len Duzina bafera.
+* @param[in,out] iv Vektor ulancavanja za CBC; posle poziva sadrzi poslednji sifrovani blok.
+* Za ECB se ignorise.
+*/
+void cipherEncrypt(cipherctx_t *ctx, uc *buf, size_t len, uc *iv);
+
+/**
+* @brief Funkcija za dekripciju bafera u mestu.
+* @param[in] ctx Kontekst.
+* @param[in,out] buf Bafer, duzina mora biti umnozak velicine bloka.
+* @param[in] len Duzina bafera.
+* @param[in,out] iv Vektor ulancavanja za CBC (sifrovani blok pre bafera); posle poziva
+* sadrzi poslednji sifrovani blok iz bafera. Za ECB se ignorise.
+*/
+void cipherDecrypt(cipherctx_t *ctx, uc *buf, size_t len, uc *iv);
+
+/**
+* @brief Funkcija koja proverava da li delovi fajla mogu da se obradjuju nezavisno.
+* @param[in] ctx Kontekst.
+* @param[in] encrypt 1 za enkripciju, 0 za dekripciju.
+* @return 1 za ECB i CBC dekripciju, 0 za CBC enkripciju.
+*/
+int  cipherIsParallel(cipherctx_t *ctx, int encrypt);
+
+/**
+* @brief Funkcija koja sifruje heder (uvek u ECB modu, kao i do sada).
+* @param[in] ctx Kontekst.
+* @param[in] header Heder fajla.
+* @param[out] out Bafer od ctx->headerSize bajtova.
+*/
+void cipherSealHeader(cipherctx_t *ctx, fileheader_t *header, uc *out);
+
+/**
+* @brief Funkcija koja desifruje heder.
+* @param[in] ctx Kontekst.
+* @param[in] in Bafer od ctx->headerSize bajtova.
+* @param[out] header Desifrovani heder.
+*/
+void cipherOpenHeader(cipherctx_t *ctx, const uc *in, fileheader_t *header);
+
+#endif // _CIPHER_H_
@@ -0,0 +1,129 @@
+/**
+* @file
+* @brief Omotac za EVP interfejs biblioteke libcrypto (OpenSSL).
+*/
+
+#include "evp.h"
+
+#ifdef USE_OPENSSL
+
+#include <limits.h>
+#include <pthread.h>
+#include <openssl/evp.h>
+#if OPENSSL_VERSION_MAJOR >= 3
+#include <openssl/provider.h>
+#endif
+
+/**
+* @brief Najveci broj bajtova jednog EVP_CipherUpdate poziva (duzina je int).
+*/
+#define UPDATE_MAX (1 << 30)
+
+static pthread_once_t providersOnce = PTHREAD_ONCE_INIT;
+
+/**
+* @brief Funkcija koja ucitava provajdere: "legacy" za DES i tDES i "default" za ostalo, jer se
+* on ne ucitava sam cim je neki provajder eksplicitno ucitan.
+* @private
+*/
+static void loadProviders(void)
+{
+#if OPENSSL_VERSION_MAJOR >= 3
+    OSSL_PROVIDER_load(NULL, "legacy");
+    OSSL_PROVIDER_load(NULL, "default");
+#endif
+}
+
+/**
+* @brief Funkcija koja vraca EVP algoritam.
+* @private
+*/
+static const EVP_CIPHER* evpCipher(Algorithm algo)
+{
+    switch (algo)
+    {
+        case des_ecb:    return EVP_des_ecb();
+        case des_cbc:    return EVP_des_cbc();
+        case tdes_ecb:   return EVP_des_ede3_ecb();
+        case tdes_cbc:   return EVP_des_ede3_cbc();
+        case aes128_ecb: return EVP_aes_128_ecb();
+        case aes128_cbc: return EVP_aes_128_cbc();
+        case aes192_ecb: return EVP_aes_192_ecb();
+        case aes192_cbc: return EVP_aes_192_cbc();
+        case aes256_ecb: return EVP_aes_256_ecb();
+        case aes256_cbc: return EVP_aes_256_cbc();
+        default:         return NULL;
+    }
+}
+
+void* evpOpen(Algorithm algo, const uc *key, int encrypt)
+{
+    const EVP_CIPHER *cipher;
+    EVP_CIPHER_CTX *evp;
+
+    pthread_once(&providersOnce, loadProviders);
+    if (!(cipher = evpCipher(algo)) || !(evp = EVP_CIPHER_CTX_new()))
+        return NULL;
+
+    /// dopuna je vec upisana u fajl (nule do punog bloka), pa je EVP ne dodaje
+    if (!EVP_CipherInit_ex(evp, cipher, NULL, key, NULL, encrypt) || !EVP_CIPHER_CTX_set_padding(evp, 0))
+    {
+        EVP_CIPHER_CTX_free(evp);
+        return NULL;
+    }
+    return evp;
+}
+
+void evpClose(void *evp)
+{
+    EVP_CIPHER_CTX_free((EVP_CIPHER_CTX*)evp);
+}
+
+int evpCrypt(void *evp, uc *buf, size_t len, const uc *iv)
+{
+    EVP_CIPHER_CTX *copy = EVP_CIPHER_CTX_new();
+    size_t done;
+    int n, outLen, status = -1;
+
+    if (!copy)
+        return -1;
+    if (EVP_CIPHER_CTX_copy(copy, (EVP_CIPHER_CTX*)evp) &&
+        (!iv || EVP_CipherInit_ex(copy, NULL, NULL, NULL, iv, -1)))
+    {
+        for (done = 0; done < len; done += n)
+        {
+            n = len - done < UPDATE_MAX ? (int)(len - done) : UPDATE_MAX;
+            if (!EVP_CipherUpdate(copy, buf + done, &outLen, buf + done, n) || outLen != n)
+                break;
+        }
+        status = done == len ? 0 : -1;
+    }
+    EVP_CIPHER_CTX_free(copy);
+    return status;
+}
+
+#else
+
+void* evpOpen(Algorithm algo, const uc *key, int encrypt)
+{
+    (void) algo;
+    (void) key;
+    (void) encrypt;
+    return NULL;
+}
+
+void evpClose(void *evp)
+{
+    (void) evp;
+}
+
+int evpCrypt(void *evp, uc *buf, size_t len, const uc *iv)
+{
+    (void) evp;
+    (void) buf;
+    (void) len;
+    (void) iv;
+    return -1;
+}
+
+#endif
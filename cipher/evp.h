@@ -0,0 +1,46 @@
+/**
+* @file
+* @brief Omotac za EVP interfejs biblioteke libcrypto (OpenSSL).
+* @details Za kljuc se jednom prave dva EVP konteksta (za enkripciju i za dekripciju) sa vec
+* pripremljenim kljucevima. Kontekst se ne sme menjati iz vise niti, pa se za svaku obradu pravi
+* kopija (EVP_CIPHER_CTX_copy), kojoj se postavlja samo vektor ulancavanja.
+*
+* Modul se prevodi samo uz USE_OPENSSL (i -lcrypto); bez toga evpOpen uvek vraca NULL, a pozivaoci
+* koriste ugradjene implementacije. DES i tDES su u OpenSSL 3 u "legacy" provajderu, koji se ucitava
+* pri prvom otvaranju; ukoliko ga nema, otvaranje za njih ne uspeva.
+*/
+
+#ifndef _EVP_H_
+#define _EVP_H_
+
+#include <stddef.h>
+#include "../global.h"
+#include "../encryption.h"
+
+/**
+* @brief Funkcija koja pravi EVP kontekst za algoritam i smer.
+* @param[in] algo Algoritam.
+* @param[in] key Kljuc u standardnom obliku (za DES sa bitovima parnosti, za tDES tri takva kljuca
+* jedan za drugim).
+* @param[in] encrypt 1 za enkripciju, 0 za dekripciju.
+* @return Kontekst ili NULL ukoliko biblioteka ili algoritam nisu dostupni.
+*/
+void* evpOpen(Algorithm algo, const uc *key, int encrypt);
+
+/**
+* @brief Funkcija koja oslobadja kontekst.
+* @param[in] evp Kontekst iz evpOpen ili NULL.
+*/
+void  evpClose(void *evp);
+
+/**
+* @brief Funkcija za enkripciju/dekripciju bafera u mestu (smer je zadat pri otvaranju konteksta).
+* @param[in] evp Kontekst iz evpOpen.
+* @param[in,out] buf Bafer, duzina mora biti umnozak velicine bloka.
+* @param[in] len Duzina bafera.
+* @param[in] iv Vektor ulancavanja za CBC ili NULL za ECB.
+* @return 0 ili -1 (tada bafer nije izmenjen).
+*/
+int   evpCrypt(void *evp, uc *buf, size_t len, const uc *iv);
+
+#endif // _EVP_H_
@@ -7,9 +7,14 @@
 
 #include "cmd_line.h"
 #include "process.h"
+#include "watch.h"
+#include "daemon.h"
+#include "plan.h"
 #include "list.h"
 #include "keys.h"
+#include "batch.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /*********************** INTERNAL FUNCTIONS ***********************/
@@ -36,30 +41,255 @@ static void print_keys(List *key_list) {
 * Argumenti se ispisuju na standardnom izlazu.
 */
 static void print_help() {
-    printf("encrypt(.exe) -[e/d[m/r]] key_name file_path\n");
+    printf("encrypt(.exe) [options] -[e/d[m/r/t]] key_name file_path\n");
+    printf("encrypt(.exe) [options] -w[e/d] key_name directory [directory ...]\n");
+    printf("encrypt(.exe) [options] -s socket_path\n");
+    printf("encrypt(.exe) [-o DIR] -c socket_path -[e/d/v] key_name file_path [file_path ...]\n");
     printf("encrypt(.exe) -b file_path\n");
     printf("encrypt(.exe) -l file_path\n");
+    printf("options:\n");
+    printf("  -j N    number of worker threads for -[e/d][m/r/t] (0 = one per CPU)\n");
+    printf("  -i GLOB only files matching GLOB for -[e/d]t (repeatable, default for -dt: *.dat)\n");
+    printf("  -x GLOB skip files and directories matching GLOB for -[e/d]t (repeatable, -et without -o: *.dat)\n");
+    printf("  -o DIR  mirror the tree into DIR instead of writing next to the input for -[e/d]t\n");
+    printf("  -f FMT  log.txt format for -[e/d][m/r/t]: text (default) or json (one record per line)\n");
+    printf("  -J FILE keep a journal of finished files for -[e/d][m/r/t] and -b in FILE (created by this\n");
+    printf("          program; any other existing file is left untouched and the command refused)\n");
+    printf("  --resume skip files the journal lists as finished and remove .tmp outputs of interrupted ones\n");
+    printf("           (without -J the journal is journal-XXXXXXXX.txt, named after the command)\n");
+    printf("           (large CBC encryptions continue from their last checkpoint instead)\n");
+    printf("  -dj N   at most N files per disk at once (default: 2 for HDD, 16 for SSD/NVMe)\n");
+    printf("  --physical process -[e/d][m/r] files in on-disk order (FIEMAP, inode order as fallback)\n");
+    printf("  --prefetch open and read ahead the next -[e/d][m/r] files while the current one is processed\n");
+    printf("  -io ENG data transfer: pread (default), mmap (input and output mapped into memory)\n");
+    printf("          or uring (io_uring pipeline, reads and writes overlap encryption; small files\n");
+    printf("          are read and written in batches of chained openat/read|write/close)\n");
+    printf("  -pc MODE page cache use: keep (default), dontneed (drop data behind the cursor), direct\n");
+    printf("          (O_DIRECT) or auto (dontneed from 64 MiB, direct from 1 GiB)\n");
+    printf("  -fs MODE output durability: none (default, left to the kernel), file (fdatasync before\n");
+    printf("          each output gets its name) or group[:N[:MB]] (one syncfs per N outputs or MB\n");
+    printf("          megabytes, default 256 and 1024); always file with -rm/-mv, and file instead\n");
+    printf("          of none with -J/--resume\n");
+    printf("  -ce ENG cipher implementation: builtin (default), afalg (Linux kernel crypto API, fastest\n");
+    printf("          driver the kernel has) or openssl (libcrypto EVP, builds with USE_OPENSSL);\n");
+    printf("          builtin is used when the chosen one is not available\n");
+    printf("  -tr MB  limit reads to MB megabytes per second (all threads together)\n");
+    printf("  -tw MB  limit writes to MB megabytes per second\n");
+    printf("  -tf N   limit opened files to N per second\n");
+    printf("  -tc FILE control file with \"read MB\", \"write MB\" and \"files N\" lines, re-read\n");
+    printf("          every second while running to change the limits (0 = unlimited)\n");
+    printf("  -u FILE incremental -e[m/r/t]: skip files unchanged since the run that wrote manifest FILE\n");
+    printf("  --in-place overwrite each file with its result and rename it (no second copy on disk;\n");
+    printf("           an interrupted file continues from its .wal record when run again;\n");
+    printf("           not with -o, -u, -rm, -mv or --sparse)\n");
+    printf("  --sparse encryption skips holes of sparse files (SEEK_HOLE): they stay holes in the .dat\n");
+    printf("           and its hole map recreates them on decryption, which needs no option\n");
+    printf("  -rm     delete the original after successful -[e/d][m/r/t] or -w[e/d]\n");
+    printf("  -mv DIR move the original into DIR (same filesystem) after success\n");
 }
 
 /**
-* @brief Funkcija za generisanje argumenata iz zadatog stringa.
-* @param[in] line String koji sadrzi komandu koja odgovara formatu za poziv programa iz komandne linije
-* @param[out] argc Pokazivac na broj u koji treba upisati broj argumenata komandne linije
-* @param[out] argv Niz stringova u koji treba upisati argumente komandne linije (mora imati najmanje 4 stringa)
-* @return 0 ukoliko je broj argumenata manji od 5, 1 u suprotnom (zato sto sve ispravne komande nemaju vise od 4 argumenta)
+* @brief Funkcija za obradu opcija koje se zadaju pre same komande. Obradjene opcije se
+* uklanjaju iz argumenata.
+* @param[in,out] argc Pokazivac na broj argumenata komandne linije bez naziva programa
+* @param[in,out] argv Pokazivac na argumente komandne linije bez naziva programa
+* @param[out] opts Opcije za obradu vise fajlova
+* @return 0 ukoliko su opcije ispravne, 1 u suprotnom
 */
-static int parse_line(char *line, int *argc, char *argv[]) {
-    char *pntr = strtok(line, ARGS_SEPARATORS);
-
-    *argc = 0;
-    while (pntr) {
-        if (*argc == 4)
-            return 1;
-        strcpy(argv[(*argc)++], pntr);
-        pntr = strtok(NULL, ARGS_SEPARATORS);
+static int parse_options(int *argc, char ***argv, BatchOptions *opts) {
+    char *end;
+
+    while (*argc > 0) {
+        if (!strcmp((*argv)[0], "-j")) {
+            if (*argc < 2)
+                return 1;
+            opts->jobs = (int)strtol((*argv)[1], &end, 10);
+            if (*end || opts->jobs < 0)
+                return 1;
+            *argc -= 2;
+            *argv += 2;
+        }
+        else if (!strcmp((*argv)[0], "-i") || !strcmp((*argv)[0], "-x")) {
+            if (*argc < 2)
+                return 1;
+            if ((*argv)[0][1] == 'i') {
+                if (opts->n_include == WALK_MAX_GLOBS)
+                    return 1;
+                opts->include[opts->n_include++] = (*argv)[1];
+            }
+            else {
+                if (opts->n_exclude == WALK_MAX_GLOBS)
+                    return 1;
+                opts->exclude[opts->n_exclude++] = (*argv)[1];
+            }
+            *argc -= 2;
+            *argv += 2;
+        }
+        else if (!strcmp((*argv)[0], "-f")) {
+            if (*argc < 2)
+                return 1;
+            if (!strcmp((*argv)[1], "json"))
+                opts->log_format = LOG_JSON;
+            else if (!strcmp((*argv)[1], "text"))
+                opts->log_format = LOG_TEXT;
+            else
+                return 1;
+            *argc -= 2;
+            *argv += 2;
+        }
+        else if (!strcmp((*argv)[0], "-J")) {
+            if (*argc < 2)
+                return 1;
+            opts->journal_path = (*argv)[1];
+            *argc -= 2;
+            *argv += 2;
+        }
+        else if (!strcmp((*argv)[0], "-tr") || !strcmp((*argv)[0], "-tw") || !strcmp((*argv)[0], "-tf")) {
+            if (*argc < 2)
+                return 1;
+            opts->limits[(*argv)[0][2] == 'r' ? THROTTLE_READ : (*argv)[0][2] == 'w' ? THROTTLE_WRITE : THROTTLE_FILES] =
+                strtod((*argv)[1], &end);
+            if (*end || end == (*argv)[1])
+                return 1;
+            *argc -= 2;
+            *argv += 2;
+        }
+        else if (!strcmp((*argv)[0], "-dj")) {
+            if (*argc < 2)
+                return 1;
+            opts->device_jobs = (int)strtol((*argv)[1], &end, 10);
+            if (*end || opts->device_jobs < 0)
+                return 1;
+            *argc -= 2;
+            *argv += 2;
+        }
+        else if (!strcmp((*argv)[0], "-io")) {
+            if (*argc < 2)
+                return 1;
+            if (!strcmp((*argv)[1], "pread"))
+                opts->io_engine = STREAM_ENGINE_PREAD;
+            else if (!strcmp((*argv)[1], "mmap"))
+                opts->io_engine = STREAM_ENGINE_MMAP;
+            else if (!strcmp((*argv)[1], "uring"))
+                opts->io_engine = STREAM_ENGINE_URING;
+            else
+                return 1;
+            *argc -= 2;
+            *argv += 2;
+        }
+        else if (!strcmp((*argv)[0], "-pc")) {
+            if (*argc < 2)
+                return 1;
+            if (!strcmp((*argv)[1], "keep"))
+                opts->cache_mode = STREAM_CACHE_KEEP;
+            else if (!strcmp((*argv)[1], "dontneed"))
+                opts->cache_mode = STREAM_CACHE_DONTNEED;
+            else if (!strcmp((*argv)[1], "direct"))
+                opts->cache_mode = STREAM_CACHE_DIRECT;
+            else if (!strcmp((*argv)[1], "auto"))
+                opts->cache_mode = STREAM_CACHE_AUTO;
+            else
+                return 1;
+            *argc -= 2;
+            *argv += 2;
+        }
+        else if (!strcmp((*argv)[0], "-fs")) {
+            if (*argc < 2)
+                return 1;
+            if (!strcmp((*argv)[1], "none"))
+                opts->sync_mode = STREAM_SYNC_NONE;
+            else if (!strcmp((*argv)[1], "file"))
+                opts->sync_mode = STREAM_SYNC_FILE;
+            else if (!strncmp((*argv)[1], "group", 5) && (!(*argv)[1][5] ||
+                     (sscanf((*argv)[1] + 5, ":%ld:%lf", &opts->sync_files, &opts->sync_mb) >= 1 &&
+                      opts->sync_files >= 0 && opts->sync_mb >= 0)))
+                opts->sync_mode = STREAM_SYNC_GROUP;
+            else
+                return 1;
+            *argc -= 2;
+            *argv += 2;
+        }
+        else if (!strcmp((*argv)[0], "-ce")) {
+            if (*argc < 2)
+                return 1;
+            if (!strcmp((*argv)[1], "builtin"))
+                opts->cipher_backend = CIPHER_BACKEND_BUILTIN;
+            else if (!strcmp((*argv)[1], "afalg"))
+                opts->cipher_backend = CIPHER_BACKEND_AFALG;
+            else if (!strcmp((*argv)[1], "openssl"))
+                opts->cipher_backend = CIPHER_BACKEND_OPENSSL;
+            else
+                return 1;
+            *argc -= 2;
+            *argv += 2;
+        }
+        else if (!strcmp((*argv)[0], "-tc")) {
+            if (*argc < 2)
+                return 1;
+            opts->throttle_file = (*argv)[1];
+            *argc -= 2;
+            *argv += 2;
+        }
+        else if (!strcmp((*argv)[0], "-u")) {
+            if (*argc < 2)
+                return 1;
+            opts->manifest_path = (*argv)[1];
+            *argc -= 2;
+            *argv += 2;
+        }
+        else if (!strcmp((*argv)[0], "--physical")) {
+            opts->physical_order = 1;
+            (*argc)--;
+            (*argv)++;
+        }
+        else if (!strcmp((*argv)[0], "--prefetch")) {
+            opts->prefetch = 1;
+            (*argc)--;
+            (*argv)++;
+        }
+        else if (!strcmp((*argv)[0], "--in-place")) {
+            opts->in_place = 1;
+            (*argc)--;
+            (*argv)++;
+        }
+        else if (!strcmp((*argv)[0], "--sparse")) {
+            opts->sparse = 1;
+            (*argc)--;
+            (*argv)++;
+        }
+        else if (!strcmp((*argv)[0], "--resume")) {
+            opts->resume = 1;
+            (*argc)--;
+            (*argv)++;
+        }
+        else if (!strcmp((*argv)[0], "-rm")) {
+            opts->after_success = AFTER_DELETE;
+            (*argc)--;
+            (*argv)++;
+        }
+        else if (!strcmp((*argv)[0], "-mv")) {
+            if (*argc < 2)
+                return 1;
+            opts->after_success = AFTER_MOVE;
+            opts->move_dir = (*argv)[1];
+            *argc -= 2;
+            *argv += 2;
+        }
+        else if (!strcmp((*argv)[0], "-o")) {
+            if (*argc < 2)
+                return 1;
+            opts->out_root = (*argv)[1];
+            *argc -= 2;
+            *argv += 2;
+        }
+        else
+            break;
     }
 
-    return 0;
+    /// fajl u mestu nema poseban izlaz ni original koji bi se brisao ili pomerao
+    if (opts->in_place && (opts->sparse || opts->out_root || opts->manifest_path || opts->after_success != AFTER_KEEP))
+        return 1;
+    return *argc == 0;
 }
 
 /**
@@ -71,9 +301,10 @@ static int parse_line(char *line, int *argc, char *argv[]) {
 * @param[in] print_to_stdout Ukoliko je 0 sve poruke ce biti ispisivane u zadati fajl,
 * u suprotnom ce poruke biti ispisivane na standardnom izlazu, a fajl ce biti koriscen
 * samo u slucaju da se komanda odnosi na enkripciju/dekripciju vise fajlova
+* @param[in] opts Opcije za obradu vise fajlova
 */
-static void process_ed_command(int argc, char *argv[], List *key_list, FILE *log_file, int print_to_stdout) {
-    int encr_flag, more_files_flag = 0, regex_flag = 0;
+static void process_ed_command(int argc, char *argv[], List *key_list, FILE *log_file, int print_to_stdout, BatchOptions *opts) {
+    int encr_flag, more_files_flag = 0, regex_flag = 0, tree_flag = 0;
     char error_msg[MAX_STR_LEN];
     Key *key;
     FILE *log_file_tmp = print_to_stdout ? stdout : log_file;
@@ -86,8 +317,9 @@ static void process_ed_command(int argc, char *argv[], List *key_list, FILE *log
     encr_flag = argv[0][1] == 'e';
     more_files_flag = argv[0][2] == 'm';
     regex_flag = argv[0][2] == 'r';
+    tree_flag = argv[0][2] == 't';
 
-    if (strlen(argv[0]) == 3 && !more_files_flag && !regex_flag) {
+    if (strlen(argv[0]) == 3 && !more_files_flag && !regex_flag && !tree_flag) {
         print_log(log_file_tmp, INVALID_COMMAND_STR);
         return;
     }
@@ -98,16 +330,23 @@ static void process_ed_command(int argc, char *argv[], List *key_list, FILE *log
     }
 
     if (encr_flag) {
-        if (!more_files_flag && !regex_flag) {
-            if (encrypt_file(argv[2], key, error_msg)) {
+        if (!more_files_flag && !regex_flag && !tree_flag) {
+            if ((opts->in_place ? encrypt_file_in_place : encrypt_file)(argv[2], key, error_msg)) {
                 print_log(log_file_tmp, "Error with file %s:%s\n", argv[2], error_msg);
             }
             else {
                 print_log(log_file_tmp, "File %s encrypted\n", argv[2]);
             }
         }
+        else if (tree_flag) {
+            if (encrypt_tree_files(argv[2], key, error_msg, log_file, opts)) {
+                print_log(log_file_tmp, "%s\n", error_msg);
+            }
+            else if (print_to_stdout)
+                printf("See log.txt for info about encryption...\n");
+        }
         else if (more_files_flag) {
-            if (encrypt_more_files(argv[2], key, log_file)) {
+            if (encrypt_more_files(argv[2], key, log_file, opts)) {
                 print_log(log_file_tmp, "Unable to open file %s\n", argv[2]);
             }
             else if (print_to_stdout)
@@ -119,10 +358,10 @@ static void process_ed_command(int argc, char *argv[], List *key_list, FILE *log
             }
             else {
                 /// filepath is enclosed in ''
-                strcpy(argv[2], argv[2] + 1);
+                memmove(argv[2], argv[2] + 1, strlen(argv[2]));
                 argv[2][strlen(argv[2]) - 1] = '\0';
 
-                if (encrypt_regex_files(argv[2], key, error_msg, log_file)) {
+                if (encrypt_regex_files(argv[2], key, error_msg, log_file, opts)) {
                     print_log(log_file_tmp, "%s\n", error_msg);
                 }
                 else if (print_to_stdout)
@@ -131,16 +370,23 @@ static void process_ed_command(int argc, char *argv[], List *key_list, FILE *log
         }
     }
     else {
-        if (!more_files_flag && !regex_flag) {
-            if (decrypt_file(argv[2], key, error_msg)) {
+        if (!more_files_flag && !regex_flag && !tree_flag) {
+            if ((opts->in_place ? decrypt_file_in_place : decrypt_file)(argv[2], key, error_msg)) {
                 print_log(log_file_tmp, "Error with file %s:%s\n", argv[2], error_msg);
             }
             else {
                 print_log(log_file_tmp, "File %s decrypted\n", argv[2]);
             }
         }
+        else if (tree_flag) {
+            if (decrypt_tree_files(argv[2], key, error_msg, log_file, opts)) {
+                print_log(log_file_tmp, "%s\n", error_msg);
+            }
+            else if (print_to_stdout)
+                printf("See log.txt for info about decryption...\n");
+        }
         else if (more_files_flag) {
-            if (decrypt_more_files(argv[2], key, log_file)) {
+            if (decrypt_more_files(argv[2], key, log_file, opts)) {
                 print_log(log_file_tmp, "Unable to open file %s\n", argv[2]);
             }
             else if (print_to_stdout)
@@ -152,10 +398,10 @@ static void process_ed_command(int argc, char *argv[], List *key_list, FILE *log
             }
             else {
                 /// filepath is enclosed in ''
-                strcpy(argv[2], argv[2] + 1);
+                memmove(argv[2], argv[2] + 1, strlen(argv[2]));
                 argv[2][strlen(argv[2]) - 1] = '\0';
 
-                if (decrypt_regex_files(argv[2], key, error_msg, log_file)) {
+                if (decrypt_regex_files(argv[2], key, error_msg, log_file, opts)) {
                     print_log(log_file_tmp, "%s\n", error_msg);
                 }
                 else if (print_to_stdout)
@@ -166,13 +412,33 @@ static void process_ed_command(int argc, char *argv[], List *key_list, FILE *log
 }
 
 /**
-* @brief Funkcija za obradu batch komande.
+* @brief Argumenti za izvrsavanje komandi za vise fajlova iz batch fajla.
+*/
+typedef struct BatchCommandArg {
+    List *key_list;
+    FILE *log_file;
+    BatchOptions *opts;
+} BatchCommandArg;
+
+/**
+* @brief Funkcija koju planer poziva za komande koje ne izvrsava sam.
+*/
+static void run_batch_command(int argc, char *argv[], void *arg) {
+    BatchCommandArg *cmd = (BatchCommandArg*)arg;
+    process_ed_command(argc, argv, cmd->key_list, cmd->log_file, 0, cmd->opts);
+}
+
+/**
+* @brief Funkcija za obradu batch komande. Ceo fajl se prvo isplanira, a zatim se nezavisne komande
+* izvrsavaju paralelno (plan.h).
 * @param[in] argc Broj argumenata komandne linije bez naziva programa
 * @param[in] argv Argumenti komandne linije bez naziva programa
 * @param[in] key_list Pokazivac na listu trenutno ucitanih kljuceva
 * @param[in] log_file Pokazivac na fajl u koji treba ispisivati poruke
+* @param[in] opts Opcije za obradu vise fajlova
 */
-static void process_b_command(int argc, char *argv[], List *key_list, FILE *log_file) {
+static void process_b_command(int argc, char *argv[], List *key_list, FILE *log_file, BatchOptions *opts) {
+    BatchCommandArg cmd;
     FILE *f;
     if (strlen(argv[0]) != 2 || argc != 2) {
         printf(INVALID_COMMAND_STR);
@@ -182,34 +448,95 @@ static void process_b_command(int argc, char *argv[], List *key_list, FILE *log_
     f = fopen(argv[1], "r");
 
     if (f) {
-        int new_argc;
-        char *new_argv[4];
-        char str[MAX_STR_LEN];
-        int i;
-        for (i = 0; i < 4; i++)
-            new_argv[i] = malloc(sizeof(char) *MAX_STR_LEN);
-
-        while (fgets(str, MAX_KEY_ROW_LEN, f)) {
-            if (parse_line(str, &new_argc, new_argv) || (new_argc > 1 && new_argv[1][0] != '-')) {
-                print_log(log_file, "Invalid command: %s\n", str);
-            }
-            else if (new_argv[1][1] == 'b' || new_argv[1][1] == 'l') {
-                print_log(log_file, "-[b/l] command not allowed: %s\n", str);
-            }
-            else
-                process_ed_command(new_argc - 1, new_argv + 1, key_list, log_file, 0);
-        }
+        cmd.key_list = key_list;
+        cmd.log_file = log_file;
+        cmd.opts = opts;
+        plan_run(f, key_list, log_file, opts, run_batch_command, &cmd);
 
         printf("See log.txt for info about encryption...\n");
-
-        for (i = 0; i < 4; i++)
-            free(new_argv[i]);
         fclose(f);
     }
     else
         printf("Unable to open given file!\n");
 }
 
+/**
+* @brief Funkcija za obradu komande za pracenje direktorijuma. Fajlovi koji se pojave u direktorijumima
+* se obradjuju dok se program ne prekine (Ctrl+C).
+* @param[in] argc Broj argumenata komandne linije bez naziva programa
+* @param[in] argv Argumenti komandne linije bez naziva programa
+* @param[in] key_list Pokazivac na listu trenutno ucitanih kljuceva
+* @param[in] log_file Pokazivac na fajl u koji treba ispisivati poruke
+* @param[in] opts Opcije za obradu vise fajlova
+*/
+static void process_w_command(int argc, char *argv[], List *key_list, FILE *log_file, BatchOptions *opts) {
+    char error_msg[MAX_STR_LEN];
+    int encr_flag = argv[0][2] == 'e';
+    Key *key;
+
+    if (argc < 3 || strlen(argv[0]) != 3 || (argv[0][2] != 'e' && argv[0][2] != 'd')) {
+        printf(INVALID_COMMAND_STR);
+        return;
+    }
+
+    if (!(key = find_key_with_name(key_list, argv[1]))) {
+        printf("Key %s does not exist!\n", argv[1]);
+        return;
+    }
+
+    printf("Watching for new files, press Ctrl+C to stop. See log.txt for info about %s...\n",
+           encr_flag ? "encryption" : "decryption");
+    if (watch_directories(argv + 2, argc - 2, key, encr_flag, error_msg, log_file, opts))
+        printf("%s\n", error_msg);
+}
+
+/**
+* @brief Funkcija za obradu komande za pokretanje servisa koji cuva kljuceve i pripremljene kontekste
+* algoritama i prima poslove preko Unix soketa.
+* @param[in] argc Broj argumenata komandne linije bez naziva programa
+* @param[in] argv Argumenti komandne linije bez naziva programa
+* @param[in] key_list Pokazivac na listu trenutno ucitanih kljuceva
+* @param[in] opts Opcije (broj radnih niti)
+*/
+static void process_s_command(int argc, char *argv[], List *key_list, BatchOptions *opts) {
+    char error_msg[MAX_STR_LEN];
+
+    if (strlen(argv[0]) != 2 || argc != 2) {
+        printf(INVALID_COMMAND_STR);
+        return;
+    }
+
+    printf("Listening on %s, press Ctrl+C to stop...\n", argv[1]);
+    if (daemon_serve(argv[1], key_list, error_msg, opts))
+        printf("%s\n", error_msg);
+}
+
+/**
+* @brief Funkcija za obradu komande kojom se poslovi salju servisu pokrenutom sa -s. Ishodi se
+* ispisuju na standardnom izlazu.
+* @param[in] argc Broj argumenata komandne linije bez naziva programa
+* @param[in] argv Argumenti komandne linije bez naziva programa
+* @param[in] opts Opcije (izlazni direktorijum)
+*/
+static void process_c_command(int argc, char *argv[], BatchOptions *opts) {
+    char error_msg[MAX_STR_LEN];
+    char op;
+
+    if (strlen(argv[0]) != 2 || argc < 5 || argv[2][0] != '-' || strlen(argv[2]) != 2) {
+        printf(INVALID_COMMAND_STR);
+        return;
+    }
+
+    op = argv[2][1];
+    if (op != DAEMON_OP_ENCRYPT && op != DAEMON_OP_DECRYPT && op != DAEMON_OP_VERIFY) {
+        printf(INVALID_COMMAND_STR);
+        return;
+    }
+
+    if (daemon_client(argv[1], op, argv[3], argv + 4, argc - 4, opts->out_root, stdout, error_msg))
+        printf("%s\n", error_msg);
+}
+
 /**
 * @brief Funkcija za obradu komande za izlistavanje kljuceva. Kljucevi se izlistavaju samo na standardnom izlazu.
 * @param[in] argc Broj argumenata komandne linije bez naziva programa
@@ -226,22 +553,77 @@ static void process_l_command(int argc, char *argv[], List *key_list) {
 
 /*********************** EXTERNAL FUNCTIONS ***********************/
 void process_command(int argc, char *argv[], List *key_list) {
-    FILE *log_file = fopen("log.txt", "w");
+    FILE *log_file;
+    BatchOptions opts;
+    streamsync_t sync_mode;
+    char journal_path[64];
     argc--;
     argv++;
 
-    if (argv[0][0] != '-'/* && argv[0][0] != '/'*/) {
+    init_batch_options(&opts);
+    if (parse_options(&argc, &argv, &opts) || argv[0][0] != '-'/* && argv[0][0] != '/'*/) {
         printf(INVALID_COMMAND_STR);
         return;
     }
 
+    if (argv[0][1] == 'c') {
+        process_c_command(argc, argv, &opts);
+        return;
+    }
+
+    streamSetEngine(opts.io_engine);
+    if (streamSetCacheMode(opts.cache_mode)) {
+        printf("Direct I/O (-pc direct) is not supported on this system\n");
+        return;
+    }
+    streamSetSparse(opts.sparse);
+    /// original se brise tek kada je izlaz na disku, pa se uz -rm/-mv svaki izlaz odmah spusta na
+    /// disk, bez obzira na izabranu trajnost; zurnal belezi fajl kao zavrsen tek kada mu je izlaz
+    /// na disku, pa uz njega izlazi moraju na disk bar po grupama
+    sync_mode = opts.sync_mode;
+    if (opts.after_success != AFTER_KEEP ||
+        ((opts.journal_path || opts.resume) && sync_mode == STREAM_SYNC_NONE))
+        sync_mode = STREAM_SYNC_FILE;
+    streamSetSync(sync_mode, opts.sync_files, opts.sync_mb * 1024 * 1024);
+    cipherSetBackend(opts.cipher_backend);
+    throttleSetLimit(THROTTLE_READ, opts.limits[THROTTLE_READ] * 1024 * 1024);
+    throttleSetLimit(THROTTLE_WRITE, opts.limits[THROTTLE_WRITE] * 1024 * 1024);
+    throttleSetLimit(THROTTLE_FILES, opts.limits[THROTTLE_FILES]);
+    if (opts.throttle_file)
+        throttleSetControlFile(opts.throttle_file);
+
+    /// zurnal se vodi samo na zahtev, za komande koje obradjuju vise fajlova; -w obradjuje samo nove
+    /// dogadjaje, pa mu zurnal ne sluzi, a rastao bi bez kraja
+    if (opts.journal_path || opts.resume) {
+        if (argv[0][1] == 'w' || (argv[0][1] != 'b' && strlen(argv[0]) != 3)) {
+            printf(INVALID_COMMAND_STR);
+            return;
+        }
+        if (!opts.journal_path) {
+            journal_default_path(journal_path, sizeof(journal_path), argc, argv);
+            opts.journal_path = journal_path;
+        }
+        if (journal_prepare(opts.journal_path, opts.resume)) {
+            printf("Unable to use journal %s (not created by this program?)\n", opts.journal_path);
+            return;
+        }
+    }
+
+    log_file = fopen("log.txt", "w");
+
     switch (argv[0][1]) {
     case 'e':
     case 'd':
-        process_ed_command(argc, argv, key_list, log_file, 1);
+        process_ed_command(argc, argv, key_list, log_file, 1, &opts);
         break;
     case 'b':
-        process_b_command(argc, argv, key_list, log_file);
+        process_b_command(argc, argv, key_list, log_file, &opts);
+        break;
+    case 'w':
+        process_w_command(argc, argv, key_list, log_file, &opts);
+        break;
+    case 's':
+        process_s_command(argc, argv, key_list, &opts);
         break;
     case 'l':
         process_l_command(argc, argv, key_list);
@@ -253,6 +635,18 @@ void process_command(int argc, char *argv[], List *key_list) {
         printf(INVALID_COMMAND_STR);
     }
 
+    streamSyncFlush();
     if (log_file)
         fclose(log_file);
 }
+
+int command_needs_keys(int argc, char *argv[]) {
+    BatchOptions opts;
+    argc--;
+    argv++;
+
+    init_batch_options(&opts);
+    if (parse_options(&argc, &argv, &opts) || !argc || argv[0][0] != '-')
+        return 1;
+    return argv[0][1] != 'c' && argv[0][1] != 'h';
+}
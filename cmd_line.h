@@ -30,6 +30,15 @@
 */
 void process_command(int argc, char *argv[], List *key_list);
 
+/**
+* @brief Funkcija koja proverava da li je za zadatu komandu potrebno ucitati kljuceve (klijent servisa
+* i pomoc ih ne koriste, pa se fajl sa kljucevima tada ne cita).
+* @param[in] argc Broj argumenata komandne linije
+* @param[in] argv Argumenti komandne linije
+* @return 1 ukoliko su kljucevi potrebni, 0 u suprotnom
+*/
+int command_needs_keys(int argc, char *argv[]);
+
 /**
 * @brief Makro za ispisivanje u fajl ukoliko fajl postoji.
 */
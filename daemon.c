@@ -0,0 +1,588 @@
+/**
+* @file
+* @brief Funkcije za rezidentni servis (daemon) i klijenta koji mu salje poslove.
+* @details Glavna nit prima veze; za svaku vezu se pravi nit koja cita okvire i zadaje poslove skupu
+* radnih niti (pool.h). Kada je skup niti pun, nit veze blokira u pool_submit i ne cita dalje, pa
+* klijent koji salje prebrzo biva usporen. Odgovore salju radne niti, pod bravom veze. Veza se
+* oslobadja tek kada su poslati odgovori na sve njene zahteve.
+*/
+
+/// accept4
+#define _GNU_SOURCE
+#include "daemon.h"
+#include "global.h"
+#include "keys.h"
+#include "pool.h"
+#include "process.h"
+#include "cipher/cipher.h"
+#include "io/stream.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/**
+* @brief Najduze cekanje na novu vezu (u milisekundama) pre ponovne provere zastavice za kraj.
+*/
+#define DAEMON_IDLE_MS 1000
+
+/**
+* @brief Velicina odgovora bez poruke o gresci.
+*/
+#define DAEMON_REPLY_FIXED 16
+
+/**
+* @brief Maksimalna duzina poruke o gresci u odgovoru.
+*/
+#define DAEMON_MSG_MAX 64
+
+/**
+* @brief Kljuc sa pripremljenim kontekstom algoritma.
+*/
+typedef struct DaemonKey {
+    Key *key;
+    cipherctx_t ctx;
+    int status;         /**< Rezultat cipherInit */
+} DaemonKey;
+
+/**
+* @brief Stanje servisa.
+*/
+typedef struct Daemon {
+    DaemonKey *keys;
+    int n_keys;
+    ThreadPool *pool;
+
+    struct Connection *conns;   /**< Otvorene veze */
+    int n_conns;
+    pthread_mutex_t lock;
+    pthread_cond_t closed;
+} Daemon;
+
+/**
+* @brief Jedna veza sa klijentom.
+*/
+typedef struct Connection {
+    struct Connection *next, *prev;
+    Daemon *daemon;
+    int fd;
+    int pending;        /**< Broj zadatih poslova na koje jos nije poslat odgovor */
+    pthread_mutex_t lock;
+    pthread_cond_t idle;
+} Connection;
+
+/**
+* @brief Jedan posao.
+*/
+typedef struct DaemonJob {
+    Connection *conn;
+    uint32_t id;
+    char op;
+    DaemonKey *dkey;
+    char in[BATCH_PATH_MAX];
+    char out[BATCH_PATH_MAX];
+} DaemonJob;
+
+/**
+* @brief Postavlja se na 1 kada stigne signal za kraj rada servisa.
+*/
+static volatile sig_atomic_t daemon_stop = 0;
+
+/*********************** INTERNAL FUNCTIONS ***********************/
+static void daemon_signal(int sig) {
+    (void)sig;
+    daemon_stop = 1;
+}
+
+static void put_u32(unsigned char *p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static uint32_t get_u32(const unsigned char *p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+/**
+* @brief Funkcija koja cita tacno len bajtova sa soketa.
+* @return 0, ili 1 ukoliko je veza zatvorena ili je doslo do greske
+*/
+static int recv_full(int fd, void *buf, size_t len) {
+    size_t done = 0;
+    ssize_t n;
+
+    while (done < len) {
+        n = recv(fd, (char*)buf + done, len - done, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return 1;
+        done += n;
+    }
+    return 0;
+}
+
+/**
+* @brief Funkcija koja salje tacno len bajtova na soket.
+* @return 0, ili 1 u slucaju greske
+*/
+static int send_full(int fd, const void *buf, size_t len) {
+    size_t done = 0;
+    ssize_t n;
+
+    while (done < len) {
+        n = send(fd, (const char*)buf + done, len - done, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return 1;
+        done += n;
+    }
+    return 0;
+}
+
+/**
+* @brief Funkcija koja cita jedan okvir.
+* @param[in] fd Soket
+* @param[out] buf Bafer od DAEMON_FRAME_MAX bajtova
+* @param[out] len Duzina procitanog okvira
+* @return 0, ili 1 ukoliko je veza zatvorena ili okvir nije ispravan
+*/
+static int read_frame(int fd, unsigned char *buf, uint32_t *len) {
+    unsigned char hdr[4];
+
+    if (recv_full(fd, hdr, 4))
+        return 1;
+    *len = get_u32(hdr);
+    if (*len > DAEMON_FRAME_MAX)
+        return 1;
+    return recv_full(fd, buf, *len);
+}
+
+/**
+* @brief Funkcija koja salje jedan okvir (duzina je upisana u prva 4 bajta bafera).
+*/
+static int write_frame(int fd, unsigned char *frame, uint32_t len) {
+    put_u32(frame, len);
+    return send_full(fd, frame, len + 4);
+}
+
+/**
+* @brief Funkcija koja salje odgovor na zahtev. Poziva se pod bravom veze.
+*/
+static void send_reply(Connection *conn, uint32_t id, int status, uint64_t bytes) {
+    unsigned char frame[4 + DAEMON_REPLY_FIXED + DAEMON_MSG_MAX];
+    char *msg = (char*)frame + 4 + DAEMON_REPLY_FIXED;
+    int i;
+
+    put_u32(frame + 4, id);
+    put_u32(frame + 8, (uint32_t)status);
+    for (i = 0; i < 8; i++)
+        frame[12 + i] = bytes >> (56 - 8 * i);
+    set_error_msg(status, msg);
+
+    /// greska pri slanju znaci da je klijent otisao; nit veze ce to videti pri citanju
+    write_frame(conn->fd, frame, DAEMON_REPLY_FIXED + strlen(msg) + 1);
+}
+
+/**
+* @brief Funkcija koja vraca kljuc sa zadatim nazivom.
+*/
+static DaemonKey* find_daemon_key(Daemon *daemon, const char *name) {
+    int i;
+    for (i = 0; i < daemon->n_keys; i++)
+        if (!strcmp(daemon->keys[i].key->key_name, name))
+            return &daemon->keys[i];
+    return NULL;
+}
+
+/**
+* @brief Funkcija koja izvrsava jedan posao i salje odgovor. Izvrsava je radna nit.
+* @param[in] arg Pokazivac na DaemonJob
+*/
+static void run_job(void *arg) {
+    DaemonJob *job = (DaemonJob*)arg;
+    Connection *conn = job->conn;
+    const char *out = job->out[0] ? job->out : NULL;
+    uint64_t bytes = 0;
+    int status = job->dkey->status;
+
+    if (!status) {
+        if (job->op == DAEMON_OP_ENCRYPT)
+            status = streamEncryptFile(&job->dkey->ctx, job->in, out, &bytes);
+        else if (job->op == DAEMON_OP_DECRYPT)
+            status = streamDecryptFile(&job->dkey->ctx, job->in, out, &bytes);
+        else
+            status = streamVerifyFile(&job->dkey->ctx, job->in, &bytes);
+    }
+
+    pthread_mutex_lock(&conn->lock);
+    send_reply(conn, job->id, status, bytes);
+    if (!--conn->pending)
+        pthread_cond_signal(&conn->idle);
+    pthread_mutex_unlock(&conn->lock);
+    free(job);
+}
+
+/**
+* @brief Funkcija koja rasclanjuje zahtev i zadaje posao.
+* @return 0, ili 1 ukoliko zahtev nije ispravan (veza se tada zatvara)
+*/
+static int submit_request(Connection *conn, unsigned char *buf, uint32_t len) {
+    const char *key_name, *in, *out, *end = (char*)buf + len;
+    DaemonJob *job;
+    DaemonKey *dkey;
+    uint32_t id;
+    char op;
+
+    if (len < 5 || buf[len - 1] != '\0')
+        return 1;
+    id = get_u32(buf);
+    op = buf[4];
+    key_name = (char*)buf + 5;
+    in = key_name + strlen(key_name) + 1;
+    if (in >= end)
+        return 1;
+    out = in + strlen(in) + 1;
+    if (out >= end)
+        return 1;
+
+    if ((op != DAEMON_OP_ENCRYPT && op != DAEMON_OP_DECRYPT && op != DAEMON_OP_VERIFY) ||
+        strlen(in) >= BATCH_PATH_MAX || strlen(out) >= BATCH_PATH_MAX)
+        return 1;
+
+    pthread_mutex_lock(&conn->lock);
+    if (!(dkey = find_daemon_key(conn->daemon, key_name))) {
+        send_reply(conn, id, UNKNOWN_ALG, 0);
+        pthread_mutex_unlock(&conn->lock);
+        return 0;
+    }
+    conn->pending++;
+    pthread_mutex_unlock(&conn->lock);
+
+    job = (DaemonJob*) malloc(sizeof(DaemonJob));
+    ALLOC_CHECK(job);
+    job->conn = conn;
+    job->id = id;
+    job->op = op;
+    job->dkey = dkey;
+    strcpy(job->in, in);
+    strcpy(job->out, out);
+    pool_submit(conn->daemon->pool, run_job, job);
+    return 0;
+}
+
+/**
+* @brief Glavna funkcija niti jedne veze.
+* @param[in] arg Pokazivac na Connection
+*/
+static void* connection_main(void *arg) {
+    Connection *conn = (Connection*)arg;
+    Daemon *daemon = conn->daemon;
+    unsigned char *buf = (unsigned char*) malloc(DAEMON_FRAME_MAX);
+    uint32_t len;
+    ALLOC_CHECK(buf);
+
+    while (!read_frame(conn->fd, buf, &len) && !submit_request(conn, buf, len))
+        ;
+    free(buf);
+
+    pthread_mutex_lock(&conn->lock);
+    while (conn->pending)
+        pthread_cond_wait(&conn->idle, &conn->lock);
+    pthread_mutex_unlock(&conn->lock);
+
+    pthread_mutex_lock(&daemon->lock);
+    if (conn->prev)
+        conn->prev->next = conn->next;
+    else
+        daemon->conns = conn->next;
+    if (conn->next)
+        conn->next->prev = conn->prev;
+    if (!--daemon->n_conns)
+        pthread_cond_signal(&daemon->closed);
+    pthread_mutex_unlock(&daemon->lock);
+
+    close(conn->fd);
+    pthread_mutex_destroy(&conn->lock);
+    pthread_cond_destroy(&conn->idle);
+    free(conn);
+    return NULL;
+}
+
+/**
+* @brief Funkcija koja pravi nit za novu vezu.
+*/
+static void start_connection(Daemon *daemon, int fd) {
+    Connection *conn = (Connection*) calloc(1, sizeof(Connection));
+    pthread_attr_t attr;
+    pthread_t thread;
+    ALLOC_CHECK(conn);
+
+    conn->daemon = daemon;
+    conn->fd = fd;
+    pthread_mutex_init(&conn->lock, NULL);
+    pthread_cond_init(&conn->idle, NULL);
+
+    pthread_mutex_lock(&daemon->lock);
+    conn->next = daemon->conns;
+    if (daemon->conns)
+        daemon->conns->prev = conn;
+    daemon->conns = conn;
+    daemon->n_conns++;
+    pthread_mutex_unlock(&daemon->lock);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_create(&thread, &attr, connection_main, conn);
+    pthread_attr_destroy(&attr);
+}
+
+/**
+* @brief Funkcija koja otvara Unix soket na zadatoj putanji.
+* @return Soket ili -1
+*/
+static int open_socket(const char *path, int listening) {
+    struct sockaddr_un addr;
+    struct stat st;
+    mode_t old_mask;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0)
+        return -1;
+
+    if (!listening) {
+        if (connect(fd, (struct sockaddr*)&addr, sizeof(addr))) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    /// brise se samo soket ostao od prethodnog servisa, nikada obican fajl na toj putanji
+    if (!lstat(path, &st)) {
+        if (!S_ISSOCK(st.st_mode) || unlink(path)) {
+            close(fd);
+            return -1;
+        }
+    }
+    /// soket je dostupan samo vlasniku
+    old_mask = umask(0077);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) || listen(fd, SOMAXCONN)) {
+        umask(old_mask);
+        close(fd);
+        return -1;
+    }
+    umask(old_mask);
+    return fd;
+}
+
+/**
+* @brief Funkcija koja pravi apsolutnu putanju (servis ima drugi radni direktorijum).
+* @return 0, ili 1 ukoliko je putanja predugacka
+*/
+static int absolute_path(const char *path, char *abs, size_t size) {
+    size_t len;
+    int n;
+
+    if (path[0] == '/') {
+        n = snprintf(abs, size, "%s", path);
+        return n < 0 || (size_t)n >= size;
+    }
+    if (!getcwd(abs, size))
+        return 1;
+    len = strlen(abs);
+    n = snprintf(abs + len, size - len, "/%s", path);
+    return n < 0 || (size_t)n >= size - len;
+}
+
+/*********************** EXTERNAL FUNCTIONS ***********************/
+int daemon_serve(const char *socket_path, List *key_list, char *error_msg, BatchOptions *opts) {
+    BatchOptions default_opts;
+    ListElement *curr;
+    Daemon daemon;
+    Connection *conn;
+    struct sigaction sa, old_int, old_term;
+    struct pollfd pfd;
+    int listen_fd, fd, jobs, i;
+
+    if (!opts) {
+        init_batch_options(&default_opts);
+        opts = &default_opts;
+    }
+
+    if ((listen_fd = open_socket(socket_path, 1)) < 0) {
+        sprintf(error_msg, "Unable to listen on %.400s!", socket_path);
+        return 1;
+    }
+
+    memset(&daemon, 0, sizeof(daemon));
+    for (curr = key_list->head; curr; curr = curr->next)
+        daemon.n_keys++;
+    daemon.keys = (DaemonKey*) calloc(daemon.n_keys ? daemon.n_keys : 1, sizeof(DaemonKey));
+    ALLOC_CHECK(daemon.keys);
+    for (curr = key_list->head, i = 0; curr; curr = curr->next, i++) {
+        Key *key = (Key*)curr->info;
+        daemon.keys[i].key = key;
+        daemon.keys[i].status = cipherInit(&daemon.keys[i].ctx, select_algorithm(key), key->key[0], key->key[1], key->key[2]);
+    }
+
+    jobs = opts->jobs > 0 ? opts->jobs : pool_cpu_count();
+    daemon.pool = pool_create(jobs, jobs * BATCH_WINDOW_PER_JOB);
+    pthread_mutex_init(&daemon.lock, NULL);
+    pthread_cond_init(&daemon.closed, NULL);
+
+    daemon_stop = 0;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = daemon_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &old_int);
+    sigaction(SIGTERM, &sa, &old_term);
+
+    pfd.fd = listen_fd;
+    pfd.events = POLLIN;
+    while (!daemon_stop) {
+        if (poll(&pfd, 1, DAEMON_IDLE_MS) <= 0)
+            continue;
+        if ((fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC)) >= 0)
+            start_connection(&daemon, fd);
+    }
+
+    close(listen_fd);
+    unlink(socket_path);
+
+    /// nove zahteve vise ne citamo; niti veza zavrsavaju kada posalju sve odgovore
+    pthread_mutex_lock(&daemon.lock);
+    for (conn = daemon.conns; conn; conn = conn->next)
+        shutdown(conn->fd, SHUT_RD);
+    while (daemon.n_conns)
+        pthread_cond_wait(&daemon.closed, &daemon.lock);
+    pthread_mutex_unlock(&daemon.lock);
+
+    pool_destroy(daemon.pool, NULL);
+    for (i = 0; i < daemon.n_keys; i++)
+        if (!daemon.keys[i].status)
+            cipherFree(&daemon.keys[i].ctx);
+    free(daemon.keys);
+    pthread_mutex_destroy(&daemon.lock);
+    pthread_cond_destroy(&daemon.closed);
+
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+    return 0;
+}
+
+int daemon_client(const char *socket_path, char op, const char *key_name, char **files, int n_files,
+                  const char *out_dir, FILE *out, char *error_msg) {
+    unsigned char *frame = (unsigned char*) malloc(4 + DAEMON_FRAME_MAX);
+    char *msgs = (char*) malloc((size_t)n_files * DAEMON_MSG_MAX);
+    int *status = (int*) malloc(sizeof(int) * n_files);
+    char *done = (char*) calloc(n_files, 1);
+    char abs[BATCH_PATH_MAX], dir[BATCH_PATH_MAX];
+    int fd, sent = 0, received = 0, printed = 0, result = 0;
+    uint32_t len, id;
+    size_t pos;
+    ALLOC_CHECK(frame);
+    ALLOC_CHECK(msgs);
+    ALLOC_CHECK(status);
+    ALLOC_CHECK(done);
+
+    if ((fd = open_socket(socket_path, 0)) < 0) {
+        sprintf(error_msg, "Unable to connect to %.400s!", socket_path);
+        result = 1;
+    }
+    else if (out_dir && absolute_path(out_dir, dir, sizeof(dir))) {
+        strcpy(error_msg, "Output directory path is too long!");
+        result = 1;
+    }
+
+    while (!result && received < n_files) {
+        if (sent < n_files && sent - received < DAEMON_CLIENT_WINDOW) {
+            /// id, op, key_name\0, ulaz\0, izlaz\0
+            put_u32(frame + 4, sent);
+            frame[8] = op;
+            pos = 9 + sprintf((char*)frame + 9, "%.*s", MAX_KEY_NAME_LEN, key_name) + 1;
+            if (absolute_path(files[sent], abs, sizeof(abs)))
+                abs[0] = '\0';
+            pos += sprintf((char*)frame + pos, "%s", abs) + 1;
+            if (!out_dir || op == DAEMON_OP_VERIFY)
+                len = 0;
+            else if (op == DAEMON_OP_DECRYPT)
+                len = snprintf((char*)frame + pos, BATCH_PATH_MAX, "%s/", dir);
+            else
+                len = snprintf((char*)frame + pos, BATCH_PATH_MAX, "%s/%s.dat", dir, get_filename_from_path(abs));
+            if (len >= BATCH_PATH_MAX)
+                len = 0;
+            frame[pos + len] = '\0';
+            pos += len + 1;
+
+            if (write_frame(fd, frame, pos - 4)) {
+                strcpy(error_msg, "Unable to send request!");
+                result = 1;
+            }
+            sent++;
+            continue;
+        }
+
+        if (read_frame(fd, frame, &len) || len < DAEMON_REPLY_FIXED + 1 || (id = get_u32(frame)) >= (uint32_t)n_files) {
+            strcpy(error_msg, "Connection to the daemon closed!");
+            result = 1;
+            break;
+        }
+        status[id] = (int)get_u32(frame + 4);
+        frame[len - 1] = '\0';
+        snprintf(msgs + (size_t)id * DAEMON_MSG_MAX, DAEMON_MSG_MAX, "%s", (char*)frame + DAEMON_REPLY_FIXED);
+        done[id] = 1;
+        received++;
+
+        /// ishodi se ispisuju redosledom fajlova
+        for (; printed < n_files && done[printed]; printed++) {
+            if (status[printed])
+                fprintf(out, "Error with file %s:%s\n", files[printed], msgs + (size_t)printed * DAEMON_MSG_MAX);
+            else
+                fprintf(out, "File %s %s\n", files[printed], op == DAEMON_OP_ENCRYPT ? "encrypted" :
+                        op == DAEMON_OP_DECRYPT ? "decrypted" : "verified");
+        }
+    }
+
+    if (fd >= 0)
+        close(fd);
+    free(frame);
+    free(msgs);
+    free(status);
+    free(done);
+    return result;
+}
+
+#else
+
+int daemon_serve(const char *socket_path, List *key_list, char *error_msg, BatchOptions *opts) {
+    strcpy(error_msg, "Daemon mode is not supported on Windows!");
+    return 1;
+}
+
+int daemon_client(const char *socket_path, char op, const char *key_name, char **files, int n_files,
+                  const char *out_dir, FILE *out, char *error_msg) {
+    strcpy(error_msg, "Daemon mode is not supported on Windows!");
+    return 1;
+}
+
+#endif // _WIN32
@@ -0,0 +1,71 @@
+/**
+* @file
+* @brief Zaglavlje za rezidentni servis (daemon) i klijenta koji mu salje poslove preko lokalnog
+* Unix soketa.
+* @details Servis jednom ucitava kljuceve i priprema kontekste algoritama (cipher.h), pa se za posao
+* ne placa ni pokretanje procesa ni priprema kljuca. Poruke se salju kao okviri: 4 bajta duzine
+* (big-endian) i zatim sadrzaj okvira.
+*
+* Zahtev: id (4 bajta), operacija (1 bajt: DAEMON_OP_*), zatim naziv kljuca, putanja ulaza i putanja
+* izlaza, svaki zavrsen nulom (prazna putanja izlaza znaci podrazumevanu). Putanje se tumace u odnosu
+* na radni direktorijum servisa, pa klijent salje apsolutne putanje.
+*
+* Odgovor: id zahteva (4 bajta), kod greske iz global.h (4 bajta), broj bajtova originalnog fajla
+* (8 bajtova) i poruka o gresci zavrsena nulom. Odgovori na jednoj vezi stizu redosledom zavrsetka
+* poslova, a ne redosledom zahteva.
+*/
+
+#ifndef _DAEMON_H
+#define _DAEMON_H
+
+#include "list.h"
+#include "batch.h"
+#include <stdio.h>
+
+/**
+* @brief Operacije koje servis podrzava.
+*/
+#define DAEMON_OP_ENCRYPT 'e'
+#define DAEMON_OP_DECRYPT 'd'
+#define DAEMON_OP_VERIFY 'v'
+
+/**
+* @brief Maksimalna duzina okvira (bez 4 bajta duzine).
+*/
+#define DAEMON_FRAME_MAX (2 * BATCH_PATH_MAX + 64)
+
+/**
+* @brief Maksimalan broj poslova koje klijent salje pre nego sto saceka odgovor.
+*/
+#define DAEMON_CLIENT_WINDOW 64
+
+/**
+* @brief Funkcija koja pokrece servis i obradjuje poslove dok ne stigne SIGINT ili SIGTERM.
+* @details Za svaki kljuc iz liste se unapred pravi kontekst algoritma. Svaka veza ima svoju nit koja
+* cita zahteve i zadaje ih zajednickom skupu radnih niti; radna nit salje odgovor cim zavrsi posao.
+* Posle signala servis prestaje da prima nove veze i zahteve, zavrsava zadate poslove i brise soket.
+* @param[in] socket_path Putanja Unix soketa
+* @param[in] key_list Pokazivac na listu ucitanih kljuceva
+* @param[out] error_msg String u koji ce biti upisana poruka o gresci
+* @param[in] opts Opcije (broj radnih niti), NULL za podrazumevane
+* @return 0 ako je servis regularno zavrsen, 1 ukoliko servis nije moguce pokrenuti
+*/
+int daemon_serve(const char *socket_path, List *key_list, char *error_msg, BatchOptions *opts);
+
+/**
+* @brief Funkcija koja salje poslove servisu i ispisuje ishode redosledom fajlova.
+* @details Zahtevi se salju bez cekanja na odgovore, ali najvise DAEMON_CLIENT_WINDOW odjednom.
+* @param[in] socket_path Putanja Unix soketa
+* @param[in] op Operacija (DAEMON_OP_*)
+* @param[in] key_name Naziv kljuca
+* @param[in] files Niz putanja do fajlova
+* @param[in] n_files Broj fajlova
+* @param[in] out_dir Direktorijum za izlaze, NULL za podrazumevane
+* @param[out] out Fajl u koji se ispisuju ishodi ("File X encrypted", "Error with file X:poruka")
+* @param[out] error_msg String u koji ce biti upisana poruka o gresci
+* @return 0 ako su svi odgovori primljeni, 1 u slucaju greske u komunikaciji sa servisom
+*/
+int daemon_client(const char *socket_path, char op, const char *key_name, char **files, int n_files,
+                  const char *out_dir, FILE *out, char *error_msg);
+
+#endif // _DAEMON_H
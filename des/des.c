@@ -8,6 +8,7 @@
 #include <string.h>
 #include "des.h"
 #include "../file_header/file_header.h"
+#include "../rng/rng.h"
 #include "../global.h"
 
 /**
@@ -238,9 +239,9 @@ void charToBin(uc* input, int n)
 /**
 * @brief Funkcija koja od 48-bitnog bloka pravi 32-bitni blok po zadatoj DES specifikaciji.
 * @param[in] expandedMsg 48-bitni blok podataka.
-* @param[out] 32-bitni blok podataka.
+* @param[out] shortenedMsg 32-bitni blok podataka.
 */
-uc *shortenMsg(uc *expandedMsg)
+void shortenMsg(uc *expandedMsg, uc *shortenedMsg)
 {
 	int S1[] = { 14,  4, 13,  1,  2, 15, 11,  8,  3, 10,  6, 12,  5,  9,  0,  7,
 		0, 15,  7,  4, 14,  2, 13,  1, 10,  6, 12, 11,  9,  5,  3,  8,
@@ -283,7 +284,6 @@ uc *shortenMsg(uc *expandedMsg)
 		2,  1, 14,  7,  4, 10,  8, 13, 15, 12,  9,  0,  3,  5,  6, 11 };
 
 	int row, column;
-	uc shortenedMsg[4];
 	memset(shortenedMsg, 0, 4);
 
 	row = column = 0;
@@ -345,8 +345,6 @@ uc *shortenMsg(uc *expandedMsg)
 	column |= ((expandedMsg[5] & 0x1E) >> 1);
 
 	shortenedMsg[3] |= (uc)S8[row * 16 + column];
-
-	return shortenedMsg;
 }
 
 
@@ -375,7 +373,7 @@ void f(uc *R, uc *K, uc *output)
 		19, 13, 30,  6,
 		22, 11,  4, 25 };
 	int i;
-	uc expandedMsg[6], *shortenedMsg;
+	uc expandedMsg[6], shortenedMsg[4];
 	memset(expandedMsg, 0, 6);
 
 	for (i = 0; i<48; i++)
@@ -386,7 +384,7 @@ void f(uc *R, uc *K, uc *output)
 		expandedMsg[i] ^= K[i];
 
 
-	shortenedMsg = shortenMsg(expandedMsg);
+	shortenMsg(expandedMsg, shortenedMsg);
 
 
 	for (i = 0; i<4; i++)
@@ -552,8 +550,7 @@ int desDecryptFileECB(char *name, uc* key)
 	out = fopen(outPath, "rb");
 	if (out != NULL) {
 		fclose(out);
-		srand(time(NULL));
-		sprintf(get_filename_from_path(outPath), "%d\0", rand());
+		sprintf(get_filename_from_path(outPath), "%d\0", (int) (rngU32() >> 1));
 		strcat(outPath, (char*)head.fileName);
 	}
 
@@ -710,8 +707,7 @@ int desDecryptFileCBC(char *name, uc* key)
 	out = fopen(outPath, "rb");
 	if (out != NULL) {
 		fclose(out);
-		srand(time(NULL));
-		sprintf(get_filename_from_path(outPath), "%d\0", rand());
+		sprintf(get_filename_from_path(outPath), "%d\0", (int) (rngU32() >> 1));
 		strcat(outPath, (char*)head.fileName);
 	}
 
@@ -894,8 +890,7 @@ int tdesDecryptFileECB(char *name, uc* key1, uc* key2, uc* key3)
 	out = fopen(outPath, "rb");
 	if (out != NULL) {
 		fclose(out);
-		srand(time(NULL));
-		sprintf(get_filename_from_path(outPath), "%d\0", rand());
+		sprintf(get_filename_from_path(outPath), "%d\0", (int) (rngU32() >> 1));
 		strcat(outPath, (char*)head.fileName);
 	}
 
@@ -1069,8 +1064,7 @@ int tdesDecryptFileCBC(char *name, uc* key1, uc* key2, uc* key3)
 	out = fopen(outPath, "rb");
 	if (out != NULL) {
 		fclose(out);
-		srand(time(NULL));
-		sprintf(get_filename_from_path(outPath), "%d\0", rand());
+		sprintf(get_filename_from_path(outPath), "%d\0", (int) (rngU32() >> 1));
 		strcat(outPath, (char*)head.fileName);
 	}
 
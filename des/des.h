@@ -9,6 +9,46 @@
 
 #include "../global.h"
 
+/**
+* @brief Funkcija koja od 56-bitnog kljuca pravi 64-bitni ciji svaki bajt ima neparan broj jedinica.
+* @param[in] key Ulazni 56-bitni kljuc.
+* @param[out] ekey Izlazni 64-bitni kljuc.
+*/
+void desExpandKey(uc* key, uc *ekey);
+
+/**
+* @brief Funkcija koja od jednog 64-bitnog kljuca generise matricu 16 48-bitnih kljuceva.
+* @param[in] key 64-bitni kljuc.
+* @return Matrica 16 48-bitnih kljuceva.
+*/
+uc** keyGenerate(uc* key);
+
+/**
+* @brief Funkcija za oslobadjanje dinamicke matrice kljuceva dobijene keyGenerate funkcijom.
+* @param[in] keys Matrica kljuceva dobijena keyGenerate funkcijom.
+*/
+void freeKeys(uc **keys);
+
+/**
+* @brief Funkcija za enkripciju/dekripciju jednog 64-bitnog bloka DES algoritmom.
+* @param[in] input 64-bitni blok za enkripciju/dekripciju.
+* @param[in] subKeys Matrica od 16 kljuceva kreiranih keyGenerate funkcijom.
+* @param[in] mode 0 za enkripciju, 1 za dekripciju.
+* @param[out] output 64-bitni rezultujuci blok.
+*/
+void desEncodeBlock(uc *input, uc **subKeys, int mode, uc *output);
+
+/**
+* @brief Funkcija za enkripciju/dekripciju jednog 64-bitnog bloka tDES algoritmom.
+* @param[in] input 64-bitni blok za enkripciju/dekripciju.
+* @param[in] subKeys1 Matrica kljuceva prvog kljuca.
+* @param[in] subKeys2 Matrica kljuceva drugog kljuca.
+* @param[in] subKeys3 Matrica kljuceva treceg kljuca.
+* @param[in] mode 0 za enkripciju, 1 za dekripciju.
+* @param[out] output 64-bitni rezultujuci blok.
+*/
+int tdesEncodeBlock(uc *input, uc **subKeys1, uc **subKeys2, uc **subKeys3, int mode, uc *output);
+
 /**
 * @brief Funkcija za enkripciju fajla DES algoritmom u ECB modu.
 * @param[in] name Path fajla koji treba dekriptovati.
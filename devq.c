@@ -0,0 +1,258 @@
+/**
+* @file
+* @brief Funkcije za redove zadataka po uredjaju.
+* @details Red postoji za svaki par uredjaja ulaza i izlaza, a ogranicenje za svaki uredjaj. Zadatak
+* ceka u redu samo dok neki od njegovih uredjaja ima bar jedan zadatak u izvrsavanju, pa ga uvek
+* preuzme nit koja zavrsi zadatak tog uredjaja; zbog toga pool_wait vidi sve zadatke, i one iz redova.
+*/
+
+#include "devq.h"
+#include "global.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <sys/sysmacros.h>
+#endif
+
+/**
+* @brief Zadatak u redu uredjaja.
+*/
+typedef struct DevTask {
+    TaskFunc func;
+    void *arg;
+    DevQueue *queue;
+    struct DevTask *next;
+} DevTask;
+
+/**
+* @brief Uredjaj i broj zadataka koji trenutno rade sa njim.
+*/
+typedef struct Device {
+    dev_t dev;
+    int limit;                  /**< 0 bez ogranicenja */
+    int active;
+    struct Device *next;
+} Device;
+
+static void submit_ready(DevQueues *devs, DevTask *task);
+
+struct DevQueue {
+    DevQueues *devs;
+    Device *in;
+    Device *out;                /**< NULL kada je izlaz na uredjaju ulaza */
+    DevTask *head, *tail;
+    DevQueue *next;
+};
+
+struct DevQueues {
+    ThreadPool *pool;
+    int jobs;
+    Device *devices;
+    DevQueue *queues;
+    pthread_mutex_t lock;
+};
+
+/*********************** INTERNAL FUNCTIONS ***********************/
+/**
+* @brief Funkcija koja odredjuje ogranicenje za uredjaj prema tome da li je rotacioni.
+*/
+static int device_limit(dev_t dev) {
+#ifdef __linux__
+    char path[64];
+    FILE *f;
+    int c = EOF;
+
+    /// za particiju se podatak nalazi u direktorijumu celog diska
+    snprintf(path, sizeof(path), "/sys/dev/block/%u:%u/queue/rotational", major(dev), minor(dev));
+    if (!(f = fopen(path, "r"))) {
+        snprintf(path, sizeof(path), "/sys/dev/block/%u:%u/../queue/rotational", major(dev), minor(dev));
+        f = fopen(path, "r");
+    }
+    if (f) {
+        c = fgetc(f);
+        fclose(f);
+    }
+    if (c == '1')
+        return DEVQ_HDD_JOBS;
+    if (c == '0')
+        return DEVQ_SSD_JOBS;
+#endif
+    return 0;
+}
+
+/**
+* @brief Funkcija koja vraca uredjaj i pravi ga ukoliko ne postoji. Poziva se dok je lock zakljucan.
+*/
+static Device* get_device(DevQueues *devs, dev_t dev) {
+    Device *device;
+
+    for (device = devs->devices; device; device = device->next)
+        if (device->dev == dev)
+            return device;
+
+    device = (Device*) calloc(1, sizeof(Device));
+    ALLOC_CHECK(device);
+    device->dev = dev;
+    device->limit = devs->jobs ? devs->jobs : device_limit(dev);
+    device->next = devs->devices;
+    devs->devices = device;
+    return device;
+}
+
+/**
+* @brief Funkcija koja proverava da li uredjaj ima slobodno mesto.
+*/
+static int has_slot(Device *device) {
+    return !device || !device->limit || device->active < device->limit;
+}
+
+/**
+* @brief Funkcija koja zauzima mesto na oba uredjaja reda. Mesta se zauzimaju zajedno, pod lock-om,
+* pa zadatak nikada ne drzi jedan uredjaj dok ceka drugi i zadaci ne mogu da se zaglave.
+* @return 1 ukoliko su mesta zauzeta, 0 ukoliko neki od uredjaja nema slobodno mesto
+*/
+static int acquire_slots(DevQueue *queue) {
+    if (!has_slot(queue->in) || !has_slot(queue->out))
+        return 0;
+    queue->in->active++;
+    if (queue->out)
+        queue->out->active++;
+    return 1;
+}
+
+/**
+* @brief Funkcija koja iz redova izdvaja zadatke za koje su sada oba uredjaja slobodna, redom kojim
+* su zadati. Poziva se dok je lock zakljucan.
+* @return Izdvojeni zadaci ili NULL
+*/
+static DevTask* take_ready(DevQueues *devs) {
+    DevTask *ready = NULL, **tail = &ready;
+    DevQueue *queue;
+
+    for (queue = devs->queues; queue; queue = queue->next)
+        while (queue->head && acquire_slots(queue)) {
+            *tail = queue->head;
+            tail = &queue->head->next;
+            if (!(queue->head = queue->head->next))
+                queue->tail = NULL;
+        }
+    *tail = NULL;
+    return ready;
+}
+
+/**
+* @brief Funkcija koju izvrsava radna nit: izvrsava zadatak, oslobadja oba uredjaja i predaje zadatke
+* koji su cekali na njih.
+* @param[in] arg Pokazivac na DevTask
+*/
+static void run_task(void *arg) {
+    DevTask *task = (DevTask*)arg;
+    DevQueue *queue = task->queue;
+    DevQueues *devs = queue->devs;
+    DevTask *ready;
+
+    task->func(task->arg);
+    free(task);
+
+    pthread_mutex_lock(&devs->lock);
+    queue->in->active--;
+    if (queue->out)
+        queue->out->active--;
+    ready = take_ready(devs);
+    pthread_mutex_unlock(&devs->lock);
+
+    submit_ready(devs, ready);
+}
+
+/**
+* @brief Funkcija koja predaje izdvojene zadatke skupu niti.
+*/
+static void submit_ready(DevQueues *devs, DevTask *task) {
+    DevTask *next;
+
+    for (; task; task = next) {
+        next = task->next;
+        pool_submit(devs->pool, run_task, task);
+    }
+}
+
+/*********************** EXTERNAL FUNCTIONS ***********************/
+DevQueues* devq_create(ThreadPool *pool, int jobs) {
+    DevQueues *devs = (DevQueues*) calloc(1, sizeof(DevQueues));
+    ALLOC_CHECK(devs);
+
+    devs->pool = pool;
+    devs->jobs = jobs;
+    pthread_mutex_init(&devs->lock, NULL);
+    return devs;
+}
+
+DevQueue* devq_get(DevQueues *devs, dev_t in_dev, dev_t out_dev) {
+    DevQueue *queue;
+    Device *in, *out;
+
+    pthread_mutex_lock(&devs->lock);
+    in = get_device(devs, in_dev);
+    out = out_dev == in_dev ? NULL : get_device(devs, out_dev);
+    for (queue = devs->queues; queue; queue = queue->next)
+        if (queue->in == in && queue->out == out)
+            break;
+    if (!queue) {
+        queue = (DevQueue*) calloc(1, sizeof(DevQueue));
+        ALLOC_CHECK(queue);
+        queue->devs = devs;
+        queue->in = in;
+        queue->out = out;
+        queue->next = devs->queues;
+        devs->queues = queue;
+    }
+    pthread_mutex_unlock(&devs->lock);
+    return queue;
+}
+
+void devq_submit(DevQueue *queue, TaskFunc func, void *arg) {
+    DevQueues *devs = queue->devs;
+    DevTask *task;
+
+    /// ogranicenja uredjaja se ne menjaju, pa se citaju bez lock-a
+    if (!queue->in->limit && (!queue->out || !queue->out->limit)) {
+        pool_submit(devs->pool, func, arg);
+        return;
+    }
+
+    task = (DevTask*) malloc(sizeof(DevTask));
+    ALLOC_CHECK(task);
+    task->func = func;
+    task->arg = arg;
+    task->queue = queue;
+    task->next = NULL;
+
+    pthread_mutex_lock(&devs->lock);
+    if (queue->tail)
+        queue->tail->next = task;
+    else
+        queue->head = task;
+    queue->tail = task;
+    task = take_ready(devs);
+    pthread_mutex_unlock(&devs->lock);
+
+    submit_ready(devs, task);
+}
+
+void devq_destroy(DevQueues *devs) {
+    DevQueue *queue, *next;
+    Device *device, *next_device;
+
+    for (queue = devs->queues; queue; queue = next) {
+        next = queue->next;
+        free(queue);
+    }
+    for (device = devs->devices; device; device = next_device) {
+        next_device = device->next;
+        free(device);
+    }
+    pthread_mutex_destroy(&devs->lock);
+    free(devs);
+}
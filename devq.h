@@ -0,0 +1,72 @@
+/**
+* @file
+* @brief Zaglavlje za redove zadataka po uredjaju (st_dev), koji ogranicavaju broj zadataka koji
+* istovremeno rade sa istim diskom.
+* @details Svaki uredjaj ima svoje ogranicenje: DEVQ_HDD_JOBS za rotacione diskove i DEVQ_SSD_JOBS
+* za ostale blok uredjaje (podatak iz /sys/dev/block). Za uredjaje bez tog podatka (tmpfs, mrezni
+* fajl sistemi) ogranicenja nema. Zadatak zauzima mesto i na uredjaju ulaza i na uredjaju izlaza:
+* predaje se skupu niti odmah ukoliko oba imaju slobodno mesto, a u suprotnom ceka u redu svog para
+* uredjaja dok se ne zavrsi neki zadatak zauzetog uredjaja. Tako niti ne cekaju na jedan disk dok su
+* ostali slobodni.
+*/
+
+#ifndef _DEVQ_H
+#define _DEVQ_H
+
+#include "pool.h"
+#include <sys/types.h>
+
+/**
+* @brief Najveci broj istovremenih zadataka za rotacioni disk.
+*/
+#define DEVQ_HDD_JOBS 2
+
+/**
+* @brief Najveci broj istovremenih zadataka za disk bez pokretnih delova (SSD, NVMe).
+*/
+#define DEVQ_SSD_JOBS 16
+
+/**
+* @brief Struktura svih redova jedne obrade.
+*/
+typedef struct DevQueues DevQueues;
+
+/**
+* @brief Struktura reda jednog para uredjaja ulaza i izlaza.
+*/
+typedef struct DevQueue DevQueue;
+
+/**
+* @brief Funkcija za pravljenje redova.
+* @param[in] pool Skup niti kome se predaju zadaci
+* @param[in] jobs Ogranicenje za sve uredjaje, 0 za ogranicenje prema vrsti uredjaja
+* @return Pokazivac na redove
+*/
+DevQueues* devq_create(ThreadPool *pool, int jobs);
+
+/**
+* @brief Funkcija koja vraca red za fajl, zajednicki za sve fajlove sa istim uredjajima ulaza i
+* izlaza. Moze se pozivati iz vise niti.
+* @param[in] devs Pokazivac na redove
+* @param[in] in_dev Uredjaj ulaza
+* @param[in] out_dev Uredjaj izlaza
+* @return Pokazivac na red
+*/
+DevQueue* devq_get(DevQueues *devs, dev_t in_dev, dev_t out_dev);
+
+/**
+* @brief Funkcija za zadavanje zadatka u red para uredjaja. Zadatak drzi mesto na oba uredjaja dok
+* se izvrsava. Moze se pozivati iz vise niti.
+* @param[in] queue Pokazivac na red
+* @param[in] func Funkcija koju treba izvrsiti
+* @param[in] arg Argument funkcije
+*/
+void devq_submit(DevQueue *queue, TaskFunc func, void *arg);
+
+/**
+* @brief Funkcija koja oslobadja redove. Poziva se posto su svi zadaci zavrseni (pool_wait).
+* @param[in] devs Pokazivac na redove
+*/
+void devq_destroy(DevQueues *devs);
+
+#endif // _DEVQ_H
@@ -5,88 +5,63 @@
  * @brief   Enkripcija/dekripcija fajlova
  * @details Ovaj fajl sadrzi implementaciju funkcija koje objedinjuju sve algoritme za enkripciju i dekripciju fajlova.
             Koristi se tako sto funkcijama prosledi enum Algorithm zeljenog algortima.
+            Svi algoritmi se izvrsavaju preko zajednickog konteksta (cipher/cipher.h) i
+            citanja/pisanja u vecim blokovima (io/stream.h); format .dat fajla je nepromenjen.
  */
 
 #include "encryption.h"
-#include "des/des.h"
-#include "aes/aes_file_handler.h"
+#include "cipher/cipher.h"
+#include "io/stream.h"
+#include "io/inplace.h"
 
 int encryptFile(char *name, uc* key1, uc* key2, uc* key3, Algorithm mode)
 {
-	switch (mode)
-	{
-		case des_ecb:
-			return desEncryptFileECB(name, key1);
-			break;
-	    case des_cbc:
-			return desEncryptFileCBC(name, key1);
-			break;
-		case tdes_ecb:
-			return tdesEncryptFileECB(name, key1, key2, key3);
-			break;
-		case tdes_cbc:
-			return tdesEncryptFileCBC(name, key1, key2, key3);
-			break;
-        case aes128_ecb:
-            return aesEncryptFile(name, key1, 4, ECB);
-            break;
-        case aes128_cbc:
-            return aesEncryptFile(name, key1, 4, CBC);
-            break;
-        case aes192_ecb:
-            return aesEncryptFile(name, key1, 6, ECB);
-            break;
-        case aes192_cbc:
-            return aesEncryptFile(name, key1, 6, CBC);
-            break;
-        case aes256_ecb:
-            return aesEncryptFile(name, key1, 8, ECB);
-            break;
-        case aes256_cbc:
-            return aesEncryptFile(name, key1, 8, CBC);
-            break;
-        default:
-            return UNKNOWN_ALG;
-            break;
-	}
+    cipherctx_t ctx;
+    int status;
+
+    if ((status = cipherInit(&ctx, mode, key1, key2, key3)))
+        return status;
+
+    status = streamEncryptFile(&ctx, name, NULL, NULL);
+    cipherFree(&ctx);
+    return status;
 }
 
 int decryptFile(char *name, uc* key1, uc* key2, uc* key3, Algorithm mode)
 {
-	switch (mode)
-	{
-        case des_ecb:
-            return desDecryptFileECB(name, key1);
-            break;
-        case des_cbc:
-            return desDecryptFileCBC(name, key1);
-            break;
-        case tdes_ecb:
-            return tdesDecryptFileECB(name, key1, key2, key3);
-            break;
-        case tdes_cbc:
-            return tdesDecryptFileCBC(name, key1, key2, key3);
-            break;
-        case aes128_ecb:
-            return aesDecryptFile(name, key1, 4, ECB);
-            break;
-        case aes128_cbc:
-            return aesDecryptFile(name, key1, 4, CBC);
-            break;
-        case aes192_ecb:
-            return aesDecryptFile(name, key1, 6, ECB);
-            break;
-        case aes192_cbc:
-            return aesDecryptFile(name, key1, 6, CBC);
-            break;
-        case aes256_ecb:
-            return aesDecryptFile(name, key1, 8, ECB);
-            break;
-        case aes256_cbc:
-            return aesDecryptFile(name, key1, 8, CBC);
-            break;
-        default:
-            return UNKNOWN_ALG;
-            break;
-	}
+    cipherctx_t ctx;
+    int status;
+
+    if ((status = cipherInit(&ctx, mode, key1, key2, key3)))
+        return status;
+
+    status = streamDecryptFile(&ctx, name, NULL, NULL);
+    cipherFree(&ctx);
+    return status;
+}
+
+int encryptFileInPlace(char *name, uc* key1, uc* key2, uc* key3, Algorithm mode)
+{
+    cipherctx_t ctx;
+    int status;
+
+    if ((status = cipherInit(&ctx, mode, key1, key2, key3)))
+        return status;
+
+    status = inplaceEncryptFile(&ctx, name, NULL);
+    cipherFree(&ctx);
+    return status;
+}
+
+int decryptFileInPlace(char *name, uc* key1, uc* key2, uc* key3, Algorithm mode)
+{
+    cipherctx_t ctx;
+    int status;
+
+    if ((status = cipherInit(&ctx, mode, key1, key2, key3)))
+        return status;
+
+    status = inplaceDecryptFile(&ctx, name, NULL);
+    cipherFree(&ctx);
+    return status;
 }
@@ -45,4 +45,33 @@ int encryptFile(char *filePath, uc* key1, uc* key2, uc* key3, Algorithm mode);
  */
 int decryptFile(char *filePath, uc* key1, uc* key2, uc* key3, Algorithm mode);
 
+/**
+ * @brief     Funkcija za enkripciju fajla u mestu (io/inplace.h)
+ * @param[in] filePath  Put do fajla
+ * @param[in] key1      Kluc za sve algoritme
+ * @param[in] key2      Drugi kljuc u slucaju Triple-DES algoritma
+ * @param[in] key3      Treci kljuc u slucaju Triple-DES algoritma
+ * @param[in] mode      Flag zeljenog algorima
+ * @details   Funkcija prepisuje fajl enkriptovanim sadrzajem i preimenuje ga dodavanjem .dat ekstenzije,
+              bez pravljenja druge kopije. Prekinuta enkripcija se nastavlja ponovnim pozivom.
+ * @return    Prilikom korektne enkripcije vraca nulu.
+ *            U slucaju greske vraca jedan od signala definisanih u global.h
+ */
+int encryptFileInPlace(char *filePath, uc* key1, uc* key2, uc* key3, Algorithm mode);
+
+/**
+ * @brief     Funkcija za dekripciju fajla u mestu (io/inplace.h)
+ * @param[in] filePath  Put do fajla
+ * @param[in] key1      Kluc za sve algoritme
+ * @param[in] key2      Drugi kljuc u slucaju Triple-DES algoritma
+ * @param[in] key3      Treci kljuc u slucaju Triple-DES algoritma
+ * @param[in] mode      Flag zeljenog algorima
+ * @details   Funkcija prepisuje fajl dekriptovanim sadrzajem i preimenuje ga u originalno ime (uz slucajan
+              broj na pocetku imena ukoliko fajl sa tim imenom postoji). Prekinuta dekripcija se nastavlja
+              ponovnim pozivom.
+ * @return    Prilikom korektne dekripcije vraca nulu.
+ *            U slucaju greske vraca jedan od signala definisanih u global.h
+ */
+int decryptFileInPlace(char *filePath, uc* key1, uc* key2, uc* key3, Algorithm mode);
+
 #endif // _ENCRYPTION_H_
@@ -10,6 +10,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "file_header.h"
+#include "../rng/rng.h"
 
 #define READ_BLOCK_MAX 16
 
@@ -55,7 +56,7 @@ fileheader_t headerCreate(FILE *file, const char *fileName)
 {
     uint32_t crc = ~0U;
 	uint8_t readBlock[READ_BLOCK_MAX];
-	uint32_t bytesRead, i;
+	uint32_t bytesRead;
     fileheader_t header;
 
     strcpy(header.fileName, fileName);
@@ -65,17 +66,14 @@ fileheader_t headerCreate(FILE *file, const char *fileName)
     while ((bytesRead = fread(&readBlock, sizeof(uint8_t), READ_BLOCK_MAX, file)) > 0)
 	{
 		header.byteLength += bytesRead;
-		for (i = 0; i < bytesRead; ++i)
-			crc = crc32Table[(crc ^ readBlock[i]) & 0xFF] ^ (crc >> 8);
+		crc = crc32Update(crc, readBlock, bytesRead);
 	}
 
 	rewind(file);
 
     header.crc = crc & 0xFFFFFFFF;
 
-    srand(time(NULL));
-	for (i = 0; i < 16; i++)
-		header.IV[i] = rand();
+    rngBytes(header.IV, sizeof(header.IV));
 
     return header;
 }
@@ -95,6 +93,85 @@ int headerCheck(FILE *file, fileheader_t *oldHeader)
     return oldHeader->crc != newHeader.crc;
 }
 
+uint32_t crc32Update(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    while (len--)
+        crc = crc32Table[(crc ^ *buf++) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+/**
+* @brief Funkcija koja mnozi vektor matricom nad GF(2).
+* @private
+*/
+static uint32_t gf2MatrixTimes(const uint32_t *mat, uint32_t vec)
+{
+    uint32_t sum = 0;
+    while (vec)
+    {
+        if (vec & 1)
+            sum ^= *mat;
+        vec >>= 1;
+        mat++;
+    }
+    return sum;
+}
+
+/**
+* @brief Funkcija koja kvadrira matricu nad GF(2).
+* @private
+*/
+static void gf2MatrixSquare(uint32_t *square, const uint32_t *mat)
+{
+    int n;
+    for (n = 0; n < 32; n++)
+        square[n] = gf2MatrixTimes(mat, mat[n]);
+}
+
+uint32_t crc32Combine(uint32_t crc1, uint32_t crc2, uint64_t len2)
+{
+    uint32_t even[32], odd[32], row = 1;
+    int n;
+
+    if (len2 == 0)
+        return crc1;
+
+    /// operator za jedan nulti bit
+    odd[0] = 0xedb88320;
+    for (n = 1; n < 32; n++)
+    {
+        odd[n] = row;
+        row <<= 1;
+    }
+    gf2MatrixSquare(even, odd);     /// dva bita
+    gf2MatrixSquare(odd, even);     /// cetiri bita
+
+    /// pocetna vrednost ~0 drugog dela se ponistava sa ~0 koje se pomera kroz len2 bajtova
+    crc1 ^= 0xFFFFFFFF;
+    do
+    {
+        gf2MatrixSquare(even, odd);
+        if (len2 & 1)
+            crc1 = gf2MatrixTimes(even, crc1);
+        len2 >>= 1;
+        if (!len2)
+            break;
+
+        gf2MatrixSquare(odd, even);
+        if (len2 & 1)
+            crc1 = gf2MatrixTimes(odd, crc1);
+        len2 >>= 1;
+    } while (len2);
+
+    return crc1 ^ crc2;
+}
+
+uint32_t crc32Zeros(uint32_t crc, uint64_t len)
+{
+    /// crc32Combine pomera crc1 ^ ~0 kroz len2 bajtova; nule od registra 0 daju 0, pa drugi deo nestaje
+    return crc32Combine(crc ^ 0xFFFFFFFF, 0, len);
+}
+
 void headerPrint(fileheader_t *header)
 {
     printf("fileName: %s\n", header->fileName);
@@ -11,6 +11,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include "../global.h"
 
 /**
@@ -18,9 +19,16 @@
 */
 #define FILENAME_LEN_MAX 256
 
+/**
+* @brief Vrednost polja pad za .dat fajl sa rupama (io/stream.h): rupe nisu sifrovane, a njihova
+* mapa je posle podataka.
+*/
+#define HEADER_SPARSE 1
+
 /**
 * @brief Struktura hedera fajla, sadrzi ime fajla, njegovu duzinu u 
 * bajtovima, njegov CRC-32 i IV koji je neophodan za CBC mod.
+* Polje pad je 0, osim za fajl sa rupama (HEADER_SPARSE).
 */
 typedef struct
 {
@@ -47,6 +55,33 @@ fileheader_t headerCreate(FILE *file, const char *fileName);
 */
 int          headerCheck(FILE *file, fileheader_t *header);
 
+/**
+* @brief Funkcija koja nastavlja racunanje CRC-32 nad novim baferom.
+* @param[in] crc Trenutna vrednost CRC registra (~0 na pocetku fajla).
+* @param[in] buf Bafer sa podacima.
+* @param[in] len Duzina bafera.
+* @return Nova vrednost CRC registra, u istom obliku u kom se cuva u hederu.
+*/
+uint32_t     crc32Update(uint32_t crc, const uint8_t *buf, size_t len);
+
+/**
+* @brief Funkcija koja spaja CRC dva uzastopna dela fajla.
+* @param[in] crc1 CRC registar prvog dela (racunat od ~0).
+* @param[in] crc2 CRC registar drugog dela (racunat od ~0).
+* @param[in] len2 Duzina drugog dela u bajtovima.
+* @return CRC registar celog fajla, kao da je racunat jednim prolazom.
+* @details Omogucava da se veliki fajl obradjuje paralelno u delovima.
+*/
+uint32_t     crc32Combine(uint32_t crc1, uint32_t crc2, uint64_t len2);
+
+/**
+* @brief Funkcija koja nastavlja racunanje CRC-32 nad len nultih bajtova, bez prolaza kroz njih.
+* @param[in] crc Trenutna vrednost CRC registra.
+* @param[in] len Broj nultih bajtova.
+* @return Nova vrednost CRC registra.
+*/
+uint32_t     crc32Zeros(uint32_t crc, uint64_t len);
+
 /**
 * @private
 */
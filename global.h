@@ -40,6 +40,11 @@
 */
 #define UNKNOWN_ALG  4
 
+/**
+* @brief Greska pri citanju ili pisanju fajla.
+*/
+#define IO_ERR       5
+
 typedef unsigned char uc;
 
 #endif // _GLOBAL_H_
@@ -0,0 +1,236 @@
+/**
+* @file
+* @brief Enkripcija velikih fajlova u CBC modu sa kontrolnim tackama.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "checkpoint.h"
+#include "stream.h"
+
+/**
+* @brief Oznaka na pocetku zapisa kontrolne tacke.
+*/
+#define CHECKPOINT_MAGIC 0x54504B43
+
+/**
+* @brief Verzija zapisa kontrolne tacke.
+*/
+#define CHECKPOINT_VERSION 2
+
+/**
+* @brief Zapis kontrolne tacke.
+*/
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t algo;
+    uint32_t keyCheck;      /**< CRC sifrovanog nultog bloka, razlikuje kljuceve */
+    uint64_t inSize;
+    int64_t inMtimeSec;     /**< Vreme izmene ulaza, sa nanosekundama */
+    int64_t inMtimeNsec;
+    uint64_t inIno;
+    uint64_t doneBlocks;    /**< Broj blokova upisanih pre kontrolne tacke */
+    uint32_t crc;           /**< CRC registar originalnih bajtova tih blokova */
+    uc iv[CIPHER_BLOCK_MAX];        /**< IV iz hedera */
+    uc chain[CIPHER_BLOCK_MAX];     /**< Poslednji sifrovani blok */
+    uint32_t recordCrc;     /**< CRC svih prethodnih polja */
+} checkpoint_t;
+
+/**
+* @brief Funkcija koja pravi putanju kontrolne tacke za izlaz.
+* @return 0 ili -1 ukoliko je putanja preduga.
+* @private
+*/
+static int checkpointPath(char *path, const char *inPath, const char *outPath)
+{
+    int len;
+
+    if (outPath)
+        len = snprintf(path, STREAM_PATH_MAX, "%s" CHECKPOINT_SUFFIX, outPath);
+    else
+        len = snprintf(path, STREAM_PATH_MAX, "%s.dat" CHECKPOINT_SUFFIX, inPath);
+    return len >= 0 && len < STREAM_PATH_MAX ? 0 : -1;
+}
+
+/**
+* @brief Funkcija koja racuna otisak kljuca (CRC sifrovanog nultog bloka).
+* @private
+*/
+static uint32_t keyCheck(cipherctx_t *ctx)
+{
+    uc block[CIPHER_BLOCK_MAX] = {0}, iv[CIPHER_BLOCK_MAX] = {0};
+
+    cipherEncrypt(ctx, block, ctx->blockSize, ctx->cbc ? iv : NULL);
+    return crc32Update(~0U, block, ctx->blockSize);
+}
+
+/**
+* @brief Funkcija koja popunjava deo zapisa koji ne zavisi od napretka obrade.
+* @return 0 ili -1 ukoliko ulaz ne moze da se procita.
+* @private
+*/
+static int describeInput(checkpoint_t *ck, cipherctx_t *ctx, const char *inPath)
+{
+    struct stat st;
+
+    if (stat(inPath, &st))
+        return -1;
+
+    memset(ck, 0, sizeof(*ck));
+    ck->magic = CHECKPOINT_MAGIC;
+    ck->version = CHECKPOINT_VERSION;
+    ck->algo = ctx->algo;
+    ck->keyCheck = keyCheck(ctx);
+    ck->inSize = st.st_size;
+    ck->inMtimeSec = st.st_mtim.tv_sec;
+    ck->inMtimeNsec = st.st_mtim.tv_nsec;
+    ck->inIno = st.st_ino;
+    return 0;
+}
+
+/**
+* @brief Funkcija koja ucitava kontrolnu tacku i proverava je u odnosu na ulaz i izlaz na disku.
+* @return 0 ukoliko se obrada moze nastaviti od kontrolne tacke, -1 u suprotnom.
+* @private
+*/
+static int loadCheckpoint(checkpoint_t *ck, cipherctx_t *ctx, const char *inPath, const char *ckPath,
+                          const char *outPath)
+{
+    checkpoint_t expected;
+    uc block[CIPHER_BLOCK_MAX];
+    char tmpPath[STREAM_PATH_MAX];
+    int fd, bs = ctx->blockSize, ok, len;
+
+    if (describeInput(&expected, ctx, inPath))
+        return -1;
+
+    if ((fd = open(ckPath, O_RDONLY)) < 0)
+        return -1;
+    ok = read(fd, ck, sizeof(*ck)) == sizeof(*ck);
+    close(fd);
+
+    if (!ok || ck->recordCrc != crc32Update(~0U, (uc*) ck, offsetof(checkpoint_t, recordCrc)) ||
+        ck->magic != expected.magic || ck->version != expected.version || ck->algo != expected.algo ||
+        ck->keyCheck != expected.keyCheck || ck->inSize != expected.inSize ||
+        ck->inMtimeSec != expected.inMtimeSec || ck->inMtimeNsec != expected.inMtimeNsec ||
+        ck->inIno != expected.inIno ||
+        !ck->doneBlocks || ck->doneBlocks * bs >= ck->inSize + bs)
+        return -1;
+
+    /// poslednji upisani blok mora biti bas onaj od kog se nastavlja lanac
+    len = snprintf(tmpPath, sizeof(tmpPath), "%s" STREAM_TMP_SUFFIX, outPath);
+    if (len < 0 || (size_t) len >= sizeof(tmpPath) || (fd = open(tmpPath, O_RDONLY)) < 0)
+        return -1;
+    ok = pread(fd, block, bs, ctx->headerSize + (ck->doneBlocks - 1) * bs) == bs &&
+         !memcmp(block, ck->chain, bs);
+    close(fd);
+
+    return ok ? 0 : -1;
+}
+
+/**
+* @brief Funkcija koja spusta upisane podatke na disk i zatim upisuje kontrolnu tacku.
+* @return 0 ukoliko je kontrolna tacka na disku, -1 u suprotnom.
+* @private
+*/
+static int saveCheckpoint(int fd, streamjob_t *job, checkpoint_t *ck)
+{
+    if (fdatasync(job->outFd))
+        return -1;
+
+    ck->recordCrc = crc32Update(~0U, (uc*) ck, offsetof(checkpoint_t, recordCrc));
+    if (pwrite(fd, ck, sizeof(*ck), 0) != (ssize_t) sizeof(*ck))
+        return -1;
+    return fdatasync(fd) ? -1 : 0;
+}
+
+int checkpointEncryptFile(cipherctx_t *ctx, const char *inPath, const char *outPath, int resume, uint64_t *length)
+{
+    streamjob_t job;
+    checkpoint_t ck;
+    char ckPath[STREAM_PATH_MAX], out[STREAM_PATH_MAX];
+    uc iv[CIPHER_BLOCK_MAX];
+    uint64_t first = 0, count, step = CHECKPOINT_INTERVAL / ctx->blockSize;
+    uint32_t crc = ~0U, rangeCrc;
+    int status, fd = -1, bs = ctx->blockSize, saved = 0;
+
+    if (checkpointPath(ckPath, inPath, outPath))
+        return streamEncryptFile(ctx, inPath, outPath, length);
+
+    snprintf(out, sizeof(out), "%.*s", (int) (strlen(ckPath) - strlen(CHECKPOINT_SUFFIX)), ckPath);
+
+    if (resume && !loadCheckpoint(&ck, ctx, inPath, ckPath, out) &&
+        !streamEncryptReopen(&job, ctx, inPath, out, ck.iv))
+    {
+        first = ck.doneBlocks;
+        crc = ck.crc;
+        memcpy(iv, ck.chain, bs);
+        saved = 1;
+    }
+    else
+    {
+        if ((status = streamEncryptOpenNamed(&job, ctx, inPath, out)))
+            return status;
+        if (describeInput(&ck, ctx, inPath))
+            return streamEncryptClose(&job, crc, FILE_ERR);
+        memcpy(ck.iv, job.header.IV, sizeof(ck.iv));
+        memcpy(iv, job.header.IV, bs);
+    }
+    if (length)
+        *length = job.length;
+
+    /// bez kontrolnih tacaka ukoliko pomocni fajl ne moze da se napravi
+    fd = open(ckPath, O_WRONLY | O_CREAT, 0666);
+
+    status = 0;
+    while (!status && first < job.blocks)
+    {
+        count = job.blocks - first < step ? job.blocks - first : step;
+        if ((status = streamEncryptRange(&job, first, count, iv, &rangeCrc)))
+            break;
+
+        crc = first ? crc32Combine(crc, rangeCrc, (first + count) * bs > job.length ?
+                                   job.length - first * bs : count * bs) : rangeCrc;
+        first += count;
+
+        if (fd >= 0 && first < job.blocks)
+        {
+            ck.doneBlocks = first;
+            ck.crc = crc;
+            memcpy(ck.chain, iv, bs);
+            if (!saveCheckpoint(fd, &job, &ck))
+                saved = 1;
+        }
+    }
+
+    if (fd >= 0)
+        close(fd);
+
+    /// izlaz i kontrolna tacka ostaju, da bi se ponovljena obrada (--resume) nastavila od nje
+    if (status && saved)
+    {
+        streamEncryptSuspend(&job);
+        return status;
+    }
+    status = streamEncryptClose(&job, crc, status);
+    unlink(ckPath);
+    return status;
+}
+
+int checkpointExists(const char *outPath)
+{
+    char path[STREAM_PATH_MAX];
+    int len = snprintf(path, sizeof(path), "%s" CHECKPOINT_SUFFIX, outPath);
+
+    if (len < 0 || (size_t) len >= sizeof(path))
+        return 0;
+    return access(path, F_OK) == 0;
+}
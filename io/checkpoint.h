@@ -0,0 +1,57 @@
+/**
+* @file
+* @brief Enkripcija velikih fajlova u CBC modu sa kontrolnim tackama, koja moze da se nastavi
+* posle prekida.
+* @details CBC enkripcija je sekvencijalna, pa se veliki fajl ne deli na delove kao u ECB modu. Umesto
+* toga se posle svakih CHECKPOINT_INTERVAL bajtova stanje obrade (broj upisanih blokova, poslednji
+* sifrovani blok i CRC registar do tog mesta) upisuje u pomocni fajl pored izlaza (izlaz sa dodatim
+* CHECKPOINT_SUFFIX). Prvo se na disk spustaju podaci izlaza, pa tek onda kontrolna tacka, tako da
+* kontrolna tacka nikad ne opisuje podatke kojih nema na disku. Izlaz se do kraja pise pod imenom sa
+* STREAM_TMP_SUFFIX (streamEncryptOpenNamed), da bi posle prekida mogao ponovo da se otvori.
+*
+* Pri nastavku se kontrolna tacka koristi samo ukoliko odgovara onome sto je zaista na disku: zapis je
+* ceo (CRC zapisa), ulaz nije menjan (velicina, vreme izmene, inode), kljuc je isti, velicina izlaza
+* odgovara ulazu, a sifrovani blok na poslednjoj upisanoj poziciji je jednak sacuvanom. U suprotnom se
+* fajl enkriptuje od pocetka.
+*/
+
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+#include <stdint.h>
+#include "../cipher/cipher.h"
+
+/**
+* @brief Broj bajtova izmedju dve kontrolne tacke (umnozak STREAM_BUF_LEN).
+*/
+#define CHECKPOINT_INTERVAL (64ULL * 1024 * 1024)
+
+/**
+* @brief Najmanja velicina fajla za koju se prave kontrolne tacke.
+*/
+#define CHECKPOINT_MIN_SIZE (4 * CHECKPOINT_INTERVAL)
+
+/**
+* @brief Sufiks pomocnog fajla sa kontrolnom tackom.
+*/
+#define CHECKPOINT_SUFFIX ".ckpt"
+
+/**
+* @brief Funkcija za enkripciju celog fajla sa kontrolnim tackama.
+* @param[in] ctx Kontekst algoritma (CBC mod).
+* @param[in] inPath Putanja do fajla.
+* @param[in] outPath Putanja izlaza, NULL za inPath sa dodatom .dat ekstenzijom.
+* @param[in] resume 1 ukoliko treba nastaviti od sacuvane kontrolne tacke (ako je ispravna), 0 u suprotnom.
+* @param[out] length Broj bajtova originalnog fajla, moze biti NULL.
+* @return 0 ili kod greske iz global.h.
+*/
+int checkpointEncryptFile(cipherctx_t *ctx, const char *inPath, const char *outPath, int resume, uint64_t *length);
+
+/**
+* @brief Funkcija koja proverava da li za izlaz postoji kontrolna tacka.
+* @param[in] outPath Putanja izlaza.
+* @return 1 ukoliko postoji, 0 u suprotnom.
+*/
+int checkpointExists(const char *outPath);
+
+#endif // _CHECKPOINT_H_
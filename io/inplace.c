@@ -0,0 +1,584 @@
+/**
+* @file
+* @brief Enkripcija i dekripcija u mestu sa zapisima unapred.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "inplace.h"
+#include "stream.h"
+#include "throttle.h"
+#include "../rng/rng.h"
+
+/**
+* @brief Oznaka na pocetku zapisa.
+*/
+#define WAL_MAGIC 0x4C415750
+
+/**
+* @brief Verzija zapisa.
+*/
+#define WAL_VERSION 1
+
+/**
+* @brief Broj pokusaja da se nadje slobodno ime izlaza prilikom dekripcije.
+*/
+#define NAME_TRIES 16
+
+/**
+* @brief Faza obrade opisana zapisom.
+* @private
+*/
+typedef enum
+{
+    WAL_CHUNK = 1,  /**< Deo od offset se upisuje, ulazni bajtovi dela slede zapis */
+    WAL_FINAL       /**< Svi delovi su upisani, ostaje heder/skracivanje i preimenovanje */
+} walstage_t;
+
+/**
+* @brief Zapis o stanju obrade.
+* @private
+*/
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t op;            /**< 'e' ili 'd' */
+    uint32_t algo;
+    uint32_t keyCheck;      /**< CRC sifrovanog nultog bloka, razlikuje kljuceve */
+    uint32_t stage;
+    uint64_t seq;           /**< Redni broj zapisa, veci je noviji */
+    uint64_t offset;        /**< Pocetak dela u podacima (bez hedera) */
+    uint64_t payloadLen;    /**< Broj ulaznih bajtova dela koji slede zapis */
+    uint32_t crc;           /**< CRC registar originalnih bajtova pre dela (u WAL_FINAL celog fajla) */
+    uint32_t payloadCrc;
+    uc chain[CIPHER_BLOCK_MAX];     /**< Vektor ulancavanja pre dela */
+    fileheader_t header;    /**< Heder .dat fajla */
+    uint32_t recordCrc;     /**< CRC svih prethodnih polja */
+} walrecord_t;
+
+/**
+* @brief Stanje obrade jednog fajla.
+* @private
+*/
+typedef struct
+{
+    cipherctx_t *ctx;
+    int op;
+    int fd, walFd;
+    char walPath[STREAM_PATH_MAX];
+    size_t slotLen;         /**< Velicina jednog mesta za zapis u pomocnom fajlu */
+    uc *buf;                /**< INPLACE_CHUNK bajtova dela i headerSize bajtova za pocetak sledeceg */
+    walrecord_t rec;
+    walrecord_t next;       /**< Noviji od dva zapisa koji se pri nastavku ponavljaju */
+    int pending;            /**< 1 ukoliko posle dela iz rec sledi deo iz next */
+    int replay;             /**< 1 ukoliko je zapis tekuceg dela vec na disku */
+    uint64_t synced;        /**< Redni broj zapisa do kog su delovi fajla sigurno na disku */
+} inplacejob_t;
+
+/**
+* @brief Funkcija koja cita tacno len bajtova od zadate pozicije.
+* @return 0 ili -1.
+* @private
+*/
+static int readFull(int fd, void *buf, size_t len, off_t off)
+{
+    size_t done = 0;
+    ssize_t n;
+
+    throttleAcquire(THROTTLE_READ, len);
+    while (done < len)
+    {
+        n = pread(fd, (char*) buf + done, len - done, off + done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        done += n;
+    }
+    return 0;
+}
+
+/**
+* @brief Funkcija koja upisuje tacno len bajtova na zadatu poziciju.
+* @return 0 ili -1.
+* @private
+*/
+static int writeFull(int fd, const void *buf, size_t len, off_t off)
+{
+    size_t done = 0;
+    ssize_t n;
+
+    throttleAcquire(THROTTLE_WRITE, len);
+    while (done < len)
+    {
+        n = pwrite(fd, (const char*) buf + done, len - done, off + done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        done += n;
+    }
+    return 0;
+}
+
+/**
+* @brief Funkcija koja racuna otisak kljuca (CRC sifrovanog nultog bloka).
+* @private
+*/
+static uint32_t keyCheck(cipherctx_t *ctx)
+{
+    uc block[CIPHER_BLOCK_MAX] = {0}, iv[CIPHER_BLOCK_MAX] = {0};
+
+    cipherEncrypt(ctx, block, ctx->blockSize, ctx->cbc ? iv : NULL);
+    return crc32Update(~0U, block, ctx->blockSize);
+}
+
+/**
+* @brief Funkcija koja otvara fajl i, ukoliko postoji, pomocni fajl.
+* @return 0 ili FILE_ERR ukoliko putanja pomocnog fajla nije ispravna.
+* @private
+*/
+static int openJob(inplacejob_t *job, cipherctx_t *ctx, const char *path, int op)
+{
+    int len;
+
+    memset(job, 0, sizeof(*job));
+    job->ctx = ctx;
+    job->op = op;
+    job->fd = job->walFd = -1;
+    job->slotLen = sizeof(walrecord_t) + INPLACE_CHUNK + ctx->headerSize;
+
+    len = snprintf(job->walPath, sizeof(job->walPath), "%s" INPLACE_SUFFIX, path);
+    if (len < 0 || (size_t) len >= sizeof(job->walPath))
+        return FILE_ERR;
+
+    job->buf = (uc*) malloc(INPLACE_CHUNK + ctx->headerSize);
+    ALLOC_CHECK(job->buf);
+
+    throttleAcquire(THROTTLE_FILES, 1);
+    job->fd = open(path, O_RDWR);
+    job->walFd = open(job->walPath, O_RDWR);
+    return 0;
+}
+
+/**
+* @brief Funkcija koja zatvara fajlove; posle uspesnog kraja brise pomocni fajl.
+* @private
+*/
+static void closeJob(inplacejob_t *job, int finished)
+{
+    if (job->fd >= 0)
+        close(job->fd);
+    if (job->walFd >= 0)
+        close(job->walFd);
+    if (finished)
+        unlink(job->walPath);
+    free(job->buf);
+}
+
+/**
+* @brief Funkcija koja ucitava ulazne bajtove zapisa u job->buf i proverava ih.
+* @return 0 ili -1.
+* @private
+*/
+static int loadPayload(inplacejob_t *job, const walrecord_t *rec)
+{
+    if (!rec->payloadLen)
+        return 0;
+    if (readFull(job->walFd, job->buf, rec->payloadLen, (rec->seq % 2) * job->slotLen + sizeof(walrecord_t)) ||
+        rec->payloadCrc != crc32Update(~0U, job->buf, rec->payloadLen))
+        return -1;
+    return 0;
+}
+
+/**
+* @brief Funkcija koja ucitava zapis od kog se obrada nastavlja i ulazne bajtove njegovog dela u job->buf.
+* Ukoliko su oba zapisa ispravna i uzastopna, deo starijeg mozda jos nije na disku, pa se ponavljaju oba.
+* @return 0 ukoliko zapis postoji, 1 ukoliko ga nema (fajl jos nije menjan), -1 ukoliko zapis pripada
+* drugoj operaciji ili kljucu.
+* @private
+*/
+static int loadRecord(inplacejob_t *job)
+{
+    walrecord_t recs[2];
+    uint32_t check = keyCheck(job->ctx);
+    int valid[2], i, newest;
+
+    if (job->walFd < 0)
+        return 1;
+
+    for (i = 0; i < 2; i++)
+    {
+        valid[i] = !readFull(job->walFd, &recs[i], sizeof(walrecord_t), i * job->slotLen) &&
+                   recs[i].magic == WAL_MAGIC && recs[i].version == WAL_VERSION &&
+                   recs[i].recordCrc == crc32Update(~0U, (uc*) &recs[i], offsetof(walrecord_t, recordCrc)) &&
+                   recs[i].payloadLen <= (uint64_t) (INPLACE_CHUNK + job->ctx->headerSize);
+        if (valid[i] && (recs[i].op != (uint32_t) job->op || recs[i].algo != job->ctx->algo || recs[i].keyCheck != check))
+            return -1;
+
+        /// zapis se koristi samo ukoliko su i ulazni bajtovi upisani do kraja
+        valid[i] = valid[i] && !loadPayload(job, &recs[i]);
+    }
+    if (!valid[0] && !valid[1])
+        return 1;
+
+    newest = valid[0] && valid[1] ? recs[1].seq > recs[0].seq : valid[1];
+    job->rec = job->next = recs[newest];
+    job->pending = 0;
+
+    /// deo starijeg od dva uzastopna zapisa mozda jos nije na disku; preimenovan fajl je vec zavrsen
+    if (valid[!newest] && recs[!newest].seq + 1 == recs[newest].seq && job->fd >= 0)
+    {
+        job->rec = recs[!newest];
+        job->pending = 1;
+    }
+    job->replay = job->rec.stage == WAL_CHUNK;
+    job->synced = job->rec.seq - 1;
+    return loadPayload(job, &job->rec) ? -1 : 0;
+}
+
+/**
+* @brief Funkcija koja posle ponovljenog dela prelazi na noviji zapis i ulazne bajtove njegovog dela.
+* @param[out] have Broj ulaznih bajtova u job->buf.
+* @return 0 ili -1.
+* @private
+*/
+static int replayNext(inplacejob_t *job, uint64_t *have)
+{
+    if (!job->pending)
+        return 0;
+
+    job->pending = 0;
+    job->rec = job->next;
+    job->replay = job->rec.stage == WAL_CHUNK;
+    *have = job->rec.payloadLen;
+    return loadPayload(job, &job->rec);
+}
+
+/**
+* @brief Funkcija koja upisuje zapis sa ulaznim bajtovima dela na mesto po rednom broju i spusta ga na disk.
+* Zapis prepisuje zapis sa rednim brojem manjim za dva, pa se pre toga na disk spusta fajl; jedan
+* fdatasync pokriva i poslednji upisani deo, pa se fajl spusta na svaka dva dela.
+* @return 0 ili -1.
+* @private
+*/
+static int saveRecord(inplacejob_t *job, walstage_t stage, uint64_t offset, const uc *payload, size_t len)
+{
+    walrecord_t *rec = &job->rec;
+    off_t slot;
+
+    rec->magic = WAL_MAGIC;
+    rec->version = WAL_VERSION;
+    rec->op = job->op;
+    rec->algo = job->ctx->algo;
+    rec->keyCheck = keyCheck(job->ctx);
+    rec->stage = stage;
+    rec->seq++;
+    if (rec->seq > job->synced + 2)
+    {
+        if (fdatasync(job->fd))
+            return -1;
+        job->synced = rec->seq - 1;
+    }
+    rec->offset = offset;
+    rec->payloadLen = len;
+    rec->payloadCrc = crc32Update(~0U, payload, len);
+    rec->recordCrc = crc32Update(~0U, (uc*) rec, offsetof(walrecord_t, recordCrc));
+
+    slot = (rec->seq % 2) * job->slotLen;
+    if (writeFull(job->walFd, rec, sizeof(*rec), slot) ||
+        (len && writeFull(job->walFd, payload, len, slot + sizeof(*rec))))
+        return -1;
+    return fdatasync(job->walFd);
+}
+
+/**
+* @brief Funkcija koja pravi pomocni fajl pre prvog zapisa.
+* @return 0 ili -1.
+* @private
+*/
+static int createWal(inplacejob_t *job)
+{
+    if (job->walFd < 0)
+    {
+        job->walFd = open(job->walPath, O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (job->walFd < 0)
+            return -1;
+        streamSyncDir(job->walPath);
+    }
+    memset(&job->rec, 0, sizeof(job->rec));
+    return 0;
+}
+
+/**
+* @brief Funkcija koja obradjuje jedan deo: upisuje zapis sa ulaznim bajtovima (osim kada se deo ponavlja
+* iz postojeceg zapisa), sifruje/desifruje deo u baferu i upisuje ga na mesto.
+* @param[in] job Stanje obrade.
+* @param[in] offset Pocetak dela u podacima.
+* @param[in] len Duzina dela (umnozak velicine bloka).
+* @param[in] payloadLen Broj ulaznih bajtova u baferu koji se cuvaju u zapisu (>= len pri enkripciji,
+* jer obuhvata i pocetak sledeceg dela).
+* @param[in] outOff Pozicija rezultata u fajlu.
+* @param[in] plainLen Broj originalnih bajtova dela (bez dopune) za CRC.
+* @param[in,out] chain Vektor ulancavanja.
+* @param[in,out] crc CRC registar originalnih bajtova.
+* @return 0 ili IO_ERR.
+* @private
+*/
+static int processChunk(inplacejob_t *job, uint64_t offset, size_t len, size_t payloadLen, off_t outOff,
+                        size_t plainLen, uc *chain, uint32_t *crc)
+{
+    cipherctx_t *ctx = job->ctx;
+    uc *iv = ctx->cbc ? chain : NULL;
+
+    if (job->replay)
+        job->replay = 0;
+    else
+    {
+        memcpy(job->rec.chain, chain, ctx->blockSize);
+        job->rec.crc = *crc;
+        if (saveRecord(job, WAL_CHUNK, offset, job->buf, payloadLen))
+            return IO_ERR;
+    }
+
+    if (job->op == 'e')
+    {
+        *crc = crc32Update(*crc, job->buf, plainLen);
+        cipherEncrypt(ctx, job->buf, len, iv);
+    }
+    else
+    {
+        cipherDecrypt(ctx, job->buf, len, iv);
+        *crc = crc32Update(*crc, job->buf, plainLen);
+    }
+
+    if (writeFull(job->fd, job->buf, len, outOff))
+        return IO_ERR;
+    return 0;
+}
+
+int inplaceEncryptFile(cipherctx_t *ctx, const char *path, uint64_t *length)
+{
+    inplacejob_t job;
+    fileheader_t *header = &job.rec.header;
+    struct stat st;
+    char outPath[STREAM_PATH_MAX];
+    uc sealed[sizeof(fileheader_t)], chain[CIPHER_BLOCK_MAX];
+    uint64_t dataLen, off, end, need, have = 0;
+    uint32_t crc;
+    int hs = ctx->headerSize, bs = ctx->blockSize, status = 0, loaded, len;
+
+    len = snprintf(outPath, sizeof(outPath), "%s.dat", path);
+    if (len < 0 || (size_t) len >= sizeof(outPath) || openJob(&job, ctx, path, 'e'))
+        return FILE_ERR;
+
+    if ((loaded = loadRecord(&job)) < 0 || (loaded && (job.fd < 0 || fstat(job.fd, &st) || !S_ISREG(st.st_mode))))
+    {
+        closeJob(&job, 0);
+        return FILE_ERR;
+    }
+
+    if (loaded)
+    {
+        if (createWal(&job))
+        {
+            closeJob(&job, 0);
+            return FILE_ERR;
+        }
+        strncpy((char*) header->fileName, get_filename_from_path((char*) path), FILENAME_LEN_MAX - 1);
+        header->byteLength = st.st_size;
+        rngBytes(header->IV, sizeof(header->IV));
+        memcpy(chain, header->IV, bs);
+        crc = ~0U;
+        have = header->byteLength < (uint64_t) hs ? header->byteLength : (uint64_t) hs;
+        if (have && readFull(job.fd, job.buf, have, 0))
+            status = IO_ERR;
+        off = 0;
+    }
+    else
+    {
+        memcpy(chain, job.rec.chain, bs);
+        crc = job.rec.crc;
+        have = job.rec.payloadLen;
+        off = job.rec.offset;
+    }
+    if (length)
+        *length = header->byteLength;
+
+    /// zavrsena obrada ciji pomocni fajl nije obrisan
+    if (job.fd < 0 && job.rec.stage == WAL_FINAL)
+    {
+        closeJob(&job, 1);
+        return 0;
+    }
+    if (job.fd < 0)
+    {
+        closeJob(&job, 0);
+        return FILE_ERR;
+    }
+
+    dataLen = (header->byteLength + bs - 1) / bs * bs;
+    if (job.rec.stage == WAL_FINAL)
+        crc = job.rec.crc;
+    else
+        for (; !status && off < dataLen; off = end)
+        {
+            end = off + INPLACE_CHUNK < dataLen ? off + INPLACE_CHUNK : dataLen;
+            need = (end + hs < header->byteLength ? end + hs : header->byteLength) - off;
+
+            /// bajtovi od off + have jos nisu prepisani (upis je stigao do hs + off)
+            if (have < need && readFull(job.fd, job.buf + have, need - have, off + have))
+            {
+                status = IO_ERR;
+                break;
+            }
+            if (need < end - off)
+                memset(job.buf + need, 0, end - off - need);
+
+            status = processChunk(&job, off, end - off, need, hs + off,
+                                  (end < header->byteLength ? end : header->byteLength) - off, chain, &crc);
+
+            have = need > end - off ? need - (end - off) : 0;
+            memmove(job.buf, job.buf + (end - off), have);
+            if (!status && replayNext(&job, &have))
+                status = IO_ERR;
+        }
+
+    if (!status)
+    {
+        header->crc = crc;
+        header->pad = 0;
+        job.rec.crc = crc;
+        cipherSealHeader(ctx, header, sealed);
+        if (saveRecord(&job, WAL_FINAL, dataLen, NULL, 0) ||
+            writeFull(job.fd, sealed, hs, 0) || fdatasync(job.fd) || rename(path, outPath))
+            status = IO_ERR;
+        else
+            streamSyncDir(outPath);
+    }
+
+    closeJob(&job, !status);
+    return status;
+}
+
+int inplaceDecryptFile(cipherctx_t *ctx, const char *path, uint64_t *length)
+{
+    inplacejob_t job;
+    fileheader_t *header = &job.rec.header, opened;
+    struct stat st;
+    char outPath[STREAM_PATH_MAX], *name;
+    uc sealed[sizeof(fileheader_t)], chain[CIPHER_BLOCK_MAX];
+    uint64_t blocks, dataLen, off, end, have = 0;
+    uint32_t crc;
+    int hs = ctx->headerSize, bs = ctx->blockSize, status = 0, loaded, i;
+
+    if (openJob(&job, ctx, path, 'd'))
+        return FILE_ERR;
+
+    if ((loaded = loadRecord(&job)) < 0 || (loaded && (job.fd < 0 || fstat(job.fd, &st) || !S_ISREG(st.st_mode) ||
+                                                       st.st_size < hs || readFull(job.fd, sealed, hs, 0))))
+    {
+        closeJob(&job, 0);
+        return FILE_ERR;
+    }
+
+    if (loaded)
+    {
+        cipherOpenHeader(ctx, sealed, &opened);
+        blocks = (st.st_size - hs) / bs;
+
+        /// heder mora da odgovara velicini fajla (pogresan kljuc ili fajl koji nije .dat se ne menja);
+        /// fajl sa rupama (HEADER_SPARSE) se dekriptuje samo preko stream.h
+        if (opened.pad || (st.st_size - hs) % bs || opened.byteLength > blocks * bs || opened.byteLength + bs <= blocks * bs ||
+            !opened.fileName[0] || createWal(&job))
+        {
+            closeJob(&job, 0);
+            return FILE_ERR;
+        }
+        *header = opened;
+        memcpy(chain, header->IV, bs);
+        crc = ~0U;
+        off = 0;
+    }
+    else
+    {
+        memcpy(chain, job.rec.chain, bs);
+        crc = job.rec.crc;
+        have = job.rec.payloadLen;
+        off = job.rec.offset;
+    }
+    if (length)
+        *length = header->byteLength;
+
+    if (job.fd < 0 && job.rec.stage == WAL_FINAL)
+    {
+        closeJob(&job, 1);
+        return job.rec.crc != header->crc ? CRC_MISMATCH : 0;
+    }
+    if (job.fd < 0)
+    {
+        closeJob(&job, 0);
+        return FILE_ERR;
+    }
+
+    dataLen = (header->byteLength + bs - 1) / bs * bs;
+    if (job.rec.stage == WAL_FINAL)
+        crc = job.rec.crc;
+    else
+        for (; !status && off < dataLen; off = end)
+        {
+            end = off + INPLACE_CHUNK < dataLen ? off + INPLACE_CHUNK : dataLen;
+
+            /// rezultat se upisuje pre podataka koji se citaju, pa je ceo deo jos na disku
+            if (have < end - off && readFull(job.fd, job.buf + have, end - off - have, hs + off + have))
+            {
+                status = IO_ERR;
+                break;
+            }
+            status = processChunk(&job, off, end - off, end - off, off,
+                                  (end < header->byteLength ? end : header->byteLength) - off, chain, &crc);
+            have = 0;
+            if (!status && replayNext(&job, &have))
+                status = IO_ERR;
+        }
+
+    if (!status)
+    {
+        job.rec.crc = crc;
+        if (saveRecord(&job, WAL_FINAL, dataLen, NULL, 0) || ftruncate(job.fd, header->byteLength) ||
+            fdatasync(job.fd))
+            status = IO_ERR;
+    }
+
+    if (!status)
+    {
+        snprintf(outPath, sizeof(outPath), "%s", path);
+        name = get_filename_from_path(outPath);
+        snprintf(name, outPath + sizeof(outPath) - name, "%s", (char*) header->fileName);
+        for (i = 0; i < NAME_TRIES; i++)
+        {
+            if (!streamRenameNoReplace(path, outPath) || errno != EEXIST)
+                break;
+            snprintf(name, outPath + sizeof(outPath) - name, "%d%s",
+                     (int) (rngU32() >> 1), (char*) header->fileName);
+        }
+        if (i == NAME_TRIES || access(path, F_OK) == 0)
+            status = IO_ERR;
+        else
+        {
+            streamSyncDir(outPath);
+            if (crc != header->crc)
+                status = CRC_MISMATCH;
+        }
+    }
+
+    closeJob(&job, status == 0 || status == CRC_MISMATCH);
+    return status;
+}
@@ -0,0 +1,65 @@
+/**
+* @file
+* @brief Enkripcija i dekripcija u mestu: fajl se prepisuje sopstvenim rezultatom, bez druge kopije
+* na disku (--in-place).
+* @details Heder .dat fajla pomera podatke za ctx->headerSize bajtova, pa se fajl obradjuje redom u
+* delovima od INPLACE_CHUNK bajtova. Pri enkripciji se rezultat dela upisuje iza hedera i prepisuje
+* i pocetak sledeceg dela, koji se zato pre upisa cita u memoriju; pri dekripciji rezultat uvek
+* zaostaje za citanjem.
+*
+* Pre upisa svakog dela se u pomocni fajl (putanja sa dodatim INPLACE_SUFFIX) upisuje zapis sa
+* ulaznim bajtovima tog dela i stanjem obrade (pozicija, CRC registar, vektor ulancavanja, heder) i
+* spusta na disk (fdatasync). Zapisi se naizmenicno upisuju na dva mesta, pa prekinut upis zapisa ne
+* brise prethodni; sam fajl se na disk spusta pre nego sto zapis prepise zapis dela koji mozda jos nije
+* na disku, tj. na svaka dva dela. Ukoliko se obrada prekine, sledeci poziv za isti fajl ponavlja delove
+* iz poslednja dva ispravna zapisa iz sacuvanih bajtova, a ostatak fajla jos nije dirnut.
+*
+* Zapis cuva ceo ulaz dela, a ne samo bajtove koje rezultat pomera: prekinut upis dela ostavlja
+* sektore u proizvoljnom redosledu, a zbog pomeraja od headerSize bajtova blok ciji je stari sektor
+* prepisan pre nego sto je stigao njegov novi sektor ne moze da se izracuna iz sadrzaja fajla.
+*
+* Na kraju se upisuje heder (enkripcija) odnosno skracuje fajl (dekripcija), pa se fajl atomski
+* preimenuje u ime izlaza (ime sa .dat, odnosno ime iz hedera) i pomocni fajl se brise.
+*
+* Pre dekripcije se proverava da heder odgovara velicini fajla, pa se fajl sa pogresnim kljucem ne
+* menja; .dat fajl sa rupama (HEADER_SPARSE) se u mestu ne dekriptuje. Posle dekripcije koja je promenila fajl nema originala, pa se i pri CRC_MISMATCH izlaz cuva.
+*/
+
+#ifndef _INPLACE_H_
+#define _INPLACE_H_
+
+#include <stdint.h>
+#include "../cipher/cipher.h"
+
+/**
+* @brief Velicina dela koji se obradjuje izmedju dva zapisa (umnozak velicine bloka).
+*/
+#define INPLACE_CHUNK (16 * 1024 * 1024)
+
+/**
+* @brief Sufiks pomocnog fajla sa zapisima.
+*/
+#define INPLACE_SUFFIX ".wal"
+
+/**
+* @brief Funkcija koja enkriptuje fajl u mestu i preimenuje ga u ime sa .dat ekstenzijom.
+* Ukoliko postoji zapis prekinute enkripcije istog fajla, obrada se nastavlja od njega.
+* @param[in] ctx Kontekst algoritma.
+* @param[in] path Putanja do fajla.
+* @param[out] length Broj bajtova originalnog fajla, moze biti NULL.
+* @return 0 ili kod greske iz global.h.
+*/
+int inplaceEncryptFile(cipherctx_t *ctx, const char *path, uint64_t *length);
+
+/**
+* @brief Funkcija koja dekriptuje .dat fajl u mestu i preimenuje ga u originalno ime iz hedera (uz
+* slucajan broj na pocetku imena, ukoliko fajl sa tim imenom vec postoji).
+* Ukoliko postoji zapis prekinute dekripcije istog fajla, obrada se nastavlja od njega.
+* @param[in] ctx Kontekst algoritma.
+* @param[in] path Putanja do .dat fajla.
+* @param[out] length Broj bajtova originalnog fajla, moze biti NULL.
+* @return 0 ili kod greske iz global.h.
+*/
+int inplaceDecryptFile(cipherctx_t *ctx, const char *path, uint64_t *length);
+
+#endif // _INPLACE_H_
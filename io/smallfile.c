@@ -0,0 +1,348 @@
+/**
+* @file
+* @brief Enkripcija/dekripcija vise malih fajlova odjednom preko io_uring-a.
+* @details Fajl i dobija mesto i u tabeli direktnih deskriptora prstena niti i svoj bafer. Read je
+* vezan za openat obicnom vezom (ukoliko openat ne uspe, ostatak lanca se otkazuje), a close za read
+* "tvrdom" vezom, jer je citanje malog fajla uvek krace od bafera, sto bi obicnu vezu prekinulo.
+*
+* Izlazi se pisu pod imenom sa STREAM_TMP_SUFFIX (uz STREAM_SYNC_FILE sa fdatasync u lancu pre close),
+* a konacno ime dobijaju preko streamPublish, kao izlazi iz stream.h.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "smallfile.h"
+#include "throttle.h"
+#include "uring.h"
+#include "../rng/rng.h"
+
+/**
+* @brief Velicina bafera jednog fajla: heder, podaci, jedan bajt za prepoznavanje prevelikog fajla
+* i dopuna do bloka.
+*/
+#define SLOT_LEN ((sizeof(fileheader_t) + SMALLFILE_MAX_BYTES + 1 + 2 * CIPHER_BLOCK_MAX + URING_ALIGN - 1) \
+                  / URING_ALIGN * URING_ALIGN)
+
+/**
+* @brief Zahtevi u lancu jednog fajla (user_data je 4 * i + zahtev).
+*/
+enum { REQ_OPEN, REQ_IO, REQ_SYNC, REQ_CLOSE, REQ_COUNT };
+
+#if URING_SUPPORTED
+
+/**
+* @brief Funkcija koja priprema openat u mesto slot tabele direktnih deskriptora.
+* @private
+*/
+static void prepOpen(struct io_uring_sqe *sqe, int slot, const char *path, int flags, unsigned flagsSqe)
+{
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = (uintptr_t) path;
+    sqe->len = 0666;
+    sqe->open_flags = flags;    /// O_CLOEXEC nije dozvoljen uz direktan deskriptor
+    sqe->file_index = slot + 1;
+    sqe->flags = flagsSqe;
+    sqe->user_data = REQ_COUNT * slot + REQ_OPEN;
+}
+
+/**
+* @brief Funkcija koja priprema citanje ili pisanje od pocetka fajla preko direktnog deskriptora.
+* @private
+*/
+static void prepIo(struct io_uring_sqe *sqe, int slot, int write, uc *buf, size_t len)
+{
+    sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+    sqe->fd = slot;
+    sqe->addr = (uintptr_t) buf;
+    sqe->len = len;
+    sqe->off = 0;
+    sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+    sqe->user_data = REQ_COUNT * slot + REQ_IO;
+}
+
+/**
+* @brief Funkcija koja priprema fdatasync preko direktnog deskriptora.
+* @private
+*/
+static void prepSync(struct io_uring_sqe *sqe, int slot)
+{
+    sqe->opcode = IORING_OP_FSYNC;
+    sqe->fd = slot;
+    sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+    sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+    sqe->user_data = REQ_COUNT * slot + REQ_SYNC;
+}
+
+/**
+* @brief Funkcija koja priprema zatvaranje direktnog deskriptora.
+* @private
+*/
+static void prepClose(struct io_uring_sqe *sqe, int slot)
+{
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->file_index = slot + 1;
+    sqe->user_data = REQ_COUNT * slot + REQ_CLOSE;
+}
+
+/**
+* @brief Funkcija koja predaje pripremljene zahteve i ceka zadati broj zavrsetaka.
+* @param[out] res Rezultati po user_data.
+* @return 0 ili -1.
+* @private
+*/
+static int reap(uring_t *ring, int expected, int *res)
+{
+    struct io_uring_cqe *cqe;
+
+    while (expected > 0)
+    {
+        if (uringSubmit(ring, expected) < 0)
+            return -1;
+        while ((cqe = uringPeek(ring)))
+        {
+            res[cqe->user_data] = cqe->res;
+            uringSeen(ring);
+            expected--;
+        }
+    }
+    return 0;
+}
+
+/**
+* @brief Funkcija koja enkriptuje procitan fajl u njegovom baferu: heder na pocetku, pa podaci.
+* @return Duzina izlaza.
+* @private
+*/
+static size_t encryptSlot(cipherctx_t *ctx, smallfile_t *file, uc *buf, size_t got)
+{
+    int bs = ctx->blockSize, hs = ctx->headerSize;
+    size_t padded = (got + bs - 1) / bs * bs;
+    uc sealed[sizeof(fileheader_t)];
+    uc iv[CIPHER_BLOCK_MAX];
+    fileheader_t header;
+
+    memset(&header, 0, sizeof(header));
+    strncpy((char*) header.fileName, get_filename_from_path((char*) file->inPath), FILENAME_LEN_MAX - 1);
+    header.byteLength = got;
+    rngBytes(header.IV, sizeof(header.IV));
+    header.crc = crc32Update(~0U, buf + hs, got);
+    header.pad = 0;
+
+    memset(buf + hs + got, 0, padded - got);
+    memcpy(iv, header.IV, bs);
+    cipherEncrypt(ctx, buf + hs, padded, iv);
+
+    cipherSealHeader(ctx, &header, sealed);
+    memcpy(buf, sealed, hs);
+
+    file->length = got;
+    file->crc = header.crc;
+    if (file->outArg)
+        snprintf(file->outPath, sizeof(file->outPath), "%s", file->outArg);
+    else
+        snprintf(file->outPath, sizeof(file->outPath), "%s.dat", file->inPath);
+    return hs + padded;
+}
+
+/**
+* @brief Funkcija koja dekriptuje procitan .dat fajl u njegovom baferu (podaci ostaju posle hedera)
+* i bira ime izlaza.
+* @param[out] noReplace 1 ukoliko izlaz ne sme da zameni postojeci fajl.
+* @return 0, FILE_ERR, CRC_MISMATCH ili SMALLFILE_FALLBACK ukoliko ime vec postoji ili fajl ima rupe.
+* @private
+*/
+static int decryptSlot(cipherctx_t *ctx, smallfile_t *file, uc *buf, size_t got, int *noReplace)
+{
+    int bs = ctx->blockSize, hs = ctx->headerSize;
+    uc iv[CIPHER_BLOCK_MAX];
+    fileheader_t header;
+    uint64_t blocks;
+    char *name;
+
+    if (got < (size_t) hs)
+        return FILE_ERR;
+
+    cipherOpenHeader(ctx, buf, &header);
+    if (header.pad == HEADER_SPARSE)
+        return SMALLFILE_FALLBACK;
+    blocks = (got - hs) / bs;
+    file->length = header.byteLength < blocks * bs ? header.byteLength : blocks * bs;
+
+    memcpy(iv, header.IV, bs);
+    cipherDecrypt(ctx, buf + hs, blocks * bs, iv);
+    file->crc = crc32Update(~0U, buf + hs, file->length);
+    if (file->crc != header.crc)
+        return CRC_MISMATCH;
+
+    /// ime izlaza kao kod streamDecryptOpen; zauzeto ime se prepusta stream.h
+    if (file->outArg && file->outArg[0] && file->outArg[strlen(file->outArg) - 1] != '/')
+    {
+        snprintf(file->outPath, sizeof(file->outPath), "%s", file->outArg);
+        *noReplace = 0;
+    }
+    else
+    {
+        snprintf(file->outPath, sizeof(file->outPath), "%s", file->outArg ? file->outArg : file->inPath);
+        name = get_filename_from_path(file->outPath);
+        snprintf(name, file->outPath + sizeof(file->outPath) - name, "%s", (char*) header.fileName);
+        *noReplace = 1;
+        if (!access(file->outPath, F_OK))
+            return SMALLFILE_FALLBACK;
+    }
+    return 0;
+}
+
+int smallProcessFiles(cipherctx_t *ctx, int encrypt, smallfile_t *files, int count,
+                      smallstartfunc_t started, void *arg)
+{
+    uringpipe_t *pipe = uringThreadPipe(STREAM_BUF_LEN);
+    int res[REQ_COUNT * SMALLFILE_MAX_FILES];
+    int noReplace[SMALLFILE_MAX_FILES];
+    size_t outLen[SMALLFILE_MAX_FILES];
+    char (*tmpPaths)[STREAM_PATH_MAX];
+    uc *bufs, *buf;
+    int i, n, len, hs = ctx->headerSize, sync = streamGetSync() == STREAM_SYNC_FILE;
+
+    if (!pipe || count > SMALLFILE_MAX_FILES || !uringPipeFiles(pipe))
+        return -1;
+    if (posix_memalign((void**) &bufs, URING_ALIGN, count * SLOT_LEN))
+        return -1;
+    if (!(tmpPaths = malloc(count * sizeof(*tmpPaths))))
+    {
+        free(bufs);
+        return -1;
+    }
+
+    /// ulazi: openat -> read -> close za sve fajlove jednim pozivom (bez REQ_SYNC)
+    for (i = 0; i < count; i++)
+    {
+        buf = bufs + i * SLOT_LEN;
+        throttleAcquire(THROTTLE_FILES, 1);
+        prepOpen(uringGetSqe(&pipe->ring), i, files[i].inPath, O_RDONLY, IOSQE_IO_LINK);
+        prepIo(uringGetSqe(&pipe->ring), i, 0, encrypt ? buf + hs : buf, SMALLFILE_MAX_BYTES + 1);
+        prepClose(uringGetSqe(&pipe->ring), i);
+    }
+    if (reap(&pipe->ring, (REQ_COUNT - 1) * count, res))
+        goto reset;
+
+    /// obrada u memoriji
+    for (i = 0; i < count; i++)
+    {
+        buf = bufs + i * SLOT_LEN;
+        files[i].outPath[0] = '\0';
+        files[i].length = 0;
+        files[i].crc = ~0U;
+
+        /// jezgro bez openat u tabelu direktnih deskriptora
+        if (res[REQ_COUNT * i + REQ_OPEN] == -EINVAL)
+            files[i].status = SMALLFILE_FALLBACK;
+        else if (res[REQ_COUNT * i + REQ_OPEN] < 0)
+            files[i].status = FILE_ERR;
+        else if (res[REQ_COUNT * i + REQ_IO] < 0)
+            files[i].status = IO_ERR;
+        else if (res[REQ_COUNT * i + REQ_IO] > SMALLFILE_MAX_BYTES)
+            files[i].status = SMALLFILE_FALLBACK;
+        else
+        {
+            throttleAcquire(THROTTLE_READ, res[REQ_COUNT * i + REQ_IO]);
+            if (encrypt)
+            {
+                outLen[i] = encryptSlot(ctx, &files[i], buf, res[REQ_COUNT * i + REQ_IO]);
+                noReplace[i] = 0;
+                files[i].status = 0;
+            }
+            else
+            {
+                files[i].status = decryptSlot(ctx, &files[i], buf, res[REQ_COUNT * i + REQ_IO], &noReplace[i]);
+                outLen[i] = files[i].length;
+            }
+        }
+        if (!files[i].status)
+        {
+            len = snprintf(tmpPaths[i], sizeof(tmpPaths[i]), "%s" STREAM_TMP_SUFFIX, files[i].outPath);
+            if (len < 0 || (size_t) len >= sizeof(tmpPaths[i]))
+                files[i].status = FILE_ERR;
+        }
+    }
+
+    /// izlazi: uz started se prvo otvaraju, da bi se izlaz zabelezio tek kada postoji, a inace je openat
+    /// u lancu ispred pisanja svog fajla; ime sa sufiksom se uz noReplace zauzima, jer isto ime mogu da
+    /// izaberu dva fajla
+    n = 0;
+    if (started)
+    {
+        for (i = 0; i < count; i++)
+            if (!files[i].status)
+            {
+                prepOpen(uringGetSqe(&pipe->ring), i, tmpPaths[i], O_WRONLY | O_CREAT | (noReplace[i] ? O_EXCL : O_TRUNC),
+                         0);
+                n++;
+            }
+        if (reap(&pipe->ring, n, res))
+            goto reset;
+        for (i = n = 0; i < count; i++)
+            if (!files[i].status && res[REQ_COUNT * i + REQ_OPEN] >= 0)
+                started(arg, i, files[i].outPath);
+    }
+
+    for (i = 0; i < count; i++)
+        if (!files[i].status && (!started || res[REQ_COUNT * i + REQ_OPEN] >= 0))
+        {
+            if (!started)
+            {
+                prepOpen(uringGetSqe(&pipe->ring), i, tmpPaths[i], O_WRONLY | O_CREAT | (noReplace[i] ? O_EXCL : O_TRUNC),
+                         IOSQE_IO_LINK);
+                n++;
+            }
+            buf = bufs + i * SLOT_LEN;
+            throttleAcquire(THROTTLE_WRITE, outLen[i]);
+            prepIo(uringGetSqe(&pipe->ring), i, 1, encrypt ? buf : buf + hs, outLen[i]);
+            if (sync)
+                prepSync(uringGetSqe(&pipe->ring), i);
+            prepClose(uringGetSqe(&pipe->ring), i);
+            n += sync ? 3 : 2;
+        }
+    if (reap(&pipe->ring, n, res))
+        goto reset;
+
+    for (i = 0; i < count; i++)
+    {
+        if (files[i].status)
+            continue;
+        if (res[REQ_COUNT * i + REQ_OPEN] < 0)
+        {
+            files[i].status = res[REQ_COUNT * i + REQ_OPEN] == -EEXIST ? SMALLFILE_FALLBACK : FILE_ERR;
+            continue;
+        }
+        if (res[REQ_COUNT * i + REQ_IO] != (int) outLen[i] || (sync && res[REQ_COUNT * i + REQ_SYNC] < 0) ||
+            res[REQ_COUNT * i + REQ_CLOSE] < 0 || streamPublish(-1, tmpPaths[i], files[i].outPath, noReplace[i], outLen[i]))
+        {
+            files[i].status = IO_ERR;
+            unlink(tmpPaths[i]);
+        }
+    }
+
+    free(tmpPaths);
+    free(bufs);
+    return 0;
+
+reset:
+    /// zahtevi su mozda jos u obradi, pa se baferi ne oslobadjaju; imena su jezgru vec predata
+    uringThreadPipeReset();
+    free(tmpPaths);
+    return -1;
+}
+
+#else
+
+int smallProcessFiles(cipherctx_t *ctx, int encrypt, smallfile_t *files, int count,
+                      smallstartfunc_t started, void *arg)
+{
+    return -1;
+}
+
+#endif
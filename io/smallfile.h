@@ -0,0 +1,70 @@
+/**
+* @file
+* @brief Enkripcija/dekripcija vise malih fajlova odjednom preko io_uring-a.
+* @details Kod malih fajlova vreme odlazi na sistemske pozive, a ne na sifrovanje. Za sve fajlove
+* grupe se jednim io_uring_enter pozivom predaju lanci openat -> read -> close (sa direktnim
+* deskriptorima, pa openat i read ne cekaju povratak u korisnicki prostor), svaki fajl se sa hederom
+* obradi u memoriji, a zatim se isto tako predaju lanci openat -> write -> close za izlaze.
+*
+* Format izlaza je isti kao kod stream.h. Fajl koji ne moze da se obradi ovim putem (veci od
+* SMALLFILE_MAX_BYTES, izlaz dekripcije vec postoji pa treba izabrati drugo ime, jezgro bez direktnih
+* deskriptora) dobija status SMALLFILE_FALLBACK i pozivalac ga obradjuje preko stream.h.
+*/
+
+#ifndef _SMALLFILE_H_
+#define _SMALLFILE_H_
+
+#include <stdint.h>
+#include "stream.h"
+
+/**
+* @brief Najveca velicina fajla (ulaza) koji se obradjuje u memoriji.
+*/
+#define SMALLFILE_MAX_BYTES (64 * 1024)
+
+/**
+* @brief Najveci broj fajlova u jednom pozivu smallProcessFiles.
+*/
+#define SMALLFILE_MAX_FILES 32
+
+/**
+* @brief Status fajla koji treba obraditi preko stream.h.
+*/
+#define SMALLFILE_FALLBACK (-1)
+
+/**
+* @brief Funkcija koja se poziva kada je izlaz fajla napravljen, pre upisa (npr. za zurnal).
+* @param[in] arg Argument zadat pozivaocu.
+* @param[in] index Redni broj fajla u nizu.
+* @param[in] outPath Putanja izlaza.
+*/
+typedef void (*smallstartfunc_t)(void *arg, int index, const char *outPath);
+
+/**
+* @brief Jedan mali fajl.
+*/
+typedef struct
+{
+    const char *inPath;
+    const char *outArg;             /**< Putanja izlaza kao kod stream.h, NULL za podrazumevanu */
+    char outPath[STREAM_PATH_MAX];  /**< Putanja napravljenog izlaza */
+    int status;                     /**< 0, kod greske iz global.h ili SMALLFILE_FALLBACK */
+    uint64_t length;                /**< Broj bajtova originalnog fajla */
+    uint32_t crc;                   /**< CRC registar originalnog fajla */
+} smallfile_t;
+
+/**
+* @brief Funkcija koja enkriptuje ili dekriptuje grupu malih fajlova.
+* @param[in] ctx Kontekst algoritma.
+* @param[in] encrypt 1 za enkripciju, 0 za dekripciju.
+* @param[in,out] files Fajlovi; status, duzina, CRC i putanja izlaza se popunjavaju.
+* @param[in] count Broj fajlova, najvise SMALLFILE_MAX_FILES.
+* @param[in] started Funkcija koja se poziva za svaki napravljen izlaz, moze biti NULL. Uz nju se
+* izlazi prvo otvaraju, pa tek onda upisuju (dva io_uring_enter poziva umesto jednog).
+* @param[in] arg Argument za started.
+* @return 0, ili -1 ukoliko io_uring nije dostupan (tada se nijedan fajl ne dira).
+*/
+int smallProcessFiles(cipherctx_t *ctx, int encrypt, smallfile_t *files, int count,
+                      smallstartfunc_t started, void *arg);
+
+#endif // _SMALLFILE_H_
@@ -0,0 +1,1570 @@
+/**
+* @file
+* @brief Enkripcija/dekripcija fajlova preko konteksta iz cipher.h.
+*/
+
+/// O_DIRECT, O_TMPFILE, renameat2, syncfs, sync_file_range i fallocate
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "stream.h"
+#include "throttle.h"
+#include "uring.h"
+#include "../rng/rng.h"
+
+/**
+* @brief Broj pokusaja da se nadje slobodno ime izlaza prilikom dekripcije.
+*/
+#define NAME_TRIES 16
+
+/**
+* @brief Izabrani nacin prenosa podataka.
+*/
+static streamengine_t engine = STREAM_ENGINE_PREAD;
+
+/**
+* @brief Izabrani odnos prema kesu.
+*/
+static streamcache_t cacheMode = STREAM_CACHE_KEEP;
+
+/**
+* @brief Cuvanje rupa pri enkripciji (streamSetSparse).
+*/
+static int sparseMode = 0;
+
+/**
+* @brief Izabrana trajnost izlaza i velicina grupe.
+*/
+static streamsync_t syncMode = STREAM_SYNC_NONE;
+static long groupFiles = STREAM_GROUP_FILES;
+static uint64_t groupBytes = STREAM_GROUP_BYTES;
+
+/**
+* @brief Izlazi objavljeni od poslednjeg syncfs poziva (STREAM_SYNC_GROUP).
+* @private
+*/
+static struct
+{
+    pthread_mutex_t lock;
+    pthread_mutex_t syncLock;       /**< Grupe se spustaju na disk jedna za drugom */
+    uint64_t current;               /**< Redni broj grupe koja se puni */
+    uint64_t synced;                /**< Grupe sa manjim rednim brojem su na disku */
+    long files;
+    uint64_t bytes;
+    dev_t dev;
+    int mixed;                      /**< Izlazi su na vise fajl sistema */
+    char path[STREAM_PATH_MAX];     /**< Jedan izlaz grupe, za syncfs */
+} group = { .lock = PTHREAD_MUTEX_INITIALIZER, .syncLock = PTHREAD_MUTEX_INITIALIZER };
+
+/**
+* @brief Nacin pravljenja izlaza enkripcije.
+* @private
+*/
+typedef enum
+{
+    OUTPUT_CREATE,      /**< Fajl bez imena, ili ime sa STREAM_TMP_SUFFIX ukoliko O_TMPFILE nije podrzan */
+    OUTPUT_NAMED,       /**< Uvek ime sa STREAM_TMP_SUFFIX */
+    OUTPUT_REOPEN       /**< Postojeci fajl sa imenom sa STREAM_TMP_SUFFIX */
+} outputmode_t;
+
+/**
+* @brief Deo koji je upisan, a jos nije izbacen iz kesa.
+* @private
+*/
+typedef struct
+{
+    uint64_t inOff, outOff;
+    size_t inLen, outLen;
+} dropstate_t;
+
+void streamSetEngine(streamengine_t value)
+{
+    engine = value;
+}
+
+int streamSetCacheMode(streamcache_t mode)
+{
+#ifndef O_DIRECT
+    if (mode == STREAM_CACHE_DIRECT)
+        return -1;
+#endif
+    cacheMode = mode;
+    return 0;
+}
+
+void streamSetSparse(int sparse)
+{
+    sparseMode = sparse;
+}
+
+void streamSetSync(streamsync_t mode, long files, uint64_t bytes)
+{
+    syncMode = mode;
+    groupFiles = files > 0 ? files : STREAM_GROUP_FILES;
+    groupBytes = bytes ? bytes : STREAM_GROUP_BYTES;
+}
+
+streamsync_t streamGetSync(void)
+{
+    return syncMode;
+}
+
+/**
+* @brief Funkcija koja upisuje u dir putanju direktorijuma u kom je fajl.
+* @private
+*/
+static void parentDir(const char *path, char *dir)
+{
+    char *name;
+
+    snprintf(dir, STREAM_PATH_MAX, "%s", path);
+    name = get_filename_from_path(dir);
+    if (name == dir)
+        strcpy(dir, ".");
+    else
+        *name = '\0';
+}
+
+void streamSyncDir(const char *path)
+{
+    char dir[STREAM_PATH_MAX];
+    int fd;
+
+    parentDir(path, dir);
+    if ((fd = open(dir, O_RDONLY)) >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+int streamRenameNoReplace(const char *from, const char *to)
+{
+#ifdef RENAME_NOREPLACE
+    if (!renameat2(AT_FDCWD, from, AT_FDCWD, to, RENAME_NOREPLACE))
+        return 0;
+    if (errno != EINVAL && errno != ENOSYS)
+        return -1;
+#endif
+    /// link ne prepisuje postojeci fajl; sistemi fajlova bez linkova prolaze kroz proveru i rename
+    if (!link(from, to))
+        return unlink(from);
+    if (errno == EEXIST)
+        return -1;
+    if (!access(to, F_OK))
+    {
+        errno = EEXIST;
+        return -1;
+    }
+    return rename(from, to);
+}
+
+/**
+* @brief Funkcija koja spusta na disk fajl sistem izlaza grupe, ili sve fajl sisteme ukoliko su
+* izlazi grupe na vise njih.
+* @private
+*/
+static void syncGroup(const char *path, int mixed)
+{
+#ifdef __linux__
+    int fd;
+
+    if (!mixed && (fd = open(path, O_RDONLY)) >= 0)
+    {
+        int failed = syncfs(fd);
+
+        close(fd);
+        if (!failed)
+            return;
+    }
+#endif
+    sync();
+}
+
+void streamSyncFlush(void)
+{
+    char path[STREAM_PATH_MAX];
+    uint64_t id;
+    long files;
+    int mixed;
+
+    /// grupa se zatvara i kada je prazna, jer su tada na disku vec svi izlazi pre nje
+    pthread_mutex_lock(&group.syncLock);
+    pthread_mutex_lock(&group.lock);
+    strcpy(path, group.path);
+    mixed = group.mixed;
+    files = group.files;
+    group.files = group.bytes = 0;
+    id = ++group.current;
+    pthread_mutex_unlock(&group.lock);
+
+    if (files)
+        syncGroup(path, mixed);
+
+    pthread_mutex_lock(&group.lock);
+    group.synced = id;
+    pthread_mutex_unlock(&group.lock);
+    pthread_mutex_unlock(&group.syncLock);
+}
+
+uint64_t streamSyncGroup(void)
+{
+    uint64_t id;
+
+    pthread_mutex_lock(&group.lock);
+    id = group.current;
+    pthread_mutex_unlock(&group.lock);
+    return id;
+}
+
+uint64_t streamSyncedGroups(void)
+{
+    uint64_t synced;
+
+    pthread_mutex_lock(&group.lock);
+    synced = group.synced;
+    pthread_mutex_unlock(&group.lock);
+    return synced;
+}
+
+/**
+* @brief Funkcija koja posle objavljivanja izlaza primenjuje trajnost: direktorijum uz STREAM_SYNC_FILE,
+* a uz STREAM_SYNC_GROUP dodaje izlaz grupi i spusta je na disk kada je puna.
+* @private
+*/
+static void commitOutput(const char *path, uint64_t bytes)
+{
+    struct stat st;
+    int full;
+
+    if (syncMode == STREAM_SYNC_FILE)
+        streamSyncDir(path);
+    if (syncMode != STREAM_SYNC_GROUP || stat(path, &st))
+        return;
+
+    pthread_mutex_lock(&group.lock);
+    if (!group.files)
+    {
+        snprintf(group.path, sizeof(group.path), "%s", path);
+        group.dev = st.st_dev;
+        group.mixed = 0;
+    }
+    else if (st.st_dev != group.dev)
+        group.mixed = 1;
+    group.files++;
+    group.bytes += bytes;
+    full = group.files >= groupFiles || group.bytes >= groupBytes;
+    pthread_mutex_unlock(&group.lock);
+
+    if (full)
+        streamSyncFlush();
+}
+
+/**
+* @brief Funkcija koja fajlu bez imena (O_TMPFILE) daje ime. Ne zamenjuje postojeci fajl.
+* @return 0 ili -1 (errno EEXIST ukoliko ime postoji).
+* @private
+*/
+static int linkTmpfile(int fd, const char *path)
+{
+#ifdef O_TMPFILE
+    char proc[64];
+
+    /// AT_EMPTY_PATH trazi CAP_DAC_READ_SEARCH, pa se prvo koristi putanja iz /proc
+    snprintf(proc, sizeof(proc), "/proc/self/fd/%d", fd);
+    if (!linkat(AT_FDCWD, proc, AT_FDCWD, path, AT_SYMLINK_FOLLOW))
+        return 0;
+    if (errno == EEXIST)
+        return -1;
+    return linkat(fd, "", AT_FDCWD, path, AT_EMPTY_PATH);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+int streamPublish(int fd, const char *tmpPath, char *outPath, int noReplace, uint64_t bytes)
+{
+    char linkPath[STREAM_PATH_MAX], name[STREAM_PATH_MAX], *base;
+    int status = -1, i, len;
+
+    if (syncMode == STREAM_SYNC_FILE && fd >= 0 && fdatasync(fd))
+        return IO_ERR;
+
+    base = get_filename_from_path(outPath);
+    snprintf(name, sizeof(name), "%s", base);
+    for (i = 0; i < NAME_TRIES; i++)
+    {
+        status = tmpPath ? (noReplace ? streamRenameNoReplace(tmpPath, outPath) : rename(tmpPath, outPath))
+                         : linkTmpfile(fd, outPath);
+        if (!status || errno != EEXIST)
+            break;
+
+        /// postojeci fajl se zamenjuje preko privremenog imena, jer linkat ne prepisuje
+        if (!noReplace)
+        {
+            len = snprintf(linkPath, sizeof(linkPath), "%s" STREAM_TMP_SUFFIX, outPath);
+            if (len < 0 || (size_t) len >= sizeof(linkPath))
+                break;
+            unlink(linkPath);
+            if (!(status = linkTmpfile(fd, linkPath)) && (status = rename(linkPath, outPath)))
+                unlink(linkPath);
+            break;
+        }
+        if (snprintf(base, outPath + STREAM_PATH_MAX - base, "%d%s", (int) (rngU32() >> 1), name) >=
+            outPath + STREAM_PATH_MAX - base)
+        {
+            status = -1;
+            break;
+        }
+    }
+    if (status)
+        return IO_ERR;
+
+    commitOutput(outPath, bytes);
+    return 0;
+}
+
+/**
+* @brief Funkcija koja cita tacno len bajtova od zadate pozicije, osim na kraju fajla.
+* @return Broj procitanih bajtova ili -1.
+* @private
+*/
+static ssize_t preadFull(int fd, void *buf, size_t len, off_t off)
+{
+    size_t done = 0;
+
+    throttleAcquire(THROTTLE_READ, len);
+    while (done < len)
+    {
+        ssize_t n = pread(fd, (char*) buf + done, len - done, off + done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return -1;
+        if (n == 0)
+            break;
+        done += n;
+    }
+    return done;
+}
+
+/**
+* @brief Funkcija koja upisuje tacno len bajtova na zadatu poziciju.
+* @return 0 ili -1.
+* @private
+*/
+static int pwriteFull(int fd, const void *buf, size_t len, off_t off)
+{
+    size_t done = 0;
+
+    throttleAcquire(THROTTLE_WRITE, len);
+    while (done < len)
+    {
+        ssize_t n = pwrite(fd, (const char*) buf + done, len - done, off + done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        done += n;
+    }
+    return 0;
+}
+
+/**
+* @brief Funkcija koja cita do len bajtova od zadate pozicije preko O_DIRECT deskriptora: citanje se
+* prosiruje do poravnatih granica u poravnati bafer io, a trazeni bajtovi se kopiraju u dst.
+* @return Broj procitanih bajtova ili -1.
+* @private
+*/
+static ssize_t preadDirect(int fd, uc *io, uc *dst, size_t len, off_t off)
+{
+    off_t start = off / STREAM_ALIGN * STREAM_ALIGN;
+    size_t span = (off + len - start + STREAM_ALIGN - 1) / STREAM_ALIGN * STREAM_ALIGN;
+    ssize_t got = preadFull(fd, io, span, start);
+
+    if (got < 0)
+        return -1;
+    got = got > off - start ? got - (off - start) : 0;
+    if ((size_t) got > len)
+        got = len;
+    memcpy(dst, io + (off - start), got);
+    return got;
+}
+
+/**
+* @brief Funkcija koja upisuje tacno len bajtova na zadatu poziciju: poravnati srednji deo preko
+* O_DIRECT deskriptora, a neporavnati pocetak i kraj preko obicnog. Adresa src mora imati isti
+* ostatak pri deljenju sa STREAM_ALIGN kao off.
+* @return 0 ili -1.
+* @private
+*/
+static int pwriteDirect(int fdDirect, int fd, const uc *src, size_t len, off_t off)
+{
+    off_t first = (off + STREAM_ALIGN - 1) / STREAM_ALIGN * STREAM_ALIGN;
+    off_t last = (off + len) / STREAM_ALIGN * STREAM_ALIGN;
+
+    if (last <= first)
+        return pwriteFull(fd, src, len, off);
+    if (first > off && pwriteFull(fd, src, first - off, off))
+        return -1;
+    if (pwriteFull(fdDirect, src + (first - off), last - first, first))
+        return -1;
+    if (off + (off_t) len > last && pwriteFull(fd, src + (last - off), off + len - last, last))
+        return -1;
+    return 0;
+}
+
+/**
+* @brief Funkcija koja posle upisa dela pokrece njegov upis na disk, a prethodni deo, kada je upisan,
+* izbacuje iz kesa (ulaz i izlaz). Poziv sa nultim duzinama izbacuje poslednji deo.
+* @private
+*/
+static void dropBehind(streamjob_t *job, dropstate_t *drop, uint64_t inOff, size_t inLen, uint64_t outOff, size_t outLen)
+{
+    if (job->cache == STREAM_CACHE_KEEP)
+        return;
+
+#ifdef __linux__
+    if (outLen && job->outFd >= 0)
+        sync_file_range(job->outFd, outOff, outLen, SYNC_FILE_RANGE_WRITE);
+    if (drop->outLen && job->outFd >= 0)
+        sync_file_range(job->outFd, drop->outOff, drop->outLen,
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+#endif
+#ifdef POSIX_FADV_DONTNEED
+    if (drop->outLen && job->outFd >= 0)
+        posix_fadvise(job->outFd, drop->outOff, drop->outLen, POSIX_FADV_DONTNEED);
+    if (drop->inLen)
+        posix_fadvise(job->inFd, drop->inOff, drop->inLen, POSIX_FADV_DONTNEED);
+#endif
+
+    drop->inOff = inOff;
+    drop->inLen = inLen;
+    drop->outOff = outOff;
+    drop->outLen = outLen;
+}
+
+/**
+* @brief Funkcija koja bira odnos posla prema kesu po velicini fajla.
+* @private
+*/
+static void chooseCache(streamjob_t *job, uint64_t size)
+{
+    job->cache = cacheMode;
+    if (cacheMode == STREAM_CACHE_AUTO)
+        job->cache = size >= STREAM_DIRECT_MIN ? STREAM_CACHE_DIRECT :
+                     size >= STREAM_DONTNEED_MIN ? STREAM_CACHE_DONTNEED : STREAM_CACHE_KEEP;
+    /// mapirani fajlovi su sami deo kesa
+    if (engine == STREAM_ENGINE_MMAP)
+        job->cache = STREAM_CACHE_KEEP;
+}
+
+/**
+* @brief Funkcija koja uz STREAM_CACHE_DIRECT i pread/pwrite otvara O_DIRECT deskriptor fajla.
+* @return Deskriptor ili -1 (tada se posao ponasa kao STREAM_CACHE_DONTNEED).
+* @private
+*/
+static int openDirect(streamjob_t *job, const char *path, int flags)
+{
+#ifdef O_DIRECT
+    if (job->cache == STREAM_CACHE_DIRECT && engine == STREAM_ENGINE_PREAD)
+        return open(path, flags | O_DIRECT);
+#endif
+    return -1;
+}
+
+/**
+* @brief Funkcija koja priprema izlaz za izabrani odnos prema kesu: otvara O_DIRECT deskriptor i
+* iskljucuje citanje unapred, koje bi pri upisu neporavnatih delova (heder, krajevi) vratilo u kes
+* okolne stranice.
+* @private
+*/
+static void prepareOutput(streamjob_t *job)
+{
+    char proc[64];
+
+    /// fajl bez imena se ponovo otvara preko /proc
+    snprintf(proc, sizeof(proc), "/proc/self/fd/%d", job->outFd);
+    job->outDirect = openDirect(job, job->tmpPath[0] ? job->tmpPath : proc, O_WRONLY);
+#ifdef POSIX_FADV_RANDOM
+    if (job->cache != STREAM_CACHE_KEEP)
+        posix_fadvise(job->outFd, 0, 0, POSIX_FADV_RANDOM);
+#endif
+}
+
+/**
+* @brief Funkcija koja pravi bafere za obradu opsega: bafer podataka (sa mestom za pomeranje do
+* poravnanja izlaza) i, uz O_DIRECT ulaz, bafer za poravnato citanje.
+* @return 0 ili ALLOC_ERR.
+* @private
+*/
+static int allocBuffers(streamjob_t *job, uc **buf, uc **io)
+{
+    *io = NULL;
+    if (posix_memalign((void**) buf, STREAM_ALIGN, STREAM_BUF_LEN + STREAM_ALIGN))
+        return ALLOC_ERR;
+    if (job->inDirect >= 0 && posix_memalign((void**) io, STREAM_ALIGN, STREAM_BUF_LEN + 2 * STREAM_ALIGN))
+    {
+        free(*buf);
+        return ALLOC_ERR;
+    }
+    return 0;
+}
+
+/**
+* @brief Funkcija koja cita podatke posla preko O_DIRECT ili obicnog deskriptora ulaza.
+* @return Broj procitanih bajtova ili -1.
+* @private
+*/
+static ssize_t readData(streamjob_t *job, uc *io, uc *dst, size_t len, off_t off)
+{
+    if (job->inDirect >= 0)
+        return preadDirect(job->inDirect, io, dst, len, off);
+    return preadFull(job->inFd, dst, len, off);
+}
+
+/**
+* @brief Funkcija koja upisuje podatke posla preko O_DIRECT (uz obican za neporavnate krajeve) ili
+* obicnog deskriptora izlaza.
+* @return 0 ili -1.
+* @private
+*/
+static int writeData(streamjob_t *job, const uc *src, size_t len, off_t off)
+{
+    if (job->outDirect >= 0)
+        return pwriteDirect(job->outDirect, job->outFd, src, len, off);
+    return pwriteFull(job->outFd, src, len, off);
+}
+
+/**
+* @brief Funkcija koja zatvara fajlove posla i po potrebi brise izlaz.
+* @private
+*/
+static void closeJob(streamjob_t *job, int removeOutput)
+{
+    if (job->inMap)
+        munmap(job->inMap, job->inMapLen);
+    if (job->outMap)
+        munmap(job->outMap, job->outMapLen);
+    job->inMap = job->outMap = NULL;
+
+    if (job->inDirect >= 0)
+        close(job->inDirect);
+    if (job->outDirect >= 0)
+        close(job->outDirect);
+    /// neporavnati krajevi upisani mimo O_DIRECT, poslednji opseg, heder i velike stranice kesa koje
+    /// prelaze granicu opsega; prljave stranice se ne izbacuju iz kesa, pa se upis prvo zavrsava
+    if (job->cache != STREAM_CACHE_KEEP) {
+#ifdef __linux__
+        if (job->outFd >= 0 && !removeOutput)
+            sync_file_range(job->outFd, 0, 0,
+                            SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+#endif
+#ifdef POSIX_FADV_DONTNEED
+        if (job->outFd >= 0 && !removeOutput)
+            posix_fadvise(job->outFd, 0, 0, POSIX_FADV_DONTNEED);
+        if (job->inFd >= 0)
+            posix_fadvise(job->inFd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+    }
+    job->inDirect = job->outDirect = -1;
+
+    if (job->inFd >= 0)
+        close(job->inFd);
+    if (job->outFd >= 0)
+        close(job->outFd);
+    /// fajl bez imena nestaje sam kada se zatvori
+    if (removeOutput && job->tmpPath[0])
+        unlink(job->tmpPath);
+    job->inFd = job->outFd = -1;
+
+    free(job->holes);
+    job->holes = NULL;
+    job->holeCount = 0;
+}
+
+/**
+* @brief Funkcija koja mapira ulaz posla za citanje, ukoliko je izabran STREAM_ENGINE_MMAP.
+* Ukoliko mapiranje ne uspe, posao nastavlja preko pread.
+* @private
+*/
+static void mapInput(streamjob_t *job, size_t len)
+{
+    void *map;
+
+    if (engine != STREAM_ENGINE_MMAP || !len)
+        return;
+
+    map = mmap(NULL, len, PROT_READ, MAP_SHARED, job->inFd, 0);
+    if (map == MAP_FAILED)
+        return;
+    madvise(map, len, MADV_SEQUENTIAL);
+    job->inMap = map;
+    job->inMapLen = len;
+}
+
+/**
+* @brief Funkcija koja postavlja konacnu velicinu izlaza i rezervise prostor za njega (osim za posao sa
+* rupama, ciji izlaz mora da ih zadrzi).
+* @return 0 ili -1 ukoliko nema mesta na disku.
+* @private
+*/
+static int sizeOutput(streamjob_t *job, uint64_t len)
+{
+#ifdef __linux__
+    /// nedostatak mesta se prijavljuje odmah, a ne usred obrade (ili kao SIGBUS pri upisu u mapu izlaza)
+    if (len && !job->holeCount && !fallocate(job->outFd, 0, 0, len))
+        return 0;
+    if (len && !job->holeCount && errno != EOPNOTSUPP && errno != ENOSYS)
+        return -1;
+#endif
+    return ftruncate(job->outFd, len);
+}
+
+/**
+* @brief Funkcija koja mapira izlaz posla za pisanje, ukoliko je izabran STREAM_ENGINE_MMAP. Izlaz
+* mora vec imati konacnu velicinu (sizeOutput).
+* @return 0.
+* @private
+*/
+static int mapOutput(streamjob_t *job, size_t len)
+{
+    void *map;
+
+    if (engine != STREAM_ENGINE_MMAP || !len)
+        return 0;
+
+    map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, job->outFd, 0);
+    if (map == MAP_FAILED)
+        return 0;
+    job->outMap = map;
+    job->outMapLen = len;
+    return 0;
+}
+
+/**
+* @brief Funkcija koja pravi izlaz u koji se pise: fajl bez imena u direktorijumu job->outPath ili,
+* ukoliko O_TMPFILE nije podrzan ili je zadato named, job->outPath sa STREAM_TMP_SUFFIX.
+* @return 0 ili -1.
+* @private
+*/
+static int createOutput(streamjob_t *job, int named)
+{
+    int len;
+
+    job->tmpPath[0] = '\0';
+#ifdef O_TMPFILE
+    if (!named)
+    {
+        char dir[STREAM_PATH_MAX];
+
+        parentDir(job->outPath, dir);
+        if ((job->outFd = open(dir, O_TMPFILE | O_RDWR, 0666)) >= 0)
+            return 0;
+    }
+#endif
+    len = snprintf(job->tmpPath, sizeof(job->tmpPath), "%s" STREAM_TMP_SUFFIX, job->outPath);
+    if (len < 0 || (size_t) len >= sizeof(job->tmpPath))
+    {
+        job->tmpPath[0] = '\0';
+        return -1;
+    }
+    /// uz noReplace isto ime mogu da izaberu dva posla, pa se ime sa sufiksom zauzima
+    job->outFd = open(job->tmpPath, O_RDWR | O_CREAT | (job->noReplace ? O_EXCL : O_TRUNC), 0666);
+    if (job->outFd < 0)
+        job->tmpPath[0] = '\0';
+    return job->outFd < 0;
+}
+
+/**
+* @brief Funkcija koja pravi mapu rupa ulaza (samo blokovi koji su celi u rupi), ukoliko je cuvanje
+* rupa ukljuceno. Ukoliko SEEK_HOLE nije podrzan, fajl nema rupa.
+* @private
+*/
+static void findHoles(streamjob_t *job, const struct stat *st)
+{
+#ifdef SEEK_HOLE
+    int bs = job->ctx->blockSize;
+    streamhole_t *grown;
+    size_t capacity = 0;
+    off_t off = 0, hole, data;
+    uint64_t first, last;
+
+    /// fajl bez rupa zauzima bar onoliko mesta koliko je dugacak
+    if (!sparseMode || (uint64_t) st->st_blocks * 512 >= (uint64_t) st->st_size)
+        return;
+
+    while (off < st->st_size && job->holeCount < STREAM_HOLES_MAX)
+    {
+        if ((hole = lseek(job->inFd, off, SEEK_HOLE)) < 0 || hole >= st->st_size)
+            break;
+        /// ENXIO: rupa traje do kraja fajla
+        if ((data = lseek(job->inFd, hole, SEEK_DATA)) < 0)
+            data = st->st_size;
+
+        first = (hole + bs - 1) / bs;
+        last = data >= st->st_size ? job->blocks : (uint64_t) (data / bs);
+        if (last > first && job->holeCount && job->holes[job->holeCount - 1].first +
+                                              job->holes[job->holeCount - 1].count == first)
+            job->holes[job->holeCount - 1].count += last - first;
+        else if (last > first)
+        {
+            if (job->holeCount == capacity)
+            {
+                capacity = capacity ? 2 * capacity : 64;
+                if (!(grown = (streamhole_t*) realloc(job->holes, capacity * sizeof(*grown))))
+                    break;
+                job->holes = grown;
+            }
+            job->holes[job->holeCount].first = first;
+            job->holes[job->holeCount++].count = last - first;
+        }
+        off = data;
+    }
+#endif
+}
+
+/**
+* @brief Funkcija koja vraca duzinu niza blokova od block (najvise count) koji su svi u rupi ili svi
+* sa podacima.
+* @param[out] hole 1 ukoliko je niz u rupi.
+* @private
+*/
+static uint64_t holeRun(const streamjob_t *job, uint64_t block, uint64_t count, int *hole)
+{
+    size_t lo = 0, hi = job->holeCount, mid;
+    uint64_t run;
+
+    /// prva rupa koja se zavrsava posle bloka
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        if (job->holes[mid].first + job->holes[mid].count <= block)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    *hole = lo < job->holeCount && job->holes[lo].first <= block;
+    if (*hole)
+        run = job->holes[lo].first + job->holes[lo].count - block;
+    else
+        run = lo < job->holeCount ? job->holes[lo].first - block : count;
+    return run < count ? run : count;
+}
+
+/**
+* @brief Funkcija koja proverava da li je blok u rupi.
+* @private
+*/
+static int holeAt(const streamjob_t *job, uint64_t block)
+{
+    int hole;
+
+    holeRun(job, block, 1, &hole);
+    return hole;
+}
+
+/**
+* @brief Funkcija koja izvodi vektor ulancavanja za blok posle rupe (i za mapu rupa): IV hedera sa
+* rednim brojem bloka dodatim preko XOR-a, da lanci posle razlicitih rupa ne pocinju isto.
+* @private
+*/
+static void holeIv(const streamjob_t *job, uint64_t block, uc *iv)
+{
+    int i;
+
+    memcpy(iv, job->header.IV, job->ctx->blockSize);
+    for (i = 0; i < 8; i++)
+        iv[i] ^= (uc) (block >> (8 * i));
+}
+
+/**
+* @brief Funkcija koja vraca velicinu .dat fajla: heder, podaci i mapa rupa.
+* @private
+*/
+static uint64_t outputLength(const streamjob_t *job)
+{
+    return job->ctx->headerSize + job->blocks * job->ctx->blockSize + job->holeCount * sizeof(streamhole_t);
+}
+
+/**
+* @brief Funkcija koja sifruje i upisuje mapu rupa posle podataka.
+* @return 0, ALLOC_ERR ili IO_ERR.
+* @private
+*/
+static int writeHoles(streamjob_t *job)
+{
+    size_t len = job->holeCount * sizeof(streamhole_t);
+    uc iv[CIPHER_BLOCK_MAX];
+    uc *map;
+    int status = 0;
+
+    if (!(map = (uc*) malloc(len)))
+        return ALLOC_ERR;
+    memcpy(map, job->holes, len);
+    holeIv(job, job->blocks, iv);
+    cipherEncrypt(job->ctx, map, len, job->ctx->cbc ? iv : NULL);
+    if (pwriteFull(job->outFd, map, len, job->ctx->headerSize + job->blocks * job->ctx->blockSize))
+        status = IO_ERR;
+    free(map);
+    return status;
+}
+
+/**
+* @brief Funkcija koja cita i desifruje mapu rupa .dat fajla i proverava je (rupe u rastucem
+* redosledu, unutar podataka).
+* @param[in] len Broj bajtova posle podataka.
+* @return 0 ili FILE_ERR.
+* @private
+*/
+static int readHoles(streamjob_t *job, uint64_t len)
+{
+    uc iv[CIPHER_BLOCK_MAX];
+    uint64_t end = 0;
+    size_t i;
+
+    if (!len || len % sizeof(streamhole_t) || len > STREAM_HOLES_MAX * sizeof(streamhole_t) ||
+        !(job->holes = (streamhole_t*) malloc(len)))
+        return FILE_ERR;
+    job->holeCount = len / sizeof(streamhole_t);
+
+    if (preadFull(job->inFd, job->holes, len, job->ctx->headerSize + job->blocks * job->ctx->blockSize) != (ssize_t) len)
+        return FILE_ERR;
+    holeIv(job, job->blocks, iv);
+    cipherDecrypt(job->ctx, (uc*) job->holes, len, job->ctx->cbc ? iv : NULL);
+
+    for (i = 0; i < job->holeCount; i++)
+    {
+        if (job->holes[i].first < end || job->holes[i].first >= job->blocks || !job->holes[i].count ||
+            job->holes[i].count > job->blocks - job->holes[i].first)
+            return FILE_ERR;
+        end = job->holes[i].first + job->holes[i].count;
+    }
+    return 0;
+}
+
+/**
+* @brief Funkcija koja otvara ulaz i izlaz za enkripciju i popunjava heder (bez IV-a).
+* @return 0 ili FILE_ERR.
+* @private
+*/
+static int openPlain(streamjob_t *job, cipherctx_t *ctx, const char *inPath, const char *outPath, outputmode_t mode)
+{
+    struct stat st;
+    int bs = ctx->blockSize, len;
+
+    memset(job, 0, sizeof(*job));
+    job->ctx = ctx;
+    job->outFd = job->inDirect = job->outDirect = -1;
+
+    throttleAcquire(THROTTLE_FILES, 1);
+    job->inFd = open(inPath, O_RDONLY);
+    if (job->inFd < 0)
+        return FILE_ERR;
+
+    if (fstat(job->inFd, &st) || !S_ISREG(st.st_mode))
+    {
+        closeJob(job, 0);
+        return FILE_ERR;
+    }
+    chooseCache(job, st.st_size);
+    job->inDirect = openDirect(job, inPath, O_RDONLY);
+
+    if (outPath)
+        len = snprintf(job->outPath, sizeof(job->outPath), "%s", outPath);
+    else
+        len = snprintf(job->outPath, sizeof(job->outPath), "%s.dat", inPath);
+
+    /// skraceno ime bi se objavilo kao drugi fajl, pa izlaz ostaje neotvoren
+    if (len < 0 || (size_t) len >= sizeof(job->outPath))
+        job->outFd = -1;
+    else if (mode == OUTPUT_REOPEN)
+    {
+        len = snprintf(job->tmpPath, sizeof(job->tmpPath), "%s" STREAM_TMP_SUFFIX, job->outPath);
+        if (len >= 0 && (size_t) len < sizeof(job->tmpPath))
+            job->outFd = open(job->tmpPath, O_RDWR);
+    }
+    else
+        createOutput(job, mode == OUTPUT_NAMED);
+    if (job->outFd < 0)
+    {
+        job->tmpPath[0] = '\0';
+        closeJob(job, 0);
+        return FILE_ERR;
+    }
+    prepareOutput(job);
+
+    job->length = st.st_size;
+    job->blocks = (job->length + bs - 1) / bs;
+    findHoles(job, &st);
+    mapInput(job, job->length);
+
+    strncpy((char*) job->header.fileName, get_filename_from_path((char*) inPath), FILENAME_LEN_MAX - 1);
+    job->header.byteLength = job->length;
+    return 0;
+}
+
+/**
+* @brief Funkcija koja otvara ulaz i pravi izlaz za enkripciju zadate velicine.
+* @return 0, FILE_ERR ili IO_ERR.
+* @private
+*/
+static int openEncrypt(streamjob_t *job, cipherctx_t *ctx, const char *inPath, const char *outPath, outputmode_t mode)
+{
+    if (openPlain(job, ctx, inPath, outPath, mode))
+        return FILE_ERR;
+
+    rngBytes(job->header.IV, sizeof(job->header.IV));
+
+    if (sizeOutput(job, outputLength(job)) || mapOutput(job, ctx->headerSize + job->blocks * ctx->blockSize))
+    {
+        closeJob(job, 1);
+        return IO_ERR;
+    }
+
+    return 0;
+}
+
+int streamEncryptOpen(streamjob_t *job, cipherctx_t *ctx, const char *inPath, const char *outPath)
+{
+    return openEncrypt(job, ctx, inPath, outPath, OUTPUT_CREATE);
+}
+
+int streamEncryptOpenNamed(streamjob_t *job, cipherctx_t *ctx, const char *inPath, const char *outPath)
+{
+    return openEncrypt(job, ctx, inPath, outPath, OUTPUT_NAMED);
+}
+
+int streamEncryptReopen(streamjob_t *job, cipherctx_t *ctx, const char *inPath, const char *outPath, const uc *iv)
+{
+    struct stat st;
+
+    if (openPlain(job, ctx, inPath, outPath, OUTPUT_REOPEN))
+        return FILE_ERR;
+
+    memcpy(job->header.IV, iv, sizeof(job->header.IV));
+
+    /// izlaz koji nije napravljen za ovaj ulaz se ne dira
+    if (fstat(job->outFd, &st) || (uint64_t) st.st_size != outputLength(job))
+    {
+        job->tmpPath[0] = '\0';
+        closeJob(job, 0);
+        return FILE_ERR;
+    }
+
+    if (sizeOutput(job, st.st_size) || mapOutput(job, ctx->headerSize + job->blocks * ctx->blockSize))
+    {
+        closeJob(job, 0);
+        return IO_ERR;
+    }
+
+    return 0;
+}
+
+/**
+* @brief Stanje bafera u io_uring obradi opsega.
+* @private
+*/
+typedef enum
+{
+    SLOT_FREE,
+    SLOT_READ,          /**< Citanje je predato */
+    SLOT_READY,         /**< Procitan, ceka obradu */
+    SLOT_WRITE          /**< Pisanje je predato */
+} slotstate_t;
+
+/**
+* @brief Jedan deo opsega u io_uring obradi.
+* @private
+*/
+typedef struct
+{
+    slotstate_t state;
+    uint64_t off;       /**< Pozicija dela u podacima */
+    size_t len;         /**< Duzina dela (umnozak velicine bloka) */
+    uint64_t fileOff;   /**< Pozicija tekuceg citanja/pisanja u fajlu */
+    size_t want, done;  /**< Broj bajtova tekuceg citanja/pisanja i broj vec prenetih */
+    size_t inLen;       /**< Broj procitanih bajtova (za izbacivanje iz kesa) */
+} uringslot_t;
+
+/**
+* @brief Funkcija koja priprema citanje ili pisanje ostatka dela u baferu idx.
+* @return 0 ili -1 ukoliko je SQ pun.
+* @private
+*/
+static int queueSlot(uringpipe_t *pipe, int idx, uringslot_t *slot, int write, int fd)
+{
+    struct io_uring_sqe *sqe = uringGetSqe(&pipe->ring);
+
+    if (!sqe)
+        return -1;
+
+    sqe->fd = fd;
+    sqe->off = slot->fileOff + slot->done;
+    sqe->user_data = idx;
+    if (pipe->fixed)
+    {
+        sqe->opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        sqe->addr = (uintptr_t) (pipe->bufs[idx] + slot->done);
+        sqe->len = slot->want - slot->done;
+        sqe->buf_index = idx;
+    }
+    else
+    {
+        pipe->iov[idx].iov_base = pipe->bufs[idx] + slot->done;
+        pipe->iov[idx].iov_len = slot->want - slot->done;
+        sqe->opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe->addr = (uintptr_t) &pipe->iov[idx];
+        sqe->len = 1;
+    }
+    return 0;
+}
+
+/**
+* @brief Funkcija koja enkriptuje/dekriptuje opseg blokova kao protocnu obradu preko io_uring-a:
+* delovi se citaju unapred i upisuju asinhrono, a obradjuju se redom u niti pozivaoca.
+* @param[in] encrypt 1 za enkripciju, 0 za dekripciju (iv je tada vec postavljen za prvi blok).
+* @return 0, IO_ERR.
+* @private
+*/
+static int uringRange(streamjob_t *job, uringpipe_t *pipe, int encrypt, uint64_t first, uint64_t count,
+                      uc *iv, uint32_t *crc)
+{
+    int bs = job->ctx->blockSize;
+    int hs = job->ctx->headerSize;
+    uint64_t start = first * bs, end = (first + count) * bs;
+    uint64_t chunks = (end - start + STREAM_BUF_LEN - 1) / STREAM_BUF_LEN;
+    uint64_t nextRead = 0, nextWork = 0;
+    uringslot_t slots[URING_DEPTH], *slot;
+    struct io_uring_cqe *cqe;
+    dropstate_t drop;
+    unsigned inflight = 0;
+    int status = 0, idx, res;
+
+    memset(slots, 0, sizeof(slots));
+    memset(&drop, 0, sizeof(drop));
+    *crc = ~0U;
+
+    while (status ? inflight : (nextWork < chunks || inflight))
+    {
+        /// citanja sledecih delova, dok ima slobodnih bafera
+        while (!status && nextRead < chunks && slots[idx = nextRead % URING_DEPTH].state == SLOT_FREE)
+        {
+            slot = &slots[idx];
+            slot->off = start + nextRead++ * STREAM_BUF_LEN;
+            slot->len = end - slot->off < STREAM_BUF_LEN ? end - slot->off : STREAM_BUF_LEN;
+            slot->fileOff = encrypt ? slot->off : hs + slot->off;
+            slot->done = 0;
+            if (encrypt)
+                slot->want = slot->off >= job->length ? 0 :
+                             (job->length - slot->off < slot->len ? job->length - slot->off : slot->len);
+            else
+                slot->want = slot->len;
+
+            slot->state = slot->want ? SLOT_READ : SLOT_READY;
+            if (!slot->want)
+                continue;
+            throttleAcquire(THROTTLE_READ, slot->want);
+            if (queueSlot(pipe, idx, slot, 0, job->inFd))
+                status = IO_ERR;
+            else
+                inflight++;
+        }
+
+        /// delovi se obradjuju redom, jer CBC lanac i CRC zavise od redosleda
+        while (!status && nextWork < chunks && slots[idx = nextWork % URING_DEPTH].state == SLOT_READY)
+        {
+            uc *data = pipe->bufs[idx];
+
+            slot = &slots[idx];
+            slot->inLen = encrypt ? slot->done : slot->len;
+            nextWork++;
+            if (encrypt)
+            {
+                *crc = crc32Update(*crc, data, slot->done);
+                memset(data + slot->done, 0, slot->len - slot->done);
+                cipherEncrypt(job->ctx, data, slot->len, iv);
+                slot->want = slot->len;
+                slot->fileOff = hs + slot->off;
+            }
+            else
+            {
+                size_t keep = slot->off >= job->length ? 0 :
+                              (job->length - slot->off < slot->len ? job->length - slot->off : slot->len);
+
+                cipherDecrypt(job->ctx, data, slot->len, iv);
+                *crc = crc32Update(*crc, data, keep);
+                slot->want = job->outFd >= 0 ? keep : 0;
+                slot->fileOff = slot->off;
+            }
+
+            slot->done = 0;
+            slot->state = slot->want ? SLOT_WRITE : SLOT_FREE;
+            if (!slot->want)
+            {
+                dropBehind(job, &drop, encrypt ? slot->off : hs + slot->off, slot->inLen, 0, 0);
+                continue;
+            }
+            throttleAcquire(THROTTLE_WRITE, slot->want);
+            if (queueSlot(pipe, idx, slot, 1, job->outFd))
+                status = IO_ERR;
+            else
+                inflight++;
+        }
+
+        if (!inflight)
+            continue;
+
+        /// zahtevi u obradi bez mogucnosti cekanja na njih: baferi se vise ne koriste
+        if (uringSubmit(&pipe->ring, 1) < 0)
+        {
+            uringThreadPipeReset();
+            return IO_ERR;
+        }
+
+        while ((cqe = uringPeek(&pipe->ring)))
+        {
+            idx = (int) cqe->user_data;
+            res = cqe->res;
+            uringSeen(&pipe->ring);
+            inflight--;
+            slot = &slots[idx];
+
+            if (status)
+                continue;
+            if (res == -EINTR || res == -EAGAIN)
+                res = 0;
+            else if (res < 0 || (res == 0 && (slot->state == SLOT_WRITE || !encrypt)))
+            {
+                status = IO_ERR;
+                continue;
+            }
+            /// kraj ulaza pre ocekivanog (fajl je skracen tokom enkripcije), ostatak se dopunjava nulama
+            else if (res == 0)
+                slot->want = slot->done;
+
+            slot->done += res;
+            if (slot->done < slot->want)
+            {
+                if (queueSlot(pipe, idx, slot, slot->state == SLOT_WRITE, slot->state == SLOT_WRITE ? job->outFd : job->inFd))
+                    status = IO_ERR;
+                else
+                    inflight++;
+            }
+            else if (slot->state == SLOT_READ)
+                slot->state = SLOT_READY;
+            else
+            {
+                dropBehind(job, &drop, encrypt ? slot->off : hs + slot->off, slot->inLen, slot->fileOff, slot->want);
+                slot->state = SLOT_FREE;
+            }
+        }
+    }
+    dropBehind(job, &drop, 0, 0, 0, 0);
+
+    return status;
+}
+
+int streamEncryptRange(streamjob_t *job, uint64_t first, uint64_t count, uc *iv, uint32_t *crc)
+{
+    int bs = job->ctx->blockSize;
+    int hs = job->ctx->headerSize;
+    uint64_t off = first * bs, end = (first + count) * bs;
+    uc *buf = NULL, *io = NULL, *data;
+    dropstate_t drop;
+    uringpipe_t *pipe;
+    int status = 0;
+
+    if (engine == STREAM_ENGINE_URING && !job->holeCount && (pipe = uringThreadPipe(STREAM_BUF_LEN)))
+        return uringRange(job, pipe, 1, first, count, iv, crc);
+
+    if (!job->outMap && allocBuffers(job, &buf, &io))
+        return ALLOC_ERR;
+
+    memset(&drop, 0, sizeof(drop));
+    *crc = ~0U;
+    while (off < end)
+    {
+        size_t len = end - off < STREAM_BUF_LEN ? end - off : STREAM_BUF_LEN;
+        ssize_t got;
+        int hole;
+
+        if (job->holeCount)
+        {
+            len = holeRun(job, off / bs, len / bs, &hole) * bs;
+            /// rupa se ne cita i ne upisuje; njen sifrat se u lancu smatra nulama
+            if (hole)
+            {
+                got = off < job->length ? (job->length - off < len ? job->length - off : len) : 0;
+                *crc = crc32Zeros(*crc, got);
+                if (iv)
+                    memset(iv, 0, bs);
+                off += len;
+                continue;
+            }
+            if (iv && off && holeAt(job, off / bs - 1))
+                holeIv(job, off / bs, iv);
+        }
+
+        /// uz mapu izlaza se sifruje direktno u njoj, a uz O_DIRECT izlaz bafer ima poravnatost izlaza
+        if (job->outMap)
+            data = job->outMap + hs + off;
+        else
+            data = buf + (job->outDirect >= 0 ? (hs + off) % STREAM_ALIGN : 0);
+
+        if (job->inMap)
+        {
+            got = off < job->length ? (job->length - off < len ? job->length - off : len) : 0;
+            throttleAcquire(THROTTLE_READ, got);
+            memcpy(data, job->inMap + off, got);
+        }
+        else if ((got = readData(job, io, data, len, off)) < 0)
+        {
+            status = IO_ERR;
+            break;
+        }
+
+        if (off + got > job->length)
+            got = off < job->length ? job->length - off : 0;
+        *crc = crc32Update(*crc, data, got);
+        memset(data + got, 0, len - got);
+
+        cipherEncrypt(job->ctx, data, len, iv);
+
+        if (job->outMap)
+            throttleAcquire(THROTTLE_WRITE, len);
+        else if (writeData(job, data, len, hs + off))
+        {
+            status = IO_ERR;
+            break;
+        }
+        dropBehind(job, &drop, off, got, hs + off, len);
+        off += len;
+    }
+    dropBehind(job, &drop, 0, 0, 0, 0);
+
+    free(buf);
+    free(io);
+    return status;
+}
+
+int streamEncryptClose(streamjob_t *job, uint32_t crc, int status)
+{
+    uc sealed[sizeof(fileheader_t)];
+
+    if (!status && job->holeCount)
+        status = writeHoles(job);
+    if (!status)
+    {
+        job->header.crc = crc;
+        job->header.pad = job->holeCount ? HEADER_SPARSE : 0;
+        cipherSealHeader(job->ctx, &job->header, sealed);
+        if (pwriteFull(job->outFd, sealed, job->ctx->headerSize, 0))
+            status = IO_ERR;
+        else
+            status = streamPublish(job->outFd, job->tmpPath[0] ? job->tmpPath : NULL, job->outPath,
+                                   job->noReplace, outputLength(job));
+    }
+
+    closeJob(job, status != 0);
+    return status;
+}
+
+void streamEncryptSuspend(streamjob_t *job)
+{
+    closeJob(job, 0);
+}
+
+/**
+* @brief Funkcija koja pravi izlaz za dekripciju sa originalnim imenom iz hedera u direktorijumu
+* zadate putanje. Ukoliko fajl vec postoji, na pocetak imena se dodaje slucajan broj; ime se
+* konacno proverava tek pri objavljivanju (streamPublish).
+* @private
+*/
+static int createDecryptOutput(streamjob_t *job, const char *dirPath)
+{
+    char *name;
+    int i, len;
+
+    len = snprintf(job->outPath, sizeof(job->outPath), "%s", dirPath);
+    if (len < 0 || (size_t) len >= sizeof(job->outPath))
+        return 1;
+    name = get_filename_from_path(job->outPath);
+    if (snprintf(name, job->outPath + sizeof(job->outPath) - name, "%s", (char*) job->header.fileName) >=
+        job->outPath + sizeof(job->outPath) - name)
+        return 1;
+    job->noReplace = 1;
+
+    for (i = 0; i < NAME_TRIES; i++)
+    {
+        if (!access(job->outPath, F_OK))
+            errno = EEXIST;
+        else if (!createOutput(job, 0))
+            break;
+        if (errno != EEXIST)
+            break;
+        if (snprintf(name, job->outPath + sizeof(job->outPath) - name, "%d%s",
+                     (int) (rngU32() >> 1), (char*) job->header.fileName) >= job->outPath + sizeof(job->outPath) - name)
+            break;
+    }
+
+    return job->outFd < 0;
+}
+
+/**
+* @brief Funkcija koja otvara .dat fajl i cita heder.
+* @return 0 ili FILE_ERR.
+* @private
+*/
+static int openSealed(streamjob_t *job, cipherctx_t *ctx, const char *inPath)
+{
+    struct stat st;
+    uc sealed[sizeof(fileheader_t)];
+    int bs = ctx->blockSize;
+
+    memset(job, 0, sizeof(*job));
+    job->ctx = ctx;
+    job->outFd = job->inDirect = job->outDirect = -1;
+
+    throttleAcquire(THROTTLE_FILES, 1);
+    job->inFd = open(inPath, O_RDONLY);
+    if (job->inFd < 0)
+        return FILE_ERR;
+
+    if (fstat(job->inFd, &st) || !S_ISREG(st.st_mode) ||
+        preadFull(job->inFd, sealed, ctx->headerSize, 0) != ctx->headerSize)
+    {
+        closeJob(job, 0);
+        return FILE_ERR;
+    }
+    chooseCache(job, st.st_size);
+    job->inDirect = openDirect(job, inPath, O_RDONLY);
+
+    cipherOpenHeader(ctx, sealed, &job->header);
+
+    /// uz mapu rupa je duzina podataka odredjena hederom, a ostatak fajla je mapa
+    if (job->header.pad == HEADER_SPARSE)
+    {
+        job->length = job->header.byteLength;
+        job->blocks = (job->length + bs - 1) / bs;
+        if (job->blocks > (uint64_t) (st.st_size - ctx->headerSize) / bs ||
+            readHoles(job, st.st_size - ctx->headerSize - job->blocks * bs))
+        {
+            closeJob(job, 0);
+            return FILE_ERR;
+        }
+    }
+    else
+    {
+        job->blocks = (st.st_size - ctx->headerSize) / bs;
+        job->length = job->header.byteLength < job->blocks * bs ? job->header.byteLength : job->blocks * bs;
+    }
+    mapInput(job, ctx->headerSize + job->blocks * bs);
+    return 0;
+}
+
+int streamDecryptOpen(streamjob_t *job, cipherctx_t *ctx, const char *inPath, const char *outPath)
+{
+    int len;
+
+    if (openSealed(job, ctx, inPath))
+        return FILE_ERR;
+
+    if (outPath && outPath[0] && outPath[strlen(outPath) - 1] != '/')
+    {
+        len = snprintf(job->outPath, sizeof(job->outPath), "%s", outPath);
+        if (len >= 0 && (size_t) len < sizeof(job->outPath))
+            createOutput(job, 0);
+    }
+    else
+        createDecryptOutput(job, outPath ? outPath : inPath);
+
+    if (job->outFd < 0)
+    {
+        closeJob(job, 0);
+        return FILE_ERR;
+    }
+
+    if (sizeOutput(job, job->length) || mapOutput(job, job->length))
+    {
+        closeJob(job, 1);
+        return IO_ERR;
+    }
+    prepareOutput(job);
+
+    return 0;
+}
+
+int streamDecryptRange(streamjob_t *job, uint64_t first, uint64_t count, uint32_t *crc)
+{
+    int bs = job->ctx->blockSize;
+    int hs = job->ctx->headerSize;
+    uint64_t off = first * bs, end = (first + count) * bs;
+    uc iv[CIPHER_BLOCK_MAX];
+    uc *buf = NULL, *io = NULL, *data;
+    dropstate_t drop;
+    uringpipe_t *pipe;
+    int status = 0;
+
+    *crc = ~0U;
+
+    if (job->ctx->cbc)
+    {
+        if (first == 0)
+            memcpy(iv, job->header.IV, bs);
+        else if (job->inMap)
+            memcpy(iv, job->inMap + hs + off - bs, bs);
+        else if (preadFull(job->inFd, iv, bs, hs + off - bs) != bs)
+            return IO_ERR;
+    }
+
+    if (engine == STREAM_ENGINE_URING && !job->holeCount && (pipe = uringThreadPipe(STREAM_BUF_LEN)))
+        return uringRange(job, pipe, 0, first, count, iv, crc);
+
+    memset(&drop, 0, sizeof(drop));
+    while (off < end)
+    {
+        size_t len = end - off < STREAM_BUF_LEN ? end - off : STREAM_BUF_LEN;
+        size_t keep;
+        int mapped, hole;
+
+        if (job->holeCount)
+        {
+            len = holeRun(job, off / bs, len / bs, &hole) * bs;
+            /// izlaz je vec produzen na konacnu velicinu, pa rupa u njemu ostaje rupa
+            if (hole)
+            {
+                keep = off >= job->length ? 0 : (job->length - off < len ? job->length - off : len);
+                *crc = crc32Zeros(*crc, keep);
+                off += len;
+                continue;
+            }
+            if (job->ctx->cbc && off && holeAt(job, off / bs - 1))
+                holeIv(job, off / bs, iv);
+        }
+        keep = off >= job->length ? 0 : (job->length - off < len ? job->length - off : len);
+        mapped = job->outMap && keep == len;
+
+        /// uz mapu izlaza se desifruje direktno u njoj, osim poslednjeg dela koji je duzi od izlaza
+        if (mapped)
+            data = job->outMap + off;
+        else
+        {
+            if (!buf && allocBuffers(job, &buf, &io))
+                return ALLOC_ERR;
+            data = buf + (job->outDirect >= 0 ? off % STREAM_ALIGN : 0);
+        }
+
+        if (job->inMap)
+        {
+            throttleAcquire(THROTTLE_READ, len);
+            memcpy(data, job->inMap + hs + off, len);
+        }
+        else if (readData(job, io, data, len, hs + off) != (ssize_t) len)
+        {
+            status = IO_ERR;
+            break;
+        }
+
+        cipherDecrypt(job->ctx, data, len, iv);
+
+        *crc = crc32Update(*crc, data, keep);
+        if (mapped)
+            throttleAcquire(THROTTLE_WRITE, keep);
+        else if (keep && job->outFd >= 0 && writeData(job, data, keep, off))
+        {
+            status = IO_ERR;
+            break;
+        }
+        dropBehind(job, &drop, hs + off, len, off, job->outFd >= 0 ? keep : 0);
+        off += len;
+    }
+    dropBehind(job, &drop, 0, 0, 0, 0);
+
+    free(buf);
+    free(io);
+    return status;
+}
+
+int streamDecryptClose(streamjob_t *job, uint32_t crc, int status)
+{
+    if (!status && crc != job->header.crc)
+        status = CRC_MISMATCH;
+    if (!status && job->outFd >= 0)
+        status = streamPublish(job->outFd, job->tmpPath[0] ? job->tmpPath : NULL, job->outPath,
+                               job->noReplace, job->length);
+
+    closeJob(job, status != 0);
+    return status;
+}
+
+int streamEncryptFile(cipherctx_t *ctx, const char *inPath, const char *outPath, uint64_t *length)
+{
+    streamjob_t job;
+    uc iv[CIPHER_BLOCK_MAX];
+    uint32_t crc = ~0U;
+    int status;
+
+    if ((status = streamEncryptOpen(&job, ctx, inPath, outPath)))
+        return status;
+    if (length)
+        *length = job.length;
+
+    memcpy(iv, job.header.IV, ctx->blockSize);
+    status = streamEncryptRange(&job, 0, job.blocks, iv, &crc);
+
+    return streamEncryptClose(&job, crc, status);
+}
+
+int streamDecryptFile(cipherctx_t *ctx, const char *inPath, const char *outPath, uint64_t *length)
+{
+    streamjob_t job;
+    uint32_t crc = ~0U;
+    int status;
+
+    if ((status = streamDecryptOpen(&job, ctx, inPath, outPath)))
+        return status;
+    if (length)
+        *length = job.length;
+
+    status = streamDecryptRange(&job, 0, job.blocks, &crc);
+
+    return streamDecryptClose(&job, crc, status);
+}
+
+int streamVerifyFile(cipherctx_t *ctx, const char *inPath, uint64_t *length)
+{
+    streamjob_t job;
+    uint32_t crc = ~0U;
+    int status;
+
+    if ((status = openSealed(&job, ctx, inPath)))
+        return status;
+    if (length)
+        *length = job.length;
+
+    status = streamDecryptRange(&job, 0, job.blocks, &crc);
+
+    return streamDecryptClose(&job, crc, status);
+}
+
+int streamReadHeader(cipherctx_t *ctx, const char *inPath, fileheader_t *header)
+{
+    streamjob_t job;
+
+    if (openSealed(&job, ctx, inPath))
+        return FILE_ERR;
+
+    *header = job.header;
+    closeJob(&job, 0);
+    return 0;
+}
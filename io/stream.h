@@ -0,0 +1,374 @@
+/**
+* @file
+* @brief Enkripcija/dekripcija fajlova preko konteksta iz cipher.h.
+* @details Format .dat fajla je isti kao kod funkcija iz aes_file_handler.h i des.h: heder
+* sifrovan u ECB modu, a zatim podaci dopunjeni nulama do velicine bloka. Heder se upisuje
+* na kraju, kada su poznati duzina i CRC, tako da se ulaz cita samo jednom.
+*
+* Fajl se obradjuje u delovima (opsezima blokova) preko pread/pwrite, pa nezavisni opsezi
+* mogu da se obradjuju iz vise niti: Open, zatim Range za svaki opseg, pa Close sa CRC-om
+* dobijenim spajanjem CRC-ova opsega (crc32Combine).
+*
+* Sva citanja, pisanja i otvaranja fajlova prolaze kroz ogranicenja iz throttle.h.
+*
+* Podaci se podrazumevano prenose preko pread/pwrite i bafera. Uz STREAM_ENGINE_MMAP ulaz i izlaz
+* se mapiraju u memoriju: bajtovi se kopiraju jednom, iz mape ulaza direktno u mapu izlaza, gde se
+* i sifruju, umesto dva kopiranja (u bafer i iz bafera). Ukoliko mapiranje ne uspe (npr. specijalni
+* fajl ili prazan fajl), posao radi preko pread/pwrite.
+*
+* Uz STREAM_ENGINE_URING se opseg obradjuje kao protocna obrada preko io_uring prstena niti: dok se
+* deo N sifruje, citanja sledecih delova i pisanja prethodnih su vec predata jezgru (do URING_DEPTH
+* delova istovremeno, u registrovanim poravnatim baferima). Ukoliko io_uring nije dostupan, koristi
+* se pread/pwrite.
+*
+* Nezavisno od nacina prenosa, svaki posao ima odnos prema kesu stranica (streamSetCacheMode), po
+* zadatom ili, uz STREAM_CACHE_AUTO, po velicini fajla. Uz STREAM_CACHE_DONTNEED se iza kursora
+* pokrece upis na disk (sync_file_range), a deo pre toga se izbacuje iz kesa (posix_fadvise
+* DONTNEED) i za ulaz i za izlaz. STREAM_CACHE_DIRECT uz pread/pwrite zaobilazi kes (O_DIRECT):
+* citanje se prosiruje do poravnatih granica i kopira u bafer, a kod pisanja se preko O_DIRECT
+* upisuje samo poravnati srednji deo, dok neporavnati pocetak i kraj (heder od npr. 288 bajtova
+* pomera sve podatke) idu preko obicnog deskriptora. Ukoliko O_DIRECT nije podrzan (npr. tmpfs) ili
+* je izabran drugi nacin prenosa, ponasa se kao STREAM_CACHE_DONTNEED.
+*
+* Izlaz se pise u fajl bez imena (O_TMPFILE u direktorijumu izlaza) ili, gde to nije podrzano, u
+* izlaz sa dodatim STREAM_TMP_SUFFIX, a pod svojim imenom se pojavljuje tek u Close, ceo (linkat,
+* odnosno rename). Prekinuta obrada zato nikad ne ostavlja delimican izlaz pod konacnim imenom, a
+* postojeci fajl sa tim imenom ostaje netaknut do kraja. Prostor za izlaz se odmah rezervise
+* (fallocate), jer je velicina unapred poznata: nedostatak mesta se prijavljuje pre obrade, a izlaz
+* nije fragmentisan.
+*
+* Uz streamSetSparse se pri enkripciji ulaz sa rupama (npr. slika diska virtuelne masine) obilazi
+* preko SEEK_HOLE/SEEK_DATA. Blokovi koji su ceo u rupi se ne citaju, ne sifruju i ne upisuju, pa su
+* i u .dat fajlu rupe, a mapa rupa (streamhole_t, sifrovana) se upisuje posle podataka i oznacava u
+* hederu (HEADER_SPARSE). Svaki blok ostaje na istom mestu kao bez rupa, pa se opsezi i dalje
+* obradjuju nezavisno. U CRC rupa ulazi kao nule, a CBC lanac se posle rupe nastavlja od IV-a
+* izvedenog iz IV-a hedera i rednog broja bloka. Dekripcija prepoznaje mapu sama: izlaz se samo
+* produzi na konacnu velicinu (bez fallocate), a rupe se preskacu, pa ostaju rupe i u izlazu. Posao
+* sa rupama ne koristi io_uring, vec pread/pwrite.
+*
+* Pre objavljivanja izlaza se primenjuje izabrana trajnost (streamSetSync): STREAM_SYNC_FILE spusta
+* na disk podatke izlaza pre, a direktorijum posle objavljivanja, tako da je svaki zavrsen izlaz
+* trajan; STREAM_SYNC_GROUP poziva syncfs jednom u STREAM_GROUP_FILES izlaza ili STREAM_GROUP_BYTES
+* bajtova (i na kraju obrade, streamSyncFlush), pa se posle nestanka struje gubi najvise poslednja
+* grupa, a broj poziva ne raste sa brojem fajlova.
+*/
+
+#ifndef _STREAM_H_
+#define _STREAM_H_
+
+#include <stdint.h>
+#include "../cipher/cipher.h"
+
+/**
+* @brief Velicina bafera za citanje/pisanje u bajtovima (umnozak svih velicina bloka).
+*/
+#define STREAM_BUF_LEN (256 * 1024)
+
+/**
+* @brief Maksimalna duzina putanje izlaznog fajla.
+*/
+#define STREAM_PATH_MAX 4096
+
+/**
+* @brief Poravnanje pozicija, duzina i bafera za O_DIRECT u bajtovima.
+*/
+#define STREAM_ALIGN 4096
+
+/**
+* @brief Najmanja velicina fajla za koju STREAM_CACHE_AUTO bira STREAM_CACHE_DONTNEED.
+*/
+#define STREAM_DONTNEED_MIN (64ULL * 1024 * 1024)
+
+/**
+* @brief Najmanja velicina fajla za koju STREAM_CACHE_AUTO bira STREAM_CACHE_DIRECT.
+*/
+#define STREAM_DIRECT_MIN (1024ULL * 1024 * 1024)
+
+/**
+* @brief Sufiks izlaza u koji se pise kada O_TMPFILE nije podrzan (i izlaza sa kontrolnom tackom).
+*/
+#define STREAM_TMP_SUFFIX ".tmp"
+
+/**
+* @brief Podrazumevani broj izlaza izmedju dva syncfs poziva uz STREAM_SYNC_GROUP.
+*/
+#define STREAM_GROUP_FILES 256
+
+/**
+* @brief Podrazumevani broj bajtova izlaza izmedju dva syncfs poziva uz STREAM_SYNC_GROUP.
+*/
+#define STREAM_GROUP_BYTES (1024ULL * 1024 * 1024)
+
+/**
+* @brief Najveci broj rupa u mapi jednog fajla; rupe posle toga se sifruju kao podaci.
+*/
+#define STREAM_HOLES_MAX 65536
+
+/**
+* @brief Odnos posla prema kesu stranica.
+*/
+typedef enum
+{
+    STREAM_CACHE_KEEP,      /**< Podaci ostaju u kesu (podrazumevano) */
+    STREAM_CACHE_DONTNEED,  /**< Obradjeni delovi se izbacuju iz kesa */
+    STREAM_CACHE_DIRECT,    /**< Ulaz i izlaz zaobilaze kes (O_DIRECT) */
+    STREAM_CACHE_AUTO       /**< Po velicini fajla: STREAM_DONTNEED_MIN, STREAM_DIRECT_MIN */
+} streamcache_t;
+
+/**
+* @brief Nacin prenosa podataka izmedju fajlova i algoritma.
+*/
+typedef enum
+{
+    STREAM_ENGINE_PREAD,    /**< pread/pwrite preko bafera (podrazumevano) */
+    STREAM_ENGINE_MMAP,     /**< Ulaz i izlaz mapirani u memoriju */
+    STREAM_ENGINE_URING     /**< Asinhrono citanje i pisanje preko io_uring (uring.h) */
+} streamengine_t;
+
+/**
+* @brief Trajnost zavrsenih izlaza.
+*/
+typedef enum
+{
+    STREAM_SYNC_NONE,       /**< Upis na disk se prepusta jezgru (podrazumevano) */
+    STREAM_SYNC_FILE,       /**< fdatasync izlaza i fsync direktorijuma za svaki izlaz */
+    STREAM_SYNC_GROUP       /**< syncfs za grupu izlaza */
+} streamsync_t;
+
+/**
+* @brief Niz celih blokova u rupi ulaza, u mapi rupa posle podataka .dat fajla.
+*/
+typedef struct
+{
+    uint64_t first;         /**< Prvi blok */
+    uint64_t count;         /**< Broj blokova */
+} streamhole_t;
+
+/**
+* @brief Stanje obrade jednog fajla.
+*/
+typedef struct
+{
+    cipherctx_t *ctx;
+    int inFd, outFd;
+    fileheader_t header;
+    uint64_t length;        /**< Broj bajtova originalnog fajla */
+    uint64_t blocks;        /**< Broj blokova podataka u .dat fajlu */
+    uc *inMap, *outMap;     /**< Mape ulaza i izlaza (STREAM_ENGINE_MMAP), NULL bez mape */
+    size_t inMapLen, outMapLen;
+    streamcache_t cache;    /**< Odnos prema kesu izabran za ovaj posao (nikad STREAM_CACHE_AUTO) */
+    int inDirect, outDirect;    /**< O_DIRECT deskriptori ulaza i izlaza, -1 bez njih */
+    char outPath[STREAM_PATH_MAX];  /**< Konacno ime izlaza */
+    char tmpPath[STREAM_PATH_MAX];  /**< Ime izlaza dok se pise, prazan string uz O_TMPFILE */
+    int noReplace;          /**< Izlaz ne zamenjuje postojeci fajl, vec dobija drugo ime */
+    streamhole_t *holes;    /**< Rupe u rastucem redosledu, NULL za fajl bez rupa */
+    size_t holeCount;
+} streamjob_t;
+
+/**
+* @brief Funkcija koja bira nacin prenosa podataka za sve poslove koji se posle toga otvore.
+* @param[in] engine Nacin prenosa.
+*/
+void streamSetEngine(streamengine_t engine);
+
+/**
+* @brief Funkcija koja bira odnos prema kesu za sve poslove koji se posle toga otvore.
+* @param[in] mode Odnos prema kesu.
+* @return 0 ili -1 ukoliko sistem ne podrzava O_DIRECT, a trazen je STREAM_CACHE_DIRECT.
+*/
+int streamSetCacheMode(streamcache_t mode);
+
+/**
+* @brief Funkcija koja ukljucuje cuvanje rupa pri enkripciji za sve poslove koji se posle toga otvore.
+* @param[in] sparse 1 za cuvanje rupa, 0 za sifrovanje rupa kao nula (podrazumevano).
+*/
+void streamSetSparse(int sparse);
+
+/**
+* @brief Funkcija koja bira trajnost izlaza.
+* @param[in] mode Trajnost.
+* @param[in] files Broj izlaza u grupi uz STREAM_SYNC_GROUP, 0 za STREAM_GROUP_FILES.
+* @param[in] bytes Broj bajtova u grupi uz STREAM_SYNC_GROUP, 0 za STREAM_GROUP_BYTES.
+*/
+void streamSetSync(streamsync_t mode, long files, uint64_t bytes);
+
+/**
+* @brief Funkcija koja vraca izabranu trajnost izlaza.
+* @return Trajnost.
+*/
+streamsync_t streamGetSync(void);
+
+/**
+* @brief Funkcija koja uz STREAM_SYNC_GROUP spusta na disk izlaze zapocete grupe.
+*/
+void streamSyncFlush(void);
+
+/**
+* @brief Funkcija koja vraca redni broj grupe koja se puni (STREAM_SYNC_GROUP). Izlaz objavljen pre
+* poziva je u toj ili nekoj ranijoj grupi.
+* @return Redni broj grupe.
+*/
+uint64_t streamSyncGroup(void);
+
+/**
+* @brief Funkcija koja vraca broj grupa spustenih na disk: izlazi svih grupa sa manjim rednim brojem
+* su na disku.
+* @return Broj grupa.
+*/
+uint64_t streamSyncedGroups(void);
+
+/**
+* @brief Funkcija koja daje izlazu konacno ime i primenjuje izabranu trajnost.
+* @param[in] fd Deskriptor izlaza: obavezan uz tmpPath NULL (O_TMPFILE), inace -1 ukoliko su podaci
+* vec spusteni na disk ili se ne spustaju.
+* @param[in] tmpPath Ime pod kojim je izlaz upisan ili NULL za fajl bez imena.
+* @param[in,out] outPath Konacno ime (STREAM_PATH_MAX bajtova); uz noReplace mu se, ukoliko je zauzeto,
+* na pocetak dodaje slucajan broj.
+* @param[in] noReplace 1 ukoliko izlaz ne sme da zameni postojeci fajl.
+* @param[in] bytes Velicina izlaza (za grupu uz STREAM_SYNC_GROUP).
+* @return 0 ili IO_ERR.
+*/
+int streamPublish(int fd, const char *tmpPath, char *outPath, int noReplace, uint64_t bytes);
+
+/**
+* @brief Funkcija koja preimenuje fajl samo ukoliko odrediste ne postoji.
+* @return 0 ili -1 (errno EEXIST ukoliko odrediste postoji).
+*/
+int streamRenameNoReplace(const char *from, const char *to);
+
+/**
+* @brief Funkcija koja spusta na disk direktorijum u kom je fajl (posle pravljenja ili preimenovanja).
+* @param[in] path Putanja fajla.
+*/
+void streamSyncDir(const char *path);
+
+/**
+* @brief Funkcija koja otvara ulaz i pravi izlaz za enkripciju.
+* @param[out] job Stanje obrade.
+* @param[in] ctx Kontekst algoritma.
+* @param[in] inPath Putanja do fajla.
+* @param[in] outPath Putanja izlaza, NULL za inPath sa dodatom .dat ekstenzijom.
+* @return 0 ili FILE_ERR.
+*/
+int streamEncryptOpen(streamjob_t *job, cipherctx_t *ctx, const char *inPath, const char *outPath);
+
+/**
+* @brief Funkcija kao streamEncryptOpen, ali se izlaz uvek pise pod imenom sa STREAM_TMP_SUFFIX, pa
+* posle prekida moze ponovo da se otvori preko streamEncryptReopen.
+* @param[out] job Stanje obrade.
+* @param[in] ctx Kontekst algoritma.
+* @param[in] inPath Putanja do fajla.
+* @param[in] outPath Putanja izlaza, NULL za inPath sa dodatom .dat ekstenzijom.
+* @return 0 ili FILE_ERR.
+*/
+int streamEncryptOpenNamed(streamjob_t *job, cipherctx_t *ctx, const char *inPath, const char *outPath);
+
+/**
+* @brief Funkcija koja ponovo otvara delimicno upisan izlaz enkripcije (ime sa STREAM_TMP_SUFFIX iz
+* streamEncryptOpenNamed), bez brisanja sadrzaja.
+* @param[out] job Stanje obrade.
+* @param[in] ctx Kontekst algoritma.
+* @param[in] inPath Putanja do fajla.
+* @param[in] outPath Putanja izlaza, NULL za inPath sa dodatom .dat ekstenzijom.
+* @param[in] iv IV iz hedera koji se upisuje na kraju (isti kao pri prvom otvaranju).
+* @return 0 ili FILE_ERR ukoliko izlaz ne postoji ili mu velicina ne odgovara ulazu.
+*/
+int streamEncryptReopen(streamjob_t *job, cipherctx_t *ctx, const char *inPath, const char *outPath, const uc *iv);
+
+/**
+* @brief Funkcija koja enkriptuje opseg blokova.
+* @param[in] job Stanje obrade.
+* @param[in] first Prvi blok opsega.
+* @param[in] count Broj blokova.
+* @param[in,out] iv Vektor ulancavanja za CBC (za ceo fajl od bloka 0), za ECB NULL.
+* @param[out] crc CRC registar originalnih bajtova opsega (racunat od ~0).
+* @return 0, ALLOC_ERR ili IO_ERR.
+*/
+int streamEncryptRange(streamjob_t *job, uint64_t first, uint64_t count, uc *iv, uint32_t *crc);
+
+/**
+* @brief Funkcija koja upisuje heder, objavljuje izlaz (streamPublish) i zatvara fajlove.
+* @param[in] job Stanje obrade.
+* @param[in] crc CRC registar celog originalnog fajla.
+* @param[in] status Rezultat obrade opsega; ukoliko nije 0 izlaz se brise.
+* @return 0 ili kod greske.
+*/
+int streamEncryptClose(streamjob_t *job, uint32_t crc, int status);
+
+/**
+* @brief Funkcija koja zatvara fajlove prekinute obrade bez objavljivanja izlaza: izlaz pod imenom sa
+* STREAM_TMP_SUFFIX ostaje, da bi se kasnije nastavio (streamEncryptReopen).
+* @param[in] job Stanje obrade otvorene sa streamEncryptOpenNamed ili streamEncryptReopen.
+*/
+void streamEncryptSuspend(streamjob_t *job);
+
+/**
+* @brief Funkcija koja otvara .dat fajl, cita heder i pravi izlaz za dekripciju.
+* @param[out] job Stanje obrade.
+* @param[in] ctx Kontekst algoritma.
+* @param[in] inPath Putanja do .dat fajla.
+* @param[in] outPath Putanja izlaza, NULL za originalno ime u istom direktorijumu (sa slucajnim
+* brojem na pocetku imena ukoliko taj fajl vec postoji). Ukoliko se zavrsava sa '/', izlaz dobija
+* originalno ime u tom direktorijumu.
+* @return 0 ili FILE_ERR.
+*/
+int streamDecryptOpen(streamjob_t *job, cipherctx_t *ctx, const char *inPath, const char *outPath);
+
+/**
+* @brief Funkcija koja dekriptuje opseg blokova. Za CBC vektor ulancavanja se cita iz fajla.
+* @param[in] job Stanje obrade.
+* @param[in] first Prvi blok opsega.
+* @param[in] count Broj blokova.
+* @param[out] crc CRC registar dekriptovanih bajtova opsega (racunat od ~0).
+* @return 0, ALLOC_ERR ili IO_ERR.
+*/
+int streamDecryptRange(streamjob_t *job, uint64_t first, uint64_t count, uint32_t *crc);
+
+/**
+* @brief Funkcija koja proverava CRC, objavljuje izlaz (streamPublish) i zatvara fajlove.
+* @param[in] job Stanje obrade.
+* @param[in] crc CRC registar celog dekriptovanog fajla.
+* @param[in] status Rezultat obrade opsega; ukoliko nije 0 izlaz se brise.
+* @return 0, CRC_MISMATCH ili kod greske.
+*/
+int streamDecryptClose(streamjob_t *job, uint32_t crc, int status);
+
+/**
+* @brief Funkcija za enkripciju celog fajla.
+* @param[in] ctx Kontekst algoritma.
+* @param[in] inPath Putanja do fajla.
+* @param[in] outPath Putanja izlaza, NULL za podrazumevanu.
+* @param[out] length Broj bajtova originalnog fajla, moze biti NULL.
+* @return 0 ili kod greske iz global.h.
+*/
+int streamEncryptFile(cipherctx_t *ctx, const char *inPath, const char *outPath, uint64_t *length);
+
+/**
+* @brief Funkcija za dekripciju celog fajla.
+* @param[in] ctx Kontekst algoritma.
+* @param[in] inPath Putanja do .dat fajla.
+* @param[in] outPath Putanja izlaza, NULL za podrazumevanu.
+* @param[out] length Broj bajtova originalnog fajla, moze biti NULL.
+* @return 0 ili kod greske iz global.h.
+*/
+int streamDecryptFile(cipherctx_t *ctx, const char *inPath, const char *outPath, uint64_t *length);
+
+/**
+* @brief Funkcija koja dekriptuje .dat fajl bez pravljenja izlaza i proverava CRC.
+* @param[in] ctx Kontekst algoritma.
+* @param[in] inPath Putanja do .dat fajla.
+* @param[out] length Broj bajtova originalnog fajla, moze biti NULL.
+* @return 0, CRC_MISMATCH ili kod greske iz global.h.
+*/
+int streamVerifyFile(cipherctx_t *ctx, const char *inPath, uint64_t *length);
+
+/**
+* @brief Funkcija koja cita i desifruje samo heder .dat fajla.
+* @param[in] ctx Kontekst algoritma.
+* @param[in] inPath Putanja do .dat fajla.
+* @param[out] header Desifrovani heder.
+* @return 0 ili FILE_ERR.
+*/
+int streamReadHeader(cipherctx_t *ctx, const char *inPath, fileheader_t *header);
+
+#endif // _STREAM_H_
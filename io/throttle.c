@@ -0,0 +1,165 @@
+/**
+* @file
+* @brief Ogranicavanje brzine citanja, pisanja i broja fajlova u sekundi.
+* @details Kofa moze da ode u minus: nit uzima tokene odmah i spava onoliko koliko je potrebno da se
+* dug nadoknadi, tako da se pod zakljucavanjem samo racuna, a ceka van njega.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "throttle.h"
+
+/**
+* @brief Broj bajtova u jednom megabajtu (za kontrolni fajl).
+*/
+#define THROTTLE_MB (1024.0 * 1024.0)
+
+/**
+* @brief Maksimalna duzina putanje kontrolnog fajla.
+*/
+#define THROTTLE_PATH_MAX 4096
+
+/**
+* @brief Stanje jednog ogranicenja.
+* @private
+*/
+typedef struct
+{
+    double rate;        /**< Jedinica u sekundi, 0 bez ogranicenja */
+    double tokens;
+    double last;        /**< Vreme poslednjeg dopunjavanja */
+} bucket_t;
+
+static bucket_t buckets[THROTTLE_KINDS];
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_int enabled;
+
+static char controlPath[THROTTLE_PATH_MAX];
+static struct timespec controlMtime;
+static double nextPoll;
+
+/**
+* @brief Funkcija koja vraca trenutno vreme u sekundama.
+* @private
+*/
+static double nowSec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+* @brief Funkcija koja postavlja ogranicenje; poziva se dok je lock zakljucan.
+* @private
+*/
+static void setLimitLocked(throttlekind_t kind, double rate)
+{
+    bucket_t *b = &buckets[kind];
+    int i, any = controlPath[0] != '\0';
+
+    if (rate < 0)
+        rate = 0;
+    if (rate && !b->rate)
+    {
+        b->tokens = rate * THROTTLE_BURST_SEC;
+        b->last = nowSec();
+    }
+    b->rate = rate;
+
+    for (i = 0; i < THROTTLE_KINDS; i++)
+        any |= buckets[i].rate > 0;
+    atomic_store(&enabled, any);
+}
+
+/**
+* @brief Funkcija koja ponovo ucitava kontrolni fajl ukoliko mu se promenilo vreme izmene;
+* poziva se dok je lock zakljucan.
+* @private
+*/
+static void pollControlLocked(void)
+{
+    struct stat st;
+    char name[16];
+    double value;
+    FILE *f;
+
+    if (stat(controlPath, &st) || (st.st_mtim.tv_sec == controlMtime.tv_sec &&
+                                   st.st_mtim.tv_nsec == controlMtime.tv_nsec))
+        return;
+    if (!(f = fopen(controlPath, "r")))
+        return;
+    controlMtime = st.st_mtim;
+
+    while (fscanf(f, "%15s %lf", name, &value) == 2)
+    {
+        if (!strcmp(name, "read"))
+            setLimitLocked(THROTTLE_READ, value * THROTTLE_MB);
+        else if (!strcmp(name, "write"))
+            setLimitLocked(THROTTLE_WRITE, value * THROTTLE_MB);
+        else if (!strcmp(name, "files"))
+            setLimitLocked(THROTTLE_FILES, value);
+    }
+    fclose(f);
+}
+
+void throttleSetLimit(throttlekind_t kind, double rate)
+{
+    pthread_mutex_lock(&lock);
+    setLimitLocked(kind, rate);
+    pthread_mutex_unlock(&lock);
+}
+
+void throttleSetControlFile(const char *path)
+{
+    pthread_mutex_lock(&lock);
+    snprintf(controlPath, sizeof(controlPath), "%s", path);
+    memset(&controlMtime, 0, sizeof(controlMtime));
+    nextPoll = nowSec() + THROTTLE_POLL_MS / 1000.0;
+    pollControlLocked();
+    atomic_store(&enabled, 1);
+    pthread_mutex_unlock(&lock);
+}
+
+void throttleAcquire(throttlekind_t kind, uint64_t amount)
+{
+    bucket_t *b = &buckets[kind];
+    struct timespec ts;
+    double now, wait = 0;
+
+    if (!atomic_load_explicit(&enabled, memory_order_relaxed))
+        return;
+
+    pthread_mutex_lock(&lock);
+    now = nowSec();
+    if (controlPath[0] && now >= nextPoll)
+    {
+        nextPoll = now + THROTTLE_POLL_MS / 1000.0;
+        pollControlLocked();
+    }
+
+    if (b->rate > 0)
+    {
+        b->tokens += (now - b->last) * b->rate;
+        if (b->tokens > b->rate * THROTTLE_BURST_SEC)
+            b->tokens = b->rate * THROTTLE_BURST_SEC;
+        b->last = now;
+        b->tokens -= amount;
+        if (b->tokens < 0)
+            wait = -b->tokens / b->rate;
+    }
+    pthread_mutex_unlock(&lock);
+
+    if (wait > 0)
+    {
+        ts.tv_sec = (time_t) wait;
+        ts.tv_nsec = (long) ((wait - ts.tv_sec) * 1e9);
+        while (nanosleep(&ts, &ts))
+            ;
+    }
+}
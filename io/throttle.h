@@ -0,0 +1,61 @@
+/**
+* @file
+* @brief Ogranicavanje brzine citanja, pisanja i broja fajlova u sekundi za sve obrade preko stream.h.
+* @details Svako ogranicenje je "token bucket" zajednicki za sve niti procesa: poziv throttleAcquire
+* uzima zadati broj tokena, a ukoliko ih nema dovoljno nit spava dok se ne nadoknade. Dozvoljen je
+* nalet od THROTTLE_BURST_SEC sekundi punom brzinom. Bez zadatih ogranicenja throttleAcquire odmah
+* vraca kontrolu.
+*
+* Ogranicenja mogu da se menjaju tokom rada preko kontrolnog fajla, koji se proverava najvise jednom
+* u THROTTLE_POLL_MS i ponovo ucitava kada mu se promeni vreme izmene. Fajl ima po jednu vrednost u
+* liniji: "read MB", "write MB" (megabajta u sekundi) ili "files N" (fajlova u sekundi); 0 znaci bez
+* ogranicenja, a vrednosti koje nisu navedene se ne menjaju.
+*/
+
+#ifndef _THROTTLE_H_
+#define _THROTTLE_H_
+
+#include <stdint.h>
+
+/**
+* @brief Najduzi nalet punom brzinom u sekundama (velicina kofe).
+*/
+#define THROTTLE_BURST_SEC 1.0
+
+/**
+* @brief Najkrace vreme (u milisekundama) izmedju dve provere kontrolnog fajla.
+*/
+#define THROTTLE_POLL_MS 1000
+
+/**
+* @brief Vrsta ogranicenja.
+*/
+typedef enum
+{
+    THROTTLE_READ,      /**< Bajtova procitanih u sekundi */
+    THROTTLE_WRITE,     /**< Bajtova upisanih u sekundi */
+    THROTTLE_FILES,     /**< Otvorenih fajlova u sekundi */
+    THROTTLE_KINDS
+} throttlekind_t;
+
+/**
+* @brief Funkcija koja postavlja ogranicenje.
+* @param[in] kind Vrsta ogranicenja.
+* @param[in] rate Broj jedinica u sekundi, 0 za bez ogranicenja.
+*/
+void throttleSetLimit(throttlekind_t kind, double rate);
+
+/**
+* @brief Funkcija koja zadaje kontrolni fajl i odmah ga ucitava (ukoliko postoji).
+* @param[in] path Putanja kontrolnog fajla.
+*/
+void throttleSetControlFile(const char *path);
+
+/**
+* @brief Funkcija koja uzima tokene i po potrebi ceka. Moze se pozivati iz vise niti.
+* @param[in] kind Vrsta ogranicenja.
+* @param[in] amount Broj jedinica (bajtova ili fajlova).
+*/
+void throttleAcquire(throttlekind_t kind, uint64_t amount);
+
+#endif // _THROTTLE_H_
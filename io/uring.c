@@ -0,0 +1,313 @@
+/**
+* @file
+* @brief Minimalan omotac za io_uring preko sistemskih poziva.
+* @details Glava i rep redova se dele sa jezgrom, pa se citaju sa acquire, a upisuju sa release
+* semantikom.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "uring.h"
+
+#if URING_SUPPORTED
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+static pthread_once_t pipeOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t pipeKey;
+static atomic_int unavailable;
+
+/**
+* @brief Funkcija koja oslobadja prsten niti sa baferima.
+* @private
+*/
+static void freePipe(void *arg)
+{
+    uringpipe_t *pipe = (uringpipe_t*)arg;
+    int i;
+
+    uringFree(&pipe->ring);
+    for (i = 0; i < URING_DEPTH; i++)
+        free(pipe->bufs[i]);
+    free(pipe);
+}
+
+/**
+* @brief Funkcija koja pravi kljuc za prstene niti.
+* @private
+*/
+static void makePipeKey(void)
+{
+    pthread_key_create(&pipeKey, freePipe);
+}
+
+int uringInit(uring_t *ring, unsigned entries)
+{
+    struct io_uring_params p;
+    unsigned char *sq, *cq;
+
+    memset(ring, 0, sizeof(*ring));
+    memset(&p, 0, sizeof(p));
+
+    ring->fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (ring->fd < 0)
+        return -1;
+
+    ring->sqMapLen = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cqMapLen = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (ring->cqMapLen > ring->sqMapLen)
+            ring->sqMapLen = ring->cqMapLen;
+        ring->cqMapLen = ring->sqMapLen;
+    }
+
+    ring->sqMap = mmap(NULL, ring->sqMapLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sqMap == MAP_FAILED)
+    {
+        ring->sqMap = NULL;
+        uringFree(ring);
+        return -1;
+    }
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        ring->cqMap = ring->sqMap;
+    else
+    {
+        ring->cqMap = mmap(NULL, ring->cqMapLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cqMap == MAP_FAILED)
+        {
+            ring->cqMap = NULL;
+            uringFree(ring);
+            return -1;
+        }
+    }
+
+    ring->sqesLen = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqesLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED)
+    {
+        ring->sqes = NULL;
+        uringFree(ring);
+        return -1;
+    }
+
+    sq = (unsigned char*) ring->sqMap;
+    cq = (unsigned char*) ring->cqMap;
+    ring->sqHead = (unsigned*) (sq + p.sq_off.head);
+    ring->sqTail = (unsigned*) (sq + p.sq_off.tail);
+    ring->sqMask = (unsigned*) (sq + p.sq_off.ring_mask);
+    ring->sqArray = (unsigned*) (sq + p.sq_off.array);
+    ring->cqHead = (unsigned*) (cq + p.cq_off.head);
+    ring->cqTail = (unsigned*) (cq + p.cq_off.tail);
+    ring->cqMask = (unsigned*) (cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*) (cq + p.cq_off.cqes);
+    ring->sqEntries = p.sq_entries;
+    return 0;
+}
+
+void uringFree(uring_t *ring)
+{
+    if (ring->sqes)
+        munmap(ring->sqes, ring->sqesLen);
+    if (ring->cqMap && ring->cqMap != ring->sqMap)
+        munmap(ring->cqMap, ring->cqMapLen);
+    if (ring->sqMap)
+        munmap(ring->sqMap, ring->sqMapLen);
+    if (ring->fd >= 0)
+        close(ring->fd);
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+int uringRegisterBuffers(uring_t *ring, const struct iovec *iov, unsigned count)
+{
+    return syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, iov, count) < 0 ? -1 : 0;
+}
+
+int uringRegisterFiles(uring_t *ring, unsigned count)
+{
+    int fds[URING_FILES];
+    unsigned i;
+
+    if (count > URING_FILES)
+        return -1;
+    /// -1 oznacava prazno mesto koje popunjava openat sa file_index
+    for (i = 0; i < count; i++)
+        fds[i] = -1;
+    return syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_FILES, fds, count) < 0 ? -1 : 0;
+}
+
+struct io_uring_sqe* uringGetSqe(uring_t *ring)
+{
+    unsigned head = __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE);
+    unsigned tail = *ring->sqTail + ring->pending;
+    struct io_uring_sqe *sqe;
+
+    if (tail - head >= ring->sqEntries)
+        return NULL;
+
+    sqe = &ring->sqes[tail & *ring->sqMask];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sqArray[tail & *ring->sqMask] = tail & *ring->sqMask;
+    ring->pending++;
+    return sqe;
+}
+
+int uringSubmit(uring_t *ring, unsigned waitNr)
+{
+    unsigned toSubmit = ring->pending;
+    long n;
+
+    /// objavljivanje zahteva jezgru
+    __atomic_store_n(ring->sqTail, *ring->sqTail + toSubmit, __ATOMIC_RELEASE);
+    ring->pending = 0;
+
+    do
+        n = syscall(__NR_io_uring_enter, ring->fd, toSubmit, waitNr, waitNr ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    while (n < 0 && (errno == EINTR || errno == EAGAIN));
+
+    return n < 0 ? -errno : (int)n;
+}
+
+struct io_uring_cqe* uringPeek(uring_t *ring)
+{
+    unsigned head = *ring->cqHead;
+
+    if (head == __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE))
+        return NULL;
+    return &ring->cqes[head & *ring->cqMask];
+}
+
+void uringSeen(uring_t *ring)
+{
+    __atomic_store_n(ring->cqHead, *ring->cqHead + 1, __ATOMIC_RELEASE);
+}
+
+uringpipe_t* uringThreadPipe(size_t bufLen)
+{
+    uringpipe_t *pipe;
+    int i;
+
+    pthread_once(&pipeOnce, makePipeKey);
+    if ((pipe = (uringpipe_t*) pthread_getspecific(pipeKey)))
+        return pipe;
+    if (atomic_load(&unavailable))
+        return NULL;
+
+    if (!(pipe = (uringpipe_t*) calloc(1, sizeof(uringpipe_t))))
+        return NULL;
+
+    /// jezgro bez io_uring-a (ili sa zabranjenim) se ne proverava ponovo za svaki fajl
+    if (uringInit(&pipe->ring, URING_ENTRIES))
+    {
+        atomic_store(&unavailable, 1);
+        free(pipe);
+        return NULL;
+    }
+
+    pipe->bufLen = bufLen;
+    for (i = 0; i < URING_DEPTH; i++)
+    {
+        if (posix_memalign((void**) &pipe->bufs[i], URING_ALIGN, bufLen))
+        {
+            freePipe(pipe);
+            return NULL;
+        }
+        pipe->iov[i].iov_base = pipe->bufs[i];
+        pipe->iov[i].iov_len = bufLen;
+    }
+
+    /// registracija moze da ne uspe zbog RLIMIT_MEMLOCK; tada se koriste obicni zahtevi
+    pipe->fixed = !uringRegisterBuffers(&pipe->ring, pipe->iov, URING_DEPTH);
+
+    pthread_setspecific(pipeKey, pipe);
+    return pipe;
+}
+
+int uringPipeFiles(uringpipe_t *pipe)
+{
+    if (!pipe->files)
+        pipe->files = uringRegisterFiles(&pipe->ring, URING_FILES) ? -1 : 1;
+    return pipe->files > 0;
+}
+
+void uringThreadPipeReset(void)
+{
+    uringpipe_t *pipe;
+
+    pthread_once(&pipeOnce, makePipeKey);
+    if (!(pipe = (uringpipe_t*) pthread_getspecific(pipeKey)))
+        return;
+
+    /// baferi se ne oslobadjaju, jer jezgro mozda jos pise u njih
+    uringFree(&pipe->ring);
+    free(pipe);
+    pthread_setspecific(pipeKey, NULL);
+}
+
+#else
+
+int uringInit(uring_t *ring, unsigned entries)
+{
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+    return -1;
+}
+
+void uringFree(uring_t *ring)
+{
+}
+
+int uringRegisterBuffers(uring_t *ring, const struct iovec *iov, unsigned count)
+{
+    return -1;
+}
+
+int uringRegisterFiles(uring_t *ring, unsigned count)
+{
+    return -1;
+}
+
+struct io_uring_sqe* uringGetSqe(uring_t *ring)
+{
+    return NULL;
+}
+
+int uringSubmit(uring_t *ring, unsigned waitNr)
+{
+    return -ENOSYS;
+}
+
+struct io_uring_cqe* uringPeek(uring_t *ring)
+{
+    return NULL;
+}
+
+void uringSeen(uring_t *ring)
+{
+}
+
+uringpipe_t* uringThreadPipe(size_t bufLen)
+{
+    return NULL;
+}
+
+int uringPipeFiles(uringpipe_t *pipe)
+{
+    return 0;
+}
+
+void uringThreadPipeReset(void)
+{
+}
+
+#endif
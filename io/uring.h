@@ -0,0 +1,159 @@
+/**
+* @file
+* @brief Minimalan omotac za io_uring preko sistemskih poziva (bez liburing).
+* @details Prsten se pravi sa io_uring_setup, a redovi zahteva (SQ) i zavrsetaka (CQ) se mapiraju u
+* memoriju. Zahtevi se pripremaju u SQ, objavljuju pomeranjem repa reda i predaju jezgru jednim
+* io_uring_enter pozivom, koji moze i da saceka zavrsetke. Prsten ne sme da se koristi iz vise niti
+* istovremeno, pa svaka nit ima svoj (uringThreadPipe), sa registrovanim baferima.
+*
+* Na sistemima bez io_uring-a (ili kada je zabranjen) uringInit vraca gresku, a pozivaoci koriste
+* sinhrone pozive.
+*/
+
+#ifndef _URING_H_
+#define _URING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#define URING_SUPPORTED 1
+#else
+#define URING_SUPPORTED 0
+struct io_uring_sqe;
+struct io_uring_cqe;
+#endif
+
+/**
+* @brief Broj bafera (i najveci broj istovremenih citanja/pisanja) po niti.
+*/
+#define URING_DEPTH 8
+
+/**
+* @brief Poravnanje bafera u bajtovima.
+*/
+#define URING_ALIGN 4096
+
+/**
+* @brief Broj mesta u SQ prstena niti (CQ ima dvostruko vise).
+*/
+#define URING_ENTRIES 128
+
+/**
+* @brief Broj mesta u tabeli direktnih deskriptora prstena niti.
+*/
+#define URING_FILES 64
+
+/**
+* @brief Prsten sa mapiranim redovima.
+*/
+typedef struct
+{
+    int fd;
+    unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+    unsigned *cqHead, *cqTail, *cqMask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    unsigned sqEntries;
+    unsigned pending;           /**< Pripremljeni zahtevi koji jos nisu predati */
+    void *sqMap, *cqMap;
+    size_t sqMapLen, cqMapLen, sqesLen;
+} uring_t;
+
+/**
+* @brief Prsten niti sa baferima.
+*/
+typedef struct
+{
+    uring_t ring;
+    unsigned char *bufs[URING_DEPTH];
+    struct iovec iov[URING_DEPTH];  /**< Opisi bafera, za zahteve bez registrovanih bafera */
+    size_t bufLen;
+    int fixed;                      /**< 1 ukoliko su baferi registrovani (READ_FIXED/WRITE_FIXED) */
+    int files;                      /**< 1 ukoliko je registrovana tabela direktnih deskriptora, -1 ukoliko
+                                         nije podrzana, 0 ukoliko jos nije pokusano (uringPipeFiles) */
+} uringpipe_t;
+
+/**
+* @brief Funkcija koja pravi prsten.
+* @param[out] ring Prsten.
+* @param[in] entries Najveci broj zahteva u SQ.
+* @return 0 ili -1 ukoliko io_uring nije dostupan.
+*/
+int uringInit(uring_t *ring, unsigned entries);
+
+/**
+* @brief Funkcija koja zatvara prsten. Zahtevi koji su jos u obradi se otkazuju.
+* @param[in] ring Prsten.
+*/
+void uringFree(uring_t *ring);
+
+/**
+* @brief Funkcija koja registruje bafere za READ_FIXED/WRITE_FIXED zahteve.
+* @param[in] ring Prsten.
+* @param[in] iov Opisi bafera.
+* @param[in] count Broj bafera.
+* @return 0 ili -1.
+*/
+int uringRegisterBuffers(uring_t *ring, const struct iovec *iov, unsigned count);
+
+/**
+* @brief Funkcija koja registruje praznu tabelu direktnih deskriptora (za openat sa file_index).
+* @param[in] ring Prsten.
+* @param[in] count Broj mesta u tabeli.
+* @return 0 ili -1.
+*/
+int uringRegisterFiles(uring_t *ring, unsigned count);
+
+/**
+* @brief Funkcija koja vraca sledece slobodno mesto u SQ, popunjeno nulama.
+* @param[in] ring Prsten.
+* @return Zahtev koji treba popuniti ili NULL ukoliko je SQ pun.
+*/
+struct io_uring_sqe* uringGetSqe(uring_t *ring);
+
+/**
+* @brief Funkcija koja predaje pripremljene zahteve i ceka zadati broj zavrsetaka.
+* @param[in] ring Prsten.
+* @param[in] waitNr Broj zavrsetaka koje treba sacekati (0 bez cekanja).
+* @return Broj predatih zahteva ili -errno.
+*/
+int uringSubmit(uring_t *ring, unsigned waitNr);
+
+/**
+* @brief Funkcija koja vraca sledeci zavrsetak iz CQ, bez cekanja.
+* @param[in] ring Prsten.
+* @return Zavrsetak ili NULL ukoliko ih nema.
+*/
+struct io_uring_cqe* uringPeek(uring_t *ring);
+
+/**
+* @brief Funkcija koja oslobadja zavrsetak vracen iz uringPeek.
+* @param[in] ring Prsten.
+*/
+void uringSeen(uring_t *ring);
+
+/**
+* @brief Funkcija koja vraca prsten pozivajuce niti i pravi ga pri prvom pozivu, sa URING_DEPTH
+* poravnatih bafera zadate duzine. Prsten se oslobadja kada se nit zavrsi.
+* @param[in] bufLen Duzina svakog bafera.
+* @return Prsten niti ili NULL ukoliko io_uring nije dostupan.
+*/
+uringpipe_t* uringThreadPipe(size_t bufLen);
+
+/**
+* @brief Funkcija koja pri prvom pozivu registruje tabelu od URING_FILES direktnih deskriptora za prsten niti.
+* @param[in] pipe Prsten niti.
+* @return 1 ukoliko tabela postoji, 0 ukoliko nije podrzana.
+*/
+int uringPipeFiles(uringpipe_t *pipe);
+
+/**
+* @brief Funkcija koja odbacuje prsten pozivajuce niti posle greske iz koje ne moze da se nastavi
+* (npr. neuspesan io_uring_enter sa zahtevima u obradi). Sledeci uringThreadPipe pravi novi prsten.
+*/
+void uringThreadPipeReset(void);
+
+#endif // _URING_H_
@@ -0,0 +1,391 @@
+/**
+* @file
+* @brief Funkcije za zurnal obrade vise fajlova.
+* @details Zapisi ucitani prilikom nastavka se cuvaju u hes tabeli sa ulancavanjem (kljuc je operacija
+* i putanja ulaza). Posle otvaranja tabela se samo cita, pa provere iz vise niti ne zakljucavaju nista.
+*/
+
+#include "journal.h"
+#include "global.h"
+#include "io/checkpoint.h"
+#include "io/stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+* @brief Maksimalna duzina jednog zapisa.
+*/
+#define JOURNAL_RECORD_MAX (2 * 4096 + 16)
+
+/**
+* @brief Broj lanaca hes tabele.
+*/
+#define JOURNAL_TABLE_LEN 65536
+
+/**
+* @brief Fajl iz prekinute obrade.
+*/
+typedef struct JournalEntry {
+    struct JournalEntry *next;
+    struct JournalEntry *next_out;  /**< Sledeci u lancu tabele izlaza */
+    char op;
+    char *in;
+    char *out;
+    int done;
+} JournalEntry;
+
+/**
+* @brief Zapis D koji ceka da grupa sa izlazom fajla bude spustena na disk (STREAM_SYNC_GROUP).
+*/
+typedef struct JournalHeld {
+    struct JournalHeld *next;
+    uint64_t group;     /**< Grupa koja se punila kada je fajl zavrsen */
+    size_t len;
+    char record[];
+} JournalHeld;
+
+struct Journal {
+    int fd;
+    int resume;
+    JournalEntry **table;       /**< Zapisi po ulazu, samo prilikom nastavka */
+    JournalEntry **outputs;     /**< Zavrseni zapisi po izlazu */
+
+    JournalHeld *held;          /**< Zadrzani zapisi, u rastucem redosledu grupa */
+    JournalHeld **held_tail;
+
+    atomic_int dirty;
+    atomic_int stop;
+    pthread_t syncer;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+};
+
+/*********************** INTERNAL FUNCTIONS ***********************/
+static unsigned long hash_entry(char op, const char *path) {
+    unsigned long h = 5381 * 33 + (unsigned char)op;
+    while (*path)
+        h = h * 33 + (unsigned char)*path++;
+    return h % JOURNAL_TABLE_LEN;
+}
+
+/**
+* @brief Funkcija koja vraca zapis za ulaz i pravi ga ukoliko ne postoji.
+*/
+static JournalEntry* get_entry(Journal *journal, char op, const char *in) {
+    JournalEntry **bucket = &journal->table[hash_entry(op, in)], *e;
+
+    for (e = *bucket; e; e = e->next)
+        if (e->op == op && !strcmp(e->in, in))
+            return e;
+
+    e = (JournalEntry*) calloc(1, sizeof(JournalEntry));
+    ALLOC_CHECK(e);
+    e->op = op;
+    e->in = strdup(in);
+    ALLOC_CHECK(e->in);
+    e->next = *bucket;
+    *bucket = e;
+    return e;
+}
+
+/**
+* @brief Funkcija koja ucitava zapise, brise privremene izlaze prekinutih fajlova (osim onih sa kontrolnom tackom) i pravi spisak izlaza zavrsenih fajlova.
+*/
+static void load_journal(Journal *journal, const char *path) {
+    FILE *f = fopen(path, "r");
+    char *line, *in, *out, *end;
+    JournalEntry *e;
+    char tmp[STREAM_PATH_MAX];
+    unsigned long h;
+    int i, len;
+
+    if (!f)
+        return;
+
+    line = (char*) malloc(JOURNAL_RECORD_MAX);
+    ALLOC_CHECK(line);
+    while (fgets(line, JOURNAL_RECORD_MAX, f)) {
+        /// zapis koji nije upisan do kraja (prekid usred write-a) se preskace
+        if (!(end = strchr(line, '\n')) || end - line < 5 || line[1] != ' ' || line[3] != ' ' ||
+            (line[2] != 'e' && line[2] != 'd'))
+            continue;
+        *end = '\0';
+        in = line + 4;
+
+        if (line[0] == 'S' && (out = strchr(in, '\t'))) {
+            *out++ = '\0';
+            e = get_entry(journal, line[2], in);
+            free(e->out);
+            e->out = strdup(out);
+            ALLOC_CHECK(e->out);
+        }
+        else if (line[0] == 'D')
+            get_entry(journal, line[2], in)->done = 1;
+    }
+    free(line);
+    fclose(f);
+
+    for (i = 0; i < JOURNAL_TABLE_LEN; i++)
+        for (e = journal->table[i]; e; e = e->next) {
+            if (!e->out)
+                continue;
+            if (!e->done) {
+                /// izlaz se objavljuje tek ceo (io/stream.h), pa se brise samo privremeni; izlaz sa
+                /// kontrolnom tackom se nastavlja, a ne pravi iznova
+                if (strcmp(e->out, e->in) && !checkpointExists(e->out)) {
+                    len = snprintf(tmp, sizeof(tmp), "%s" STREAM_TMP_SUFFIX, e->out);
+                    if (len >= 0 && (size_t)len < sizeof(tmp))
+                        unlink(tmp);
+                }
+                continue;
+            }
+            h = hash_entry(e->op, e->out);
+            e->next_out = journal->outputs[h];
+            journal->outputs[h] = e;
+        }
+}
+
+/**
+* @brief Funkcija koja upisuje jedan zapis jednim write pozivom.
+*/
+static void write_record(Journal *journal, const char *record, size_t len) {
+    ssize_t n;
+
+    do
+        n = write(journal->fd, record, len);
+    while (n < 0 && errno == EINTR);
+}
+
+/**
+* @brief Funkcija koja upisuje zapis koji pomocna nit treba da spusti na disk.
+*/
+static void append_record(Journal *journal, const char *record, size_t len) {
+    write_record(journal, record, len);
+    atomic_store(&journal->dirty, 1);
+}
+
+/**
+* @brief Funkcija koja zadrzava zapis dok grupa koja se trenutno puni ne bude spustena na disk.
+*/
+static void hold_record(Journal *journal, const char *record, size_t len) {
+    JournalHeld *h = (JournalHeld*) malloc(sizeof(JournalHeld) + len);
+    ALLOC_CHECK(h);
+
+    memcpy(h->record, record, len);
+    h->len = len;
+    h->next = NULL;
+    /// redni broj grupe se cita pod bravom, pa su zapisi u rastucem redosledu grupa
+    pthread_mutex_lock(&journal->lock);
+    h->group = streamSyncGroup();
+    *journal->held_tail = h;
+    journal->held_tail = &h->next;
+    pthread_mutex_unlock(&journal->lock);
+}
+
+/**
+* @brief Funkcija koja izdvaja zadrzane zapise grupa sa rednim brojem manjim od synced. Poziva se
+* pod journal->lock.
+* @return Izdvojeni zapisi ili NULL
+*/
+static JournalHeld* take_held(Journal *journal, uint64_t synced) {
+    JournalHeld *first = journal->held, **last = &journal->held;
+
+    while (*last && (*last)->group < synced)
+        last = &(*last)->next;
+    if (last == &journal->held)
+        return NULL;
+    journal->held = *last;
+    *last = NULL;
+    if (!journal->held)
+        journal->held_tail = &journal->held;
+    return first;
+}
+
+/**
+* @brief Funkcija koja upisuje i oslobadja izdvojene zapise.
+*/
+static void write_held(Journal *journal, JournalHeld *h) {
+    JournalHeld *next;
+
+    for (; h; h = next) {
+        next = h->next;
+        write_record(journal, h->record, h->len);
+        free(h);
+    }
+}
+
+/**
+* @brief Glavna funkcija pomocne niti koja grupno poziva fdatasync.
+* @param[in] arg Pokazivac na Journal
+*/
+static void* syncer_main(void *arg) {
+    Journal *journal = (Journal*)arg;
+    struct timespec ts;
+    JournalHeld *held;
+    int dirty;
+
+    pthread_mutex_lock(&journal->lock);
+    while (!atomic_load(&journal->stop)) {
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += JOURNAL_SYNC_MS * 1000000L;
+        ts.tv_sec += ts.tv_nsec / 1000000000L;
+        ts.tv_nsec %= 1000000000L;
+        pthread_cond_timedwait(&journal->wake, &journal->lock, &ts);
+
+        held = take_held(journal, streamSyncedGroups());
+        dirty = atomic_exchange(&journal->dirty, 0);
+        if (held || dirty) {
+            pthread_mutex_unlock(&journal->lock);
+            write_held(journal, held);
+            fdatasync(journal->fd);
+            pthread_mutex_lock(&journal->lock);
+        }
+    }
+    pthread_mutex_unlock(&journal->lock);
+    return NULL;
+}
+
+/*********************** EXTERNAL FUNCTIONS ***********************/
+Journal* journal_open(const char *path, int resume) {
+    Journal *journal = (Journal*) calloc(1, sizeof(Journal));
+    ALLOC_CHECK(journal);
+
+    journal->resume = resume;
+    journal->held_tail = &journal->held;
+    if (resume) {
+        journal->table = (JournalEntry**) calloc(JOURNAL_TABLE_LEN, sizeof(JournalEntry*));
+        journal->outputs = (JournalEntry**) calloc(JOURNAL_TABLE_LEN, sizeof(JournalEntry*));
+        ALLOC_CHECK(journal->table);
+        ALLOC_CHECK(journal->outputs);
+        load_journal(journal, path);
+    }
+
+    /// zurnal je vec napravljen i proveren (journal_prepare)
+    journal->fd = open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (journal->fd < 0) {
+        journal->fd = -1;
+        journal_close(journal);
+        return NULL;
+    }
+
+    atomic_init(&journal->dirty, 0);
+    atomic_init(&journal->stop, 0);
+    pthread_mutex_init(&journal->lock, NULL);
+    pthread_cond_init(&journal->wake, NULL);
+    pthread_create(&journal->syncer, NULL, syncer_main, journal);
+    return journal;
+}
+
+void journal_default_path(char *path, size_t len, int argc, char *argv[]) {
+    unsigned long h = 5381;
+    const char *c;
+    int i;
+
+    for (i = 0; i < argc; i++)
+        for (c = argv[i]; ; c++) {
+            h = h * 33 + (unsigned char)*c;
+            if (!*c)
+                break;
+        }
+    snprintf(path, len, JOURNAL_NAME_FMT, h & 0xFFFFFFFFUL);
+}
+
+int journal_prepare(const char *path, int resume) {
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644), status = -1;
+    size_t len = strlen(JOURNAL_MAGIC);
+    char magic[sizeof(JOURNAL_MAGIC)];
+    struct stat st;
+
+    if (fd < 0)
+        return -1;
+    if (!fstat(fd, &st)) {
+        if (!st.st_size)
+            status = write(fd, JOURNAL_MAGIC, len) == (ssize_t)len ? 0 : -1;
+        else if (pread(fd, magic, len, 0) == (ssize_t)len && !memcmp(magic, JOURNAL_MAGIC, len))
+            status = resume ? 0 : ftruncate(fd, len);
+    }
+    close(fd);
+    return status;
+}
+
+int journal_is_done(Journal *journal, int encr_flag, const char *path) {
+    char op = encr_flag ? 'e' : 'd';
+    JournalEntry *e;
+    unsigned long h;
+
+    if (!journal->resume)
+        return 0;
+
+    for (e = journal->table[hash_entry(op, path)]; e; e = e->next)
+        if (e->op == op && e->done && !strcmp(e->in, path))
+            return 1;
+
+    h = hash_entry(op, path);
+    for (e = journal->outputs[h]; e; e = e->next_out)
+        if (e->op == op && !strcmp(e->out, path))
+            return 1;
+    return 0;
+}
+
+void journal_started(Journal *journal, int encr_flag, const char *in, const char *out) {
+    char record[JOURNAL_RECORD_MAX];
+    int len = snprintf(record, sizeof(record), "S %c %s\t%s\n", encr_flag ? 'e' : 'd', in, out);
+
+    if (len >= 0 && (size_t)len < sizeof(record))
+        append_record(journal, record, len);
+}
+
+void journal_finished(Journal *journal, int encr_flag, const char *in) {
+    char record[JOURNAL_RECORD_MAX];
+    int len = snprintf(record, sizeof(record), "D %c %s\n", encr_flag ? 'e' : 'd', in);
+
+    if (len < 0 || (size_t)len >= sizeof(record))
+        return;
+    /// uz STREAM_SYNC_GROUP izlaz jos nije na disku, pa zapis ceka da njegova grupa bude spustena
+    if (streamGetSync() == STREAM_SYNC_GROUP)
+        hold_record(journal, record, len);
+    else
+        append_record(journal, record, len);
+}
+
+void journal_close(Journal *journal) {
+    JournalEntry *e, *next;
+    int i;
+
+    if (journal->fd >= 0) {
+        pthread_mutex_lock(&journal->lock);
+        atomic_store(&journal->stop, 1);
+        pthread_cond_signal(&journal->wake);
+        pthread_mutex_unlock(&journal->lock);
+        pthread_join(journal->syncer, NULL);
+        pthread_mutex_destroy(&journal->lock);
+        pthread_cond_destroy(&journal->wake);
+
+        /// preostali zadrzani zapisi se upisuju tek kada je i poslednja grupa na disku
+        if (journal->held)
+            streamSyncFlush();
+        write_held(journal, take_held(journal, UINT64_MAX));
+        fdatasync(journal->fd);
+        close(journal->fd);
+    }
+
+    for (i = 0; journal->table && i < JOURNAL_TABLE_LEN; i++)
+        for (e = journal->table[i]; e; e = next) {
+            next = e->next;
+            free(e->in);
+            free(e->out);
+            free(e);
+        }
+    free(journal->table);
+    free(journal->outputs);
+    free(journal);
+}
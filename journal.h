@@ -0,0 +1,104 @@
+/**
+* @file
+* @brief Zaglavlje za zurnal obrade vise fajlova, koji omogucava nastavak prekinute obrade (--resume).
+* @details Zurnal se vodi samo na zahtev (-J ili --resume). Zurnal je tekstualni fajl koji pocinje
+* linijom JOURNAL_MAGIC, a zatim mu se samo dodaju zapisi, jedan po liniji:
+* "S op ulaz<TAB>izlaz" kada je izlaz napravljen i "D op ulaz" kada je fajl uspesno obradjen
+* (op je 'e' ili 'd'). Svaki zapis se upisuje jednim write pozivom (O_APPEND), pa radne niti ne
+* zakljucavaju nista, a pomocna nit poziva fdatasync najvise jednom u JOURNAL_SYNC_MS. Zapis D sme
+* na disk tek posle izlaza: uz STREAM_SYNC_FILE je izlaz vec na disku, a uz STREAM_SYNC_GROUP se
+* zapis zadrzava dok grupa sa izlazom ne bude spustena na disk (uz zurnal se STREAM_SYNC_NONE ne
+* koristi). Fajl bez linije JOURNAL_MAGIC nije napravio ovaj program, pa se ne koristi i ne menja.
+*/
+
+#ifndef _JOURNAL_H
+#define _JOURNAL_H
+
+#include <stddef.h>
+
+/**
+* @brief Prva linija zurnala.
+*/
+#define JOURNAL_MAGIC "#journal 1\n"
+
+/**
+* @brief Format podrazumevanog imena zurnala (hes komande), tako da svaki posao ima svoj zurnal.
+*/
+#define JOURNAL_NAME_FMT "journal-%08lx.txt"
+
+/**
+* @brief Najduze vreme (u milisekundama) izmedju upisa zapisa i njegovog fdatasync-a.
+*/
+#define JOURNAL_SYNC_MS 100
+
+/**
+* @brief Struktura zurnala.
+*/
+typedef struct Journal Journal;
+
+/**
+* @brief Funkcija koja otvara zurnal za dodavanje zapisa.
+* @details Ukoliko je resume razlicit od 0, postojeci zapisi se ucitavaju: fajlovi sa zapisom D se
+* preskacu, a privremeni izlazi (STREAM_TMP_SUFFIX) fajlova sa zapisom S bez zapisa D (obrada je
+* prekinuta usred fajla) se brisu, osim izlaza koji imaju kontrolnu tacku (io/checkpoint.h) i
+* nastavljaju se od nje. Izlaz pod konacnim imenom je uvek ceo (io/stream.h), pa se ne dira.
+* @param[in] path Putanja zurnala
+* @param[in] resume 1 za nastavak prekinute obrade, 0 u suprotnom
+* @return Pokazivac na zurnal, NULL ukoliko fajl ne moze da se otvori ili nije zurnal
+*/
+Journal* journal_open(const char *path, int resume);
+
+/**
+* @brief Funkcija koja pravi podrazumevanu putanju zurnala od argumenata komande, tako da ponovljena
+* komanda nalazi isti zurnal, a razlicite komande u istom direktorijumu razlicite.
+* @param[out] path Bafer za putanju
+* @param[in] len Velicina bafera
+* @param[in] argc Broj argumenata komande (bez opcija)
+* @param[in] argv Argumenti komande
+*/
+void journal_default_path(char *path, size_t len, int argc, char *argv[]);
+
+/**
+* @brief Funkcija koja priprema zurnal na pocetku obrade: pravi ga ukoliko ne postoji, a bez resume
+* brise njegove zapise (zurnal ostaje samo sa linijom JOURNAL_MAGIC).
+* @param[in] path Putanja zurnala
+* @param[in] resume 1 za nastavak prekinute obrade, 0 u suprotnom
+* @return 0 ili -1 ukoliko fajl ne moze da se napravi ili postoji, a nije zurnal (tada se ne menja)
+*/
+int journal_prepare(const char *path, int resume);
+
+/**
+* @brief Funkcija koja proverava da li je fajl vec obradjen u prekinutoj obradi ili je izlaz
+* vec obradjenog fajla (da se npr. ne bi pravio .dat.dat). Moze se pozivati iz vise niti.
+* @param[in] journal Pokazivac na zurnal
+* @param[in] encr_flag 1 za enkripciju, 0 za dekripciju
+* @param[in] path Putanja fajla
+* @return 1 ukoliko fajl treba preskociti, 0 u suprotnom
+*/
+int journal_is_done(Journal *journal, int encr_flag, const char *path);
+
+/**
+* @brief Funkcija koja belezi da je za fajl napravljen izlaz.
+* @param[in] journal Pokazivac na zurnal
+* @param[in] encr_flag 1 za enkripciju, 0 za dekripciju
+* @param[in] in Putanja ulaza
+* @param[in] out Putanja izlaza
+*/
+void journal_started(Journal *journal, int encr_flag, const char *in, const char *out);
+
+/**
+* @brief Funkcija koja belezi da je fajl uspesno obradjen. Poziva se posle objavljivanja izlaza.
+* @param[in] journal Pokazivac na zurnal
+* @param[in] encr_flag 1 za enkripciju, 0 za dekripciju
+* @param[in] in Putanja ulaza
+*/
+void journal_finished(Journal *journal, int encr_flag, const char *in);
+
+/**
+* @brief Funkcija koja upisuje sve zapise na disk (zadrzane posle spustanja poslednje grupe),
+* zaustavlja pomocnu nit i zatvara zurnal.
+* @param[in] journal Pokazivac na zurnal
+*/
+void journal_close(Journal *journal);
+
+#endif // _JOURNAL_H
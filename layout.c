@@ -0,0 +1,180 @@
+/**
+* @file
+* @brief Funkcije za redjanje fajlova po fizickom polozaju na disku.
+*/
+
+/// O_NOATIME
+#define _GNU_SOURCE
+#include "layout.h"
+#include "pool.h"
+#include "global.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
+#endif
+
+/**
+* @brief Vrsta kljuca za redjanje; manja vrednost ide ranije na istom uredjaju.
+*/
+typedef enum LayoutKind {
+    LAYOUT_PHYSICAL,    /**< Fizicka adresa prvog ekstenta */
+    LAYOUT_INODE,       /**< Broj inode-a (nema FIEMAP-a ili fajl nema ekstenata) */
+    LAYOUT_MISSING      /**< Fajl ne postoji */
+} LayoutKind;
+
+/**
+* @brief Kljuc za redjanje jednog fajla.
+*/
+typedef struct LayoutKey {
+    char *path;
+    long index;         /**< Mesto u zadatom nizu, za stabilno redjanje */
+    dev_t dev;
+    LayoutKind kind;
+    uint64_t value;
+} LayoutKey;
+
+/**
+* @brief Zadatak koji racuna kljuceve za deo niza.
+*/
+typedef struct LayoutTask {
+    LayoutKey *keys;
+    long len;
+} LayoutTask;
+
+/*********************** INTERNAL FUNCTIONS ***********************/
+/**
+* @brief Funkcija koja vraca fizicku adresu prvog ekstenta fajla.
+* @return 0 ili -1 ukoliko adresa nije poznata; *unsupported se postavlja ako fajl sistem nema FIEMAP.
+*/
+static int first_extent(const char *path, uint64_t *physical, int *unsupported) {
+#ifdef __linux__
+    struct {
+        struct fiemap map;
+        struct fiemap_extent extent;
+    } req;
+    int fd = -1, ok;
+
+#ifdef O_NOATIME
+    fd = open(path, O_RDONLY | O_NOATIME);
+#endif
+    if (fd < 0 && (fd = open(path, O_RDONLY)) < 0)
+        return -1;
+
+    memset(&req, 0, sizeof(req));
+    req.map.fm_length = ~0ULL;
+    req.map.fm_extent_count = 1;
+    ok = !ioctl(fd, FS_IOC_FIEMAP, &req.map);
+    close(fd);
+
+    if (!ok) {
+        *unsupported = 1;
+        return -1;
+    }
+    if (req.map.fm_mapped_extents != 1 || req.extent.fe_flags & FIEMAP_EXTENT_UNKNOWN)
+        return -1;
+    *physical = req.extent.fe_physical;
+    return 0;
+#else
+    *unsupported = 1;
+    return -1;
+#endif
+}
+
+/**
+* @brief Funkcija koju izvrsava radna nit za deo niza.
+* @details Uredjaj na kom FIEMAP nije podrzan se pamti, pa se za ostale fajlove sa njega ne otvara fajl.
+* @param[in] arg Pokazivac na LayoutTask
+*/
+static void compute_keys(void *arg) {
+    LayoutTask *task = (LayoutTask*)arg;
+    LayoutKey *key;
+    struct stat st;
+    dev_t no_fiemap = 0;
+    int have_no_fiemap = 0, unsupported;
+    long i;
+
+    for (i = 0; i < task->len; i++) {
+        key = &task->keys[i];
+        if (stat(key->path, &st) || !S_ISREG(st.st_mode)) {
+            key->kind = LAYOUT_MISSING;
+            continue;
+        }
+
+        key->dev = st.st_dev;
+        key->kind = LAYOUT_INODE;
+        key->value = st.st_ino;
+        if (have_no_fiemap && no_fiemap == st.st_dev)
+            continue;
+
+        unsupported = 0;
+        if (!first_extent(key->path, &key->value, &unsupported))
+            key->kind = LAYOUT_PHYSICAL;
+        else if (unsupported) {
+            no_fiemap = st.st_dev;
+            have_no_fiemap = 1;
+        }
+    }
+}
+
+/**
+* @brief Funkcija za poredjenje kljuceva (za qsort).
+*/
+static int sort_layout(const void *a, const void *b) {
+    const LayoutKey *x = (const LayoutKey*)a, *y = (const LayoutKey*)b;
+
+    if (x->kind == LAYOUT_MISSING || y->kind == LAYOUT_MISSING) {
+        if (x->kind != y->kind)
+            return x->kind == LAYOUT_MISSING ? 1 : -1;
+    }
+    else if (x->dev != y->dev)
+        return x->dev < y->dev ? -1 : 1;
+    else if (x->kind != y->kind)
+        return x->kind < y->kind ? -1 : 1;
+    else if (x->value != y->value)
+        return x->value < y->value ? -1 : 1;
+
+    return x->index < y->index ? -1 : x->index > y->index;
+}
+
+/*********************** EXTERNAL FUNCTIONS ***********************/
+void layout_sort(char **paths, long n) {
+    LayoutKey *keys;
+    LayoutTask *tasks;
+    ThreadPool *pool;
+    long i, n_tasks = (n + LAYOUT_CHUNK - 1) / LAYOUT_CHUNK;
+
+    if (n < 2)
+        return;
+
+    keys = (LayoutKey*) calloc(n, sizeof(LayoutKey));
+    tasks = (LayoutTask*) malloc(n_tasks * sizeof(LayoutTask));
+    ALLOC_CHECK(keys);
+    ALLOC_CHECK(tasks);
+
+    for (i = 0; i < n; i++) {
+        keys[i].path = paths[i];
+        keys[i].index = i;
+    }
+
+    pool = pool_create(n_tasks < LAYOUT_THREADS ? n_tasks : LAYOUT_THREADS, 2 * LAYOUT_THREADS);
+    for (i = 0; i < n_tasks; i++) {
+        tasks[i].keys = keys + i * LAYOUT_CHUNK;
+        tasks[i].len = i == n_tasks - 1 ? n - i * LAYOUT_CHUNK : LAYOUT_CHUNK;
+        pool_submit(pool, compute_keys, &tasks[i]);
+    }
+    pool_destroy(pool, NULL);
+
+    qsort(keys, n, sizeof(LayoutKey), sort_layout);
+    for (i = 0; i < n; i++)
+        paths[i] = keys[i].path;
+
+    free(tasks);
+    free(keys);
+}
@@ -0,0 +1,32 @@
+/**
+* @file
+* @brief Zaglavlje za redjanje fajlova po fizickom polozaju na disku (--physical).
+* @details Za svaki fajl se FIEMAP ioctl-om trazi fizicka adresa prvog ekstenta, pa se fajlovi
+* obradjuju redom kojim su zapisani na disku umesto redom naziva, cime se na rotacionim diskovima
+* izbegava stalno pomeranje glave. Na fajl sistemima bez FIEMAP-a (i van Linux-a) koristi se broj
+* inode-a, koji obicno prati redosled pravljenja fajlova. Fajlovi se prvo grupisu po uredjaju.
+* Upiti se rade paralelno u LAYOUT_THREADS niti.
+*/
+
+#ifndef _LAYOUT_H
+#define _LAYOUT_H
+
+/**
+* @brief Broj niti za upite o polozaju fajlova (upiti cekaju na disk, a ne na procesor).
+*/
+#define LAYOUT_THREADS 8
+
+/**
+* @brief Broj fajlova koje obradjuje jedan zadatak.
+*/
+#define LAYOUT_CHUNK 256
+
+/**
+* @brief Funkcija koja uredjuje niz putanja po fizickom polozaju fajlova. Fajlovi koji ne postoje
+* ostaju na kraju, redom kojim su zadati.
+* @param[in,out] paths Niz putanja
+* @param[in] n Broj putanja
+*/
+void layout_sort(char **paths, long n);
+
+#endif // _LAYOUT_H
@@ -0,0 +1,333 @@
+/**
+* @file
+* @brief Funkcije za strukturirani log obrade vise fajlova.
+* @details Bafer jedne niti je klasican kruzni bafer sa jednim proizvodjacem i jednim potrosacem:
+* proizvodjac pomera samo tail, a pisac samo head. Baferi se prave kada nit prvi put upise zapis
+* i dodaju na pocetak liste bez zakljucavanja (compare-and-swap). Niti upisuju zapis cim zavrse
+* fajl, pa zapisi stizu van reda: pisac prazni sve bafere i zapis koji je stigao pre svog reda
+* cuva u listi sortiranoj po rednom broju, tako da nit nikada ne ceka na zapis druge niti.
+* Mutex i uslovna promenljiva se koriste samo da se uspavani pisac probudi.
+*/
+
+#include "log_ring.h"
+#include "global.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+
+/**
+* @brief Najduze vreme koje pisac spava pre nego sto ponovo proveri bafere (u milisekundama).
+*/
+#define LOG_WRITER_SLEEP_MS 10
+
+/**
+* @brief Kruzni bafer jedne niti.
+*/
+typedef struct LogRing {
+    struct LogRing *next;
+    atomic_ulong head, tail;
+    LogRecord records[LOG_RING_LEN];
+} LogRing;
+
+/**
+* @brief Zapis koji je stigao pre svog reda.
+*/
+typedef struct LogPending {
+    struct LogPending *next;
+    LogRecord record;
+} LogPending;
+
+struct LogSink {
+    long id;
+    FILE *out;
+    LogFormat format;
+    long next_seq;
+    LogPending *pending;    /**< Sortirano po rednom broju, pristupa samo pisac */
+
+    _Atomic(LogRing*) rings;
+    atomic_int sleeping;
+    atomic_int stop;
+
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+};
+
+/**
+* @brief Brojac za jedinstvene identifikatore logova.
+*/
+static atomic_long sink_ids = 0;
+
+/**
+* @brief Bafer tekuce niti i identifikator loga kome pripada.
+*/
+static __thread long thread_sink_id = 0;
+static __thread LogRing *thread_ring = NULL;
+
+/*********************** INTERNAL FUNCTIONS ***********************/
+/**
+* @brief Funkcija koja vraca bafer tekuce niti za zadati log i pravi ga ukoliko ne postoji.
+*/
+static LogRing* get_thread_ring(LogSink *sink) {
+    LogRing *ring;
+
+    if (thread_sink_id == sink->id)
+        return thread_ring;
+
+    ring = (LogRing*) calloc(1, sizeof(LogRing));
+    ALLOC_CHECK(ring);
+    ring->next = atomic_load(&sink->rings);
+    while (!atomic_compare_exchange_weak(&sink->rings, &ring->next, ring))
+        ;
+
+    thread_sink_id = sink->id;
+    thread_ring = ring;
+    return ring;
+}
+
+/**
+* @brief Funkcija koja ispisuje string kao JSON string (sa navodnicima).
+*/
+static void write_json_string(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        unsigned char c = *s;
+        if (c == '"' || c == '\\')
+            fprintf(out, "\\%c", c);
+        else if (c == '\n')
+            fputs("\\n", out);
+        else if (c == '\t')
+            fputs("\\t", out);
+        else if (c < 0x20)
+            fprintf(out, "\\u%04x", c);
+        else
+            fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+/**
+* @brief Funkcija koja ispisuje jedan zapis.
+*/
+static void write_record(LogSink *sink, const LogRecord *rec) {
+    FILE *out = sink->out;
+
+    if (rec->type == LOG_FILE && rec->unchanged)
+        return;
+
+    if (sink->format == LOG_TEXT) {
+        if (rec->type == LOG_SCHEDULER)
+            fprintf(out, "Scheduler: %d workers, %ld tasks, %ld steals, %.3f s idle\n",
+                    rec->workers, rec->tasks, rec->steals, rec->idle_sec);
+        else if (rec->type == LOG_INCREMENTAL)
+            fprintf(out, "Incremental: %ld unchanged files skipped\n", rec->unchanged);
+        else if (rec->result)
+            fprintf(out, "Error with file %s:%s\n", rec->file, rec->error_msg);
+        else
+            fprintf(out, "File %s %s\n", rec->file, rec->encr_flag ? "encrypted" : "decrypted");
+        return;
+    }
+
+    if (rec->type == LOG_SCHEDULER) {
+        fprintf(out, "{\"seq\":%ld,\"event\":\"scheduler\",\"workers\":%d,\"tasks\":%ld,\"steals\":%ld,\"idle_s\":%.6f}\n",
+                rec->seq, rec->workers, rec->tasks, rec->steals, rec->idle_sec);
+        return;
+    }
+    if (rec->type == LOG_INCREMENTAL) {
+        fprintf(out, "{\"seq\":%ld,\"event\":\"incremental\",\"unchanged\":%ld}\n", rec->seq, rec->unchanged);
+        return;
+    }
+
+    fprintf(out, "{\"seq\":%ld,\"event\":\"file\",\"op\":\"%s\",\"file\":", rec->seq, rec->encr_flag ? "encrypt" : "decrypt");
+    write_json_string(out, rec->file);
+    fprintf(out, ",\"algorithm\":\"%s\",\"bytes\":%llu,\"duration_ms\":%.3f,\"result\":%d,\"error\":",
+            log_algorithm_name(rec->algo), (unsigned long long)rec->bytes, rec->duration * 1000, rec->result);
+    write_json_string(out, rec->error_msg);
+    fputs("}\n", out);
+}
+
+/**
+* @brief Funkcija koja ispisuje zapise sa cekanja koji su dosli na red.
+* @param[in] sink Pokazivac na log
+* @param[in] force Ukoliko je razlicit od 0, ispisuju se svi zapisi, i preko praznina (na kraju rada)
+*/
+static void emit_pending(LogSink *sink, int force) {
+    LogPending *p;
+
+    while ((p = sink->pending) && (force || p->record.seq == sink->next_seq)) {
+        write_record(sink, &p->record);
+        sink->next_seq = p->record.seq + 1;
+        sink->pending = p->next;
+        free(p);
+    }
+}
+
+/**
+* @brief Funkcija koja prazni bafere niti: zapis sa sledecim rednim brojem se ispisuje, a ostali se
+* cuvaju na cekanju.
+* @param[in] sink Pokazivac na log
+* @return Broj preuzetih zapisa
+*/
+static int drain_rings(LogSink *sink) {
+    LogRing *ring;
+    LogRecord *rec;
+    LogPending *p, **pos;
+    unsigned long head;
+    int n = 0;
+
+    for (ring = atomic_load(&sink->rings); ring; ring = ring->next) {
+        head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        for (; head != atomic_load(&ring->tail); head++, n++) {
+            rec = &ring->records[head % LOG_RING_LEN];
+            if (rec->seq == sink->next_seq) {
+                write_record(sink, rec);
+                sink->next_seq = rec->seq + 1;
+                emit_pending(sink, 0);
+            } else {
+                p = (LogPending*) malloc(sizeof(LogPending));
+                ALLOC_CHECK(p);
+                p->record = *rec;
+                for (pos = &sink->pending; *pos && (*pos)->record.seq < rec->seq; pos = &(*pos)->next)
+                    ;
+                p->next = *pos;
+                *pos = p;
+            }
+            atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+        }
+    }
+    return n;
+}
+
+/**
+* @brief Glavna funkcija niti pisca.
+* @param[in] arg Pokazivac na LogSink
+*/
+static void* writer_main(void *arg) {
+    LogSink *sink = (LogSink*)arg;
+    struct timespec ts;
+
+    for (;;) {
+        if (drain_rings(sink))
+            continue;
+
+        if (atomic_load(&sink->stop)) {
+            if (drain_rings(sink))
+                continue;
+            emit_pending(sink, 1);
+            break;
+        }
+
+        /// najavljuje spavanje, pa ponovo proverava bafere da se ne bi propustio zapis
+        atomic_store(&sink->sleeping, 1);
+        if (drain_rings(sink)) {
+            atomic_store(&sink->sleeping, 0);
+            continue;
+        }
+
+        fflush(sink->out);
+        pthread_mutex_lock(&sink->lock);
+        if (atomic_load(&sink->sleeping) && !atomic_load(&sink->stop)) {
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += LOG_WRITER_SLEEP_MS * 1000000L;
+            if (ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&sink->wake, &sink->lock, &ts);
+        }
+        atomic_store(&sink->sleeping, 0);
+        pthread_mutex_unlock(&sink->lock);
+    }
+
+    fflush(sink->out);
+    return NULL;
+}
+
+/**
+* @brief Funkcija koja budi nit pisca ukoliko spava.
+*/
+static void wake_writer(LogSink *sink) {
+    if (atomic_load(&sink->sleeping)) {
+        pthread_mutex_lock(&sink->lock);
+        atomic_store(&sink->sleeping, 0);
+        pthread_cond_signal(&sink->wake);
+        pthread_mutex_unlock(&sink->lock);
+    }
+}
+
+/*********************** EXTERNAL FUNCTIONS ***********************/
+LogSink* log_open(FILE *out, LogFormat format, long first_seq) {
+    LogSink *sink = (LogSink*) calloc(1, sizeof(LogSink));
+    ALLOC_CHECK(sink);
+
+    sink->id = atomic_fetch_add(&sink_ids, 1) + 1;
+    sink->out = out;
+    sink->format = format;
+    sink->next_seq = first_seq;
+    atomic_init(&sink->rings, NULL);
+    atomic_init(&sink->sleeping, 0);
+    atomic_init(&sink->stop, 0);
+    pthread_mutex_init(&sink->lock, NULL);
+    pthread_cond_init(&sink->wake, NULL);
+
+    pthread_create(&sink->writer, NULL, writer_main, sink);
+    return sink;
+}
+
+void log_push(LogSink *sink, const LogRecord *record) {
+    LogRing *ring = get_thread_ring(sink);
+    unsigned long tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    LogRecord *rec;
+
+    while (tail - atomic_load_explicit(&ring->head, memory_order_acquire) == LOG_RING_LEN) {
+        wake_writer(sink);
+        sched_yield();
+    }
+
+    rec = &ring->records[tail % LOG_RING_LEN];
+    rec->type = record->type;
+    rec->seq = record->seq;
+    rec->encr_flag = record->encr_flag;
+    rec->algo = record->algo;
+    rec->result = record->result;
+    rec->bytes = record->bytes;
+    rec->duration = record->duration;
+    rec->unchanged = record->unchanged;
+    rec->workers = record->workers;
+    rec->tasks = record->tasks;
+    rec->steals = record->steals;
+    rec->idle_sec = record->idle_sec;
+    strcpy(rec->file, record->file);
+    strcpy(rec->error_msg, record->error_msg);
+
+    atomic_store(&ring->tail, tail + 1);
+    wake_writer(sink);
+}
+
+void log_close(LogSink *sink) {
+    LogRing *ring, *next;
+
+    pthread_mutex_lock(&sink->lock);
+    atomic_store(&sink->stop, 1);
+    pthread_cond_signal(&sink->wake);
+    pthread_mutex_unlock(&sink->lock);
+    pthread_join(sink->writer, NULL);
+
+    for (ring = atomic_load(&sink->rings); ring; ring = next) {
+        next = ring->next;
+        free(ring);
+    }
+    pthread_mutex_destroy(&sink->lock);
+    pthread_cond_destroy(&sink->wake);
+    free(sink);
+}
+
+const char* log_algorithm_name(Algorithm algo) {
+    static const char *names[] = {"des_ecb", "des_cbc", "tdes_ecb", "tdes_cbc",
+                                  "aes128_ecb", "aes128_cbc", "aes192_ecb", "aes192_cbc",
+                                  "aes256_ecb", "aes256_cbc"};
+    return algo >= 0 && algo < sizeof(names) / sizeof(names[0]) ? names[algo] : "unknown";
+}
@@ -0,0 +1,104 @@
+/**
+* @file
+* @brief Zaglavlje za strukturirani log obrade vise fajlova.
+* @details Svaka nit koja upisuje u log ima svoj kruzni bafer zapisa (jedan proizvodjac, jedan potrosac,
+* bez zakljucavanja). Jedna nit pisac prazni bafere i ispisuje zapise redosledom njihovih rednih
+* brojeva, bilo u dosadasnjem tekstualnom obliku ("File X encrypted", "Error with file X:poruka"),
+* bilo kao JSON, jedan zapis po liniji.
+*/
+
+#ifndef _LOG_RING_H
+#define _LOG_RING_H
+
+#include "encryption.h"
+#include <stdio.h>
+#include <stdint.h>
+
+/**
+* @brief Broj zapisa u kruznom baferu jedne niti.
+*/
+#define LOG_RING_LEN 32
+
+/**
+* @brief Maksimalna duzina putanje fajla u zapisu.
+*/
+#define LOG_PATH_MAX 4096
+
+/**
+* @brief Maksimalna duzina poruke o gresci u zapisu.
+*/
+#define LOG_MSG_MAX 512
+
+/**
+* @brief Oblik u kome se zapisi ispisuju.
+*/
+typedef enum LogFormat {
+    LOG_TEXT, LOG_JSON
+} LogFormat;
+
+/**
+* @brief Vrsta zapisa.
+*/
+typedef enum LogRecordType {
+    LOG_FILE,       /**< Ishod obrade jednog fajla */
+    LOG_SCHEDULER,  /**< Statistika rada niti na kraju obrade */
+    LOG_INCREMENTAL /**< Broj nepromenjenih fajlova preskocenih u inkrementalnom modu */
+} LogRecordType;
+
+/**
+* @brief Jedan zapis loga.
+*/
+typedef struct LogRecord {
+    LogRecordType type;
+    long seq;               /**< Redni broj; zapisi se ispisuju redom, bez preskakanja */
+
+    int encr_flag;
+    Algorithm algo;
+    int result;             /**< Kod greske iz global.h, 0 za uspesnu obradu */
+    uint64_t bytes;         /**< Broj bajtova originalnog fajla */
+    double duration;        /**< Trajanje obrade u sekundama */
+    char file[LOG_PATH_MAX];
+    char error_msg[LOG_MSG_MAX];
+    long unchanged;         /**< Za LOG_FILE: fajl je preskocen i ne ispisuje se; za LOG_INCREMENTAL: broj takvih */
+
+    int workers;
+    long tasks, steals;
+    double idle_sec;
+} LogRecord;
+
+/**
+* @brief Struktura loga.
+*/
+typedef struct LogSink LogSink;
+
+/**
+* @brief Funkcija koja otvara log i pokrece nit pisca.
+* @param[in] out Fajl u koji se ispisuju zapisi
+* @param[in] format Oblik zapisa
+* @param[in] first_seq Redni broj prvog zapisa
+* @return Pokazivac na log
+*/
+LogSink* log_open(FILE *out, LogFormat format, long first_seq);
+
+/**
+* @brief Funkcija koja dodaje zapis u kruzni bafer tekuce niti. Ne zakljucava nista; ukoliko je
+* bafer pun, ceka da ga nit pisac isprazni. Zapisi razlicitih niti mogu da stignu u bilo kom redosledu.
+* @param[in] sink Pokazivac na log
+* @param[in] record Pokazivac na zapis
+*/
+void log_push(LogSink *sink, const LogRecord *record);
+
+/**
+* @brief Funkcija koja ceka da se ispisu svi zapisi, zaustavlja nit pisca i oslobadja log.
+* @param[in] sink Pokazivac na log
+*/
+void log_close(LogSink *sink);
+
+/**
+* @brief Funkcija koja vraca naziv algoritma.
+* @param[in] algo Algoritam
+* @return Naziv algoritma (npr. "aes128_cbc")
+*/
+const char* log_algorithm_name(Algorithm algo);
+
+#endif // _LOG_RING_H
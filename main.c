@@ -254,7 +254,7 @@ void more_files_encr() {
         error_message("No active key selected!", 1);
     else if (get_filepath(file_path) == KEY_ESC)
         error_message("File path not inputed!", 1);
-    else if (encrypt_more_files(file_path, active_key, log_file))
+    else if (encrypt_more_files(file_path, active_key, log_file, NULL))
         error_message("Unable to open file!", 1);
     else
         error_message("See log.txt for info about encryption.", 0);
@@ -276,7 +276,7 @@ void regex_encr() {
         error_message("No active key selected!", 1);
     else if (!get_one_string_input("Regex pattern:", regex_pattern, 60))
         error_message("Regex pattern not inputed!", 1);
-    else if (encrypt_regex_files(regex_pattern, active_key, error_msg, log_file))
+    else if (encrypt_regex_files(regex_pattern, active_key, error_msg, log_file, NULL))
         error_message(error_msg, 1);
     else
         error_message("See log.txt for info about encryption.", 0);
@@ -315,7 +315,7 @@ void more_files_decr() {
         error_message("No active key selected!", 1);
     else if (get_filepath(file_path) == KEY_ESC)
         error_message("File path not inputed!", 1);
-    else if (decrypt_more_files(file_path, active_key, log_file))
+    else if (decrypt_more_files(file_path, active_key, log_file, NULL))
         error_message("Unable to open file!", 1);
     else
         error_message("See log.txt for info about decryption.", 0);
@@ -337,7 +337,7 @@ void regex_decr() {
         error_message("No active key selected!", 1);
     else if (!get_one_string_input("Regex pattern:", regex_pattern, 60))
         error_message("Regex pattern not inputed!", 1);
-    else if (decrypt_regex_files(regex_pattern, active_key, error_msg, log_file))
+    else if (decrypt_regex_files(regex_pattern, active_key, error_msg, log_file, NULL))
         error_message(error_msg, 1);
     else
         error_message("See log.txt for info about decryption.", 0);
@@ -396,7 +396,8 @@ static char* get_one_string_input(char *description, char *buf, int field_size)
 int main(int argc, char *argv[]) {
     /// initialization
     key_list = init_list();
-    read_keys(KEYS_FILE, &key_list);
+    if (argc == 1 || command_needs_keys(argc, argv))
+        read_keys(KEYS_FILE, &key_list);
     active_key = NULL;
 
     /// MAIN WORK
@@ -0,0 +1,405 @@
+/**
+* @file
+* @brief Funkcije za manifest inkrementalne enkripcije.
+* @details Stari manifest je mapiran samo za citanje, pa ga radne niti pretrazuju bez zakljucavanja.
+* Novi zapisi se dodaju u niz pod mutex-om.
+*/
+
+#include "manifest.h"
+#include "global.h"
+#include "file_header/file_header.h"
+#include "io/stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/**
+* @brief Oznaka na pocetku manifesta (verzija formata je poslednji karakter).
+*/
+#define MANIFEST_MAGIC "ENCMAN1"
+
+/**
+* @brief Velicina bafera za racunanje CRC-a sadrzaja.
+*/
+#define MANIFEST_BUF_LEN (256 * 1024)
+
+/**
+* @brief Zaglavlje manifesta na disku.
+*/
+typedef struct ManifestHeader {
+    char magic[8];
+    uint64_t count;
+    uint64_t strings_len;
+} ManifestHeader;
+
+/**
+* @brief Zapis manifesta na disku. Stringovi su dati kao pomeraji u nizu stringova.
+*/
+typedef struct ManifestDiskEntry {
+    uint64_t hash;
+    uint64_t size;
+    int64_t mtime_ns;
+    uint64_t ino;
+    uint64_t out_size;
+    uint64_t path_off, out_off, key_off;
+    uint32_t crc;
+    uint32_t pad;
+} ManifestDiskEntry;
+
+/**
+* @brief Zapis manifesta u memoriji (stari zapisi pokazuju na mapirane stringove).
+*/
+typedef struct ManifestEntry {
+    uint64_t hash;
+    uint64_t size;
+    int64_t mtime_ns;
+    uint64_t ino;
+    uint64_t out_size;
+    const char *path, *out, *key;
+    uint32_t crc;
+} ManifestEntry;
+
+struct Manifest {
+    char *path;
+
+    void *map;
+    size_t map_len;
+    const ManifestDiskEntry *old;
+    uint64_t n_old;
+    const char *strings;
+
+    ManifestEntry *added;
+    long n_added, cap_added;
+    pthread_mutex_t lock;
+};
+
+/*********************** INTERNAL FUNCTIONS ***********************/
+/**
+* @brief Funkcija koja racuna 64-bitni FNV-1a hes putanje.
+*/
+static uint64_t hash_path(const char *path) {
+    uint64_t h = 14695981039346656037ULL;
+
+    while (*path) {
+        h ^= (unsigned char)*path++;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/**
+* @brief Funkcija koja vraca vreme izmene fajla u nanosekundama.
+*/
+static int64_t mtime_ns(const struct stat *st) {
+    return (int64_t)st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec;
+}
+
+/**
+* @brief Funkcija koja mapira postojeci manifest i proverava da mu je sadrzaj u granicama fajla.
+*/
+static void map_manifest(Manifest *manifest) {
+    const ManifestHeader *header;
+    struct stat st;
+    int fd = open(manifest->path, O_RDONLY);
+
+    if (fd < 0)
+        return;
+    if (fstat(fd, &st) || (size_t)st.st_size < sizeof(ManifestHeader)) {
+        close(fd);
+        return;
+    }
+
+    manifest->map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (manifest->map == MAP_FAILED) {
+        manifest->map = NULL;
+        return;
+    }
+    manifest->map_len = st.st_size;
+
+    header = (const ManifestHeader*)manifest->map;
+    if (memcmp(header->magic, MANIFEST_MAGIC, sizeof(header->magic)) ||
+        header->count > (st.st_size - sizeof(ManifestHeader)) / sizeof(ManifestDiskEntry) ||
+        header->strings_len != st.st_size - sizeof(ManifestHeader) - header->count * sizeof(ManifestDiskEntry) ||
+        (header->strings_len && ((const char*)manifest->map)[st.st_size - 1] != '\0')) {
+        munmap(manifest->map, manifest->map_len);
+        manifest->map = NULL;
+        return;
+    }
+
+    manifest->old = (const ManifestDiskEntry*)(header + 1);
+    manifest->n_old = header->count;
+    manifest->strings = (const char*)(manifest->old + manifest->n_old);
+}
+
+/**
+* @brief Funkcija koja vraca string starog zapisa, NULL ukoliko pomeraj nije ispravan.
+*/
+static const char* old_string(Manifest *manifest, uint64_t off) {
+    const ManifestHeader *header = (const ManifestHeader*)manifest->map;
+    return off < header->strings_len ? manifest->strings + off : NULL;
+}
+
+/**
+* @brief Funkcija koja binarnom pretragom nalazi stari zapis za putanju.
+*/
+static const ManifestDiskEntry* find_old(Manifest *manifest, const char *path) {
+    uint64_t h = hash_path(path), lo = 0, hi = manifest->n_old, mid;
+    const char *s;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (manifest->old[mid].hash < h)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    for (; lo < manifest->n_old && manifest->old[lo].hash == h; lo++)
+        if ((s = old_string(manifest, manifest->old[lo].path_off)) && !strcmp(s, path))
+            return &manifest->old[lo];
+    return NULL;
+}
+
+/**
+* @brief Funkcija koja racuna CRC registar sadrzaja fajla (isti kao u hederu .dat fajla).
+* @return 0 ili -1 ukoliko fajl ne moze da se procita.
+*/
+static int content_crc(const char *path, uint32_t *crc) {
+    unsigned char *buf = (unsigned char*) malloc(MANIFEST_BUF_LEN);
+    ssize_t n;
+    int fd;
+    ALLOC_CHECK(buf);
+
+    *crc = ~0U;
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        free(buf);
+        return -1;
+    }
+    while ((n = read(fd, buf, MANIFEST_BUF_LEN)) > 0 || (n < 0 && errno == EINTR))
+        if (n > 0)
+            *crc = crc32Update(*crc, buf, n);
+    close(fd);
+    free(buf);
+    return n < 0 ? -1 : 0;
+}
+
+/**
+* @brief Funkcija koja dodaje zapis u niz novih zapisa.
+*/
+static void add_entry(Manifest *manifest, const char *path, const struct stat *st, uint32_t crc,
+                      const char *out, uint64_t out_size, const char *key_name) {
+    ManifestEntry e;
+
+    e.hash = hash_path(path);
+    e.size = st->st_size;
+    e.mtime_ns = mtime_ns(st);
+    e.ino = st->st_ino;
+    e.out_size = out_size;
+    e.crc = crc;
+    e.path = strdup(path);
+    e.out = strdup(out);
+    e.key = strdup(key_name);
+    ALLOC_CHECK(e.path);
+    ALLOC_CHECK(e.out);
+    ALLOC_CHECK(e.key);
+
+    pthread_mutex_lock(&manifest->lock);
+    if (manifest->n_added == manifest->cap_added) {
+        manifest->cap_added = manifest->cap_added ? 2 * manifest->cap_added : 1024;
+        manifest->added = (ManifestEntry*) realloc(manifest->added, manifest->cap_added * sizeof(ManifestEntry));
+        ALLOC_CHECK(manifest->added);
+    }
+    manifest->added[manifest->n_added++] = e;
+    pthread_mutex_unlock(&manifest->lock);
+}
+
+/**
+* @brief Funkcija za poredjenje zapisa po hesu, pa po putanji (za qsort).
+*/
+static int sort_entries(const void *a, const void *b) {
+    const ManifestEntry *x = (const ManifestEntry*)a, *y = (const ManifestEntry*)b;
+
+    if (x->hash != y->hash)
+        return x->hash < y->hash ? -1 : 1;
+    return strcmp(x->path, y->path);
+}
+
+/**
+* @brief Funkcija koja pravi zapis u memoriji od starog zapisa.
+*/
+static int load_old(Manifest *manifest, uint64_t i, ManifestEntry *e) {
+    const ManifestDiskEntry *d = &manifest->old[i];
+
+    e->hash = d->hash;
+    e->size = d->size;
+    e->mtime_ns = d->mtime_ns;
+    e->ino = d->ino;
+    e->out_size = d->out_size;
+    e->crc = d->crc;
+    e->path = old_string(manifest, d->path_off);
+    e->out = old_string(manifest, d->out_off);
+    e->key = old_string(manifest, d->key_off);
+    return e->path && e->out && e->key;
+}
+
+/**
+* @brief Funkcija koja upisuje niz zapisa (stari zapisi koje novi ne zamenjuju i novi zapisi,
+* spojeni po redosledu) u novi fajl i zamenjuje njime stari manifest.
+*/
+static int write_manifest(Manifest *manifest) {
+    ManifestEntry *all, e;
+    ManifestHeader header;
+    ManifestDiskEntry d;
+    char tmp_path[4096];
+    uint64_t i, n = 0, off = 0;
+    long j = 0;
+    FILE *f;
+    int status = 0, cmp, len;
+
+    len = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", manifest->path);
+    if (len < 0 || (size_t)len >= sizeof(tmp_path))
+        return IO_ERR;
+
+    qsort(manifest->added, manifest->n_added, sizeof(ManifestEntry), sort_entries);
+
+    /// spajanje dva sortirana niza; za istu putanju vazi novi zapis
+    all = (ManifestEntry*) malloc((manifest->n_old + manifest->n_added + 1) * sizeof(ManifestEntry));
+    ALLOC_CHECK(all);
+    for (i = 0; i < manifest->n_old; i++) {
+        if (!load_old(manifest, i, &e))
+            continue;
+        while (j < manifest->n_added && (cmp = sort_entries(&manifest->added[j], &e)) < 0)
+            all[n++] = manifest->added[j++];
+        if (j < manifest->n_added && !cmp)
+            continue;
+        all[n++] = e;
+    }
+    while (j < manifest->n_added)
+        all[n++] = manifest->added[j++];
+
+    /// uzastopni zapisi za istu putanju (fajl zadat vise puta), ostaje poslednji
+    for (i = j = 0; i < n; i++) {
+        if (j && !sort_entries(&all[j - 1], &all[i]))
+            j--;
+        all[j++] = all[i];
+    }
+    n = j;
+
+    if (!(f = fopen(tmp_path, "wb"))) {
+        free(all);
+        return IO_ERR;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MANIFEST_MAGIC, sizeof(header.magic));
+    header.count = n;
+    for (i = 0; i < n; i++)
+        header.strings_len += strlen(all[i].path) + strlen(all[i].out) + strlen(all[i].key) + 3;
+    fwrite(&header, sizeof(header), 1, f);
+
+    memset(&d, 0, sizeof(d));
+    for (i = 0; i < n; i++) {
+        d.hash = all[i].hash;
+        d.size = all[i].size;
+        d.mtime_ns = all[i].mtime_ns;
+        d.ino = all[i].ino;
+        d.out_size = all[i].out_size;
+        d.crc = all[i].crc;
+        d.path_off = off;
+        off += strlen(all[i].path) + 1;
+        d.out_off = off;
+        off += strlen(all[i].out) + 1;
+        d.key_off = off;
+        off += strlen(all[i].key) + 1;
+        fwrite(&d, sizeof(d), 1, f);
+    }
+    for (i = 0; i < n; i++) {
+        fwrite(all[i].path, strlen(all[i].path) + 1, 1, f);
+        fwrite(all[i].out, strlen(all[i].out) + 1, 1, f);
+        fwrite(all[i].key, strlen(all[i].key) + 1, 1, f);
+    }
+    free(all);
+
+    if (fflush(f) || ferror(f) || fdatasync(fileno(f)))
+        status = IO_ERR;
+    if (fclose(f))
+        status = IO_ERR;
+    if (!status && rename(tmp_path, manifest->path))
+        status = IO_ERR;
+    if (status) {
+        unlink(tmp_path);
+        return status;
+    }
+    /// novo ime je trajno tek kada je i direktorijum spusten na disk
+    streamSyncDir(manifest->path);
+    return 0;
+}
+
+/*********************** EXTERNAL FUNCTIONS ***********************/
+Manifest* manifest_open(const char *path) {
+    Manifest *manifest = (Manifest*) calloc(1, sizeof(Manifest));
+    ALLOC_CHECK(manifest);
+
+    manifest->path = strdup(path);
+    ALLOC_CHECK(manifest->path);
+    pthread_mutex_init(&manifest->lock, NULL);
+    map_manifest(manifest);
+    return manifest;
+}
+
+int manifest_unchanged(Manifest *manifest, const char *path, const struct stat *st, const char *out, const char *key_name) {
+    const ManifestDiskEntry *d = find_old(manifest, path);
+    const char *s;
+    struct stat out_st;
+    uint32_t crc;
+
+    if (!d || d->size != (uint64_t)st->st_size ||
+        !(s = old_string(manifest, d->key_off)) || strcmp(s, key_name) ||
+        !(s = old_string(manifest, d->out_off)) || strcmp(s, out) ||
+        stat(out, &out_st) || (uint64_t)out_st.st_size != d->out_size)
+        return 0;
+
+    if (d->mtime_ns == mtime_ns(st) && d->ino == st->st_ino)
+        return 1;
+
+    /// metapodaci su se promenili, a velicina nije: odlucuje sadrzaj
+    if (content_crc(path, &crc) || crc != d->crc)
+        return 0;
+    add_entry(manifest, path, st, crc, out, d->out_size, key_name);
+    return 1;
+}
+
+void manifest_record(Manifest *manifest, const char *path, const struct stat *st, uint32_t crc,
+                     const char *out, const char *key_name) {
+    struct stat out_st;
+
+    if (!stat(out, &out_st))
+        add_entry(manifest, path, st, crc, out, out_st.st_size, key_name);
+}
+
+int manifest_close(Manifest *manifest) {
+    int status = 0;
+    long i;
+
+    if (manifest->n_added)
+        status = write_manifest(manifest);
+
+    if (manifest->map)
+        munmap(manifest->map, manifest->map_len);
+    for (i = 0; i < manifest->n_added; i++) {
+        free((char*)manifest->added[i].path);
+        free((char*)manifest->added[i].out);
+        free((char*)manifest->added[i].key);
+    }
+    free(manifest->added);
+    pthread_mutex_destroy(&manifest->lock);
+    free(manifest->path);
+    free(manifest);
+    return status;
+}
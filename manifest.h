@@ -0,0 +1,71 @@
+/**
+* @file
+* @brief Zaglavlje za manifest inkrementalne enkripcije (-u), koji omogucava da se preskoce fajlovi
+* koji se nisu promenili od prethodne obrade.
+* @details Za svaki enkriptovani fajl manifest cuva putanju, velicinu, vreme izmene, inode, CRC
+* sadrzaja (isti onaj koji se upisuje u heder), putanju i velicinu izlaza i naziv kljuca. Fajl je
+* nepromenjen ukoliko se slazu velicina, vreme izmene i inode, a izlaz postoji i ima zapisanu velicinu.
+* Ukoliko se razlikuju samo vreme izmene ili inode (fajl je npr. kopiran ili "dodirnut"), racuna se
+* CRC sadrzaja i fajl se preskace ako je isti.
+*
+* Manifest je binarni fajl: zaglavlje, niz zapisa fiksne duzine sortiran po hesu putanje i niz
+* stringova. Prilikom otvaranja se mapira u memoriju (mmap), pa je provera jedna binarna pretraga bez
+* ucitavanja i parsiranja celog fajla. Novi zapisi se cuvaju u memoriji, a na kraju obrade se spajaju
+* sa starim i upisuju u novi fajl koji zamenjuje stari (rename).
+*/
+
+#ifndef _MANIFEST_H
+#define _MANIFEST_H
+
+#include <stdint.h>
+#include <sys/stat.h>
+
+/**
+* @brief Podrazumevana putanja manifesta.
+*/
+#define MANIFEST_FILE "manifest.idx"
+
+/**
+* @brief Struktura manifesta.
+*/
+typedef struct Manifest Manifest;
+
+/**
+* @brief Funkcija koja otvara manifest. Ukoliko fajl ne postoji ili nije ispravan, manifest je prazan.
+* @param[in] path Putanja manifesta
+* @return Pokazivac na manifest
+*/
+Manifest* manifest_open(const char *path);
+
+/**
+* @brief Funkcija koja proverava da li je fajl nepromenjen od poslednje enkripcije.
+* Moze se pozivati iz vise niti.
+* @param[in] manifest Pokazivac na manifest
+* @param[in] path Putanja fajla
+* @param[in] st Rezultat stat poziva za fajl
+* @param[in] out Putanja izlaza
+* @param[in] key_name Naziv kljuca
+* @return 1 ukoliko fajl treba preskociti, 0 u suprotnom
+*/
+int manifest_unchanged(Manifest *manifest, const char *path, const struct stat *st, const char *out, const char *key_name);
+
+/**
+* @brief Funkcija koja belezi uspesno enkriptovan fajl. Moze se pozivati iz vise niti.
+* @param[in] manifest Pokazivac na manifest
+* @param[in] path Putanja fajla
+* @param[in] st Rezultat stat poziva za fajl pre enkripcije
+* @param[in] crc CRC registar sadrzaja fajla
+* @param[in] out Putanja izlaza
+* @param[in] key_name Naziv kljuca
+*/
+void manifest_record(Manifest *manifest, const char *path, const struct stat *st, uint32_t crc,
+                     const char *out, const char *key_name);
+
+/**
+* @brief Funkcija koja upisuje manifest sa novim zapisima i oslobadja ga.
+* @param[in] manifest Pokazivac na manifest
+* @return 0 ili IO_ERR
+*/
+int manifest_close(Manifest *manifest);
+
+#endif // _MANIFEST_H
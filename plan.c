@@ -0,0 +1,510 @@
+/**
+* @file
+* @brief Funkcije za planiranje i izvrsavanje batch fajla sa komandama (-b).
+* @details Za svaku putanju koju komande citaju ili pisu pamti se faza poslednje komande koja u nju pise
+* i najkasnija faza u kojoj se cita (hes tabela sa ulancavanjem). Putanje se porede kao stringovi posle
+* svodjenja na kanonski oblik (realpath direktorijuma i ime fajla), pa se ista putanja zadata jednom
+* relativno, a jednom apsolutno ili preko simbolickog linka na direktorijum prepoznaje kao ista. Izlaz dekripcije se odredjuje citanjem hedera; ukoliko heder ne moze da se
+* procita (npr. fajl pravi neka ranija komanda), komanda dobija svoju fazu kao i komande za vise fajlova.
+*/
+
+#include "plan.h"
+#include "cmd_line.h"
+#include "global.h"
+#include "keys.h"
+#include "pool.h"
+#include "process.h"
+#include "cipher/cipher.h"
+#include "io/stream.h"
+#include "io/inplace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+
+/**
+* @brief Maksimalna duzina jedne linije batch fajla.
+*/
+#define PLAN_LINE_MAX (BATCH_PATH_MAX + 64)
+
+/**
+* @brief Vrsta linije.
+*/
+typedef enum PlanKind {
+    PLAN_MESSAGE,   /**< Ishod je poznat vec prilikom citanja (neispravna linija, konflikt...) */
+    PLAN_SINGLE,    /**< Enkripcija/dekripcija jednog fajla koju izvrsava planer */
+    PLAN_OTHER      /**< Komanda koju izvrsava run_other */
+} PlanKind;
+
+/**
+* @brief Kljuc sa pripremljenim kontekstom algoritma.
+*/
+typedef struct PlanKey {
+    Key *key;
+    cipherctx_t ctx;
+    int status;     /**< Rezultat cipherInit */
+} PlanKey;
+
+/**
+* @brief Jedna linija batch fajla.
+*/
+typedef struct PlanLine {
+    PlanKind kind;
+    int number;             /**< Redni broj linije u fajlu */
+    int argc;
+    char *argv[PLAN_MAX_ARGS];
+    char *message;          /**< Ishod za PLAN_MESSAGE */
+    int encr_flag;
+    int key_index;
+    int stage;
+    int exit_code;
+    int in_place;           /**< Fajl se obradjuje u mestu (io/inplace.h) */
+    PlanKey *pkey;
+} PlanLine;
+
+/**
+* @brief Putanja koju citaju ili pisu komande.
+*/
+typedef struct PlanPath {
+    struct PlanPath *next;
+    char *path;
+    int writer_line;        /**< Poslednja komanda koja pise u putanju, -1 ukoliko je nema */
+    int writer_stage;
+    int writer_encrypt;     /**< 1 ukoliko je poslednji pisac enkripcija (prepisuje izlaz) */
+    int reader_stage;       /**< Najkasnija faza u kojoj se putanja cita */
+} PlanPath;
+
+/**
+* @brief Stanje planiranja.
+*/
+typedef struct Plan {
+    PlanLine *lines;
+    int n_lines, cap_lines;
+    PlanKey **keys;
+    int n_keys;
+    PlanPath **table;
+    int table_len;
+    int last_stage;         /**< Najveca dodeljena faza */
+    int barrier_stage;      /**< Faza poslednje komande koja se izvrsava sama */
+    int in_place;           /**< Komande za jedan fajl rade u mestu (--in-place) */
+} Plan;
+
+/*********************** INTERNAL FUNCTIONS ***********************/
+/**
+* @brief Funkcija koja uklanja "./" i visestruke '/' iz putanje.
+*/
+static void normalize_path(const char *path, char *out, size_t size) {
+    size_t len = 0;
+
+    while (path[0] == '.' && path[1] == '/')
+        for (path += 2; *path == '/'; path++)
+            ;
+
+    for (; *path && len + 1 < size; path++) {
+        if (*path == '/' && len && out[len - 1] == '/')
+            continue;
+        if (*path == '.' && path[1] == '/' && len && out[len - 1] == '/') {
+            path++;
+            continue;
+        }
+        out[len++] = *path;
+    }
+    out[len] = '\0';
+}
+
+static unsigned long hash_path(const char *path) {
+    unsigned long h = 5381;
+    while (*path)
+        h = h * 33 + (unsigned char)*path++;
+    return h;
+}
+
+/**
+* @brief Funkcija koja svodi putanju na kanonski oblik: realpath direktorijuma, '/' i ime fajla (fajl
+* mozda jos ne postoji). Direktorijum koji ne postoji (pravi ga neka ranija komanda) ostaje kako je
+* zadat, a relativna putanja se tada nadovezuje na radni direktorijum.
+*/
+static void canonical_path(const char *path, char *out, size_t size) {
+    char norm[PLAN_LINE_MAX], dir[PATH_MAX], real[PATH_MAX];
+    const char *name;
+    size_t len;
+    int n;
+
+    normalize_path(path, norm, sizeof(norm));
+    if ((name = strrchr(norm, '/'))) {
+        len = name > norm ? (size_t)(name - norm) : 1;
+        name++;
+    }
+    else {
+        len = 1;
+        name = norm;
+    }
+    if (len < sizeof(dir)) {
+        memcpy(dir, name == norm ? "." : norm, len);
+        dir[len] = '\0';
+    }
+    if (len < sizeof(dir) && realpath(dir, real)) {
+        n = snprintf(out, size, "%s%s%s", real, strcmp(real, "/") ? "/" : "", name);
+        if (n >= 0 && (size_t)n < size)
+            return;
+    }
+    if (norm[0] != '/' && getcwd(dir, sizeof(dir))) {
+        n = snprintf(out, size, "%s/%s", dir, norm);
+        if (n >= 0 && (size_t)n < size)
+            return;
+    }
+    /// predugacka kanonska putanja
+    snprintf(out, size, "%s", norm);
+}
+
+/**
+* @brief Funkcija koja vraca zapis za putanju i pravi ga ukoliko ne postoji.
+*/
+static PlanPath* get_path(Plan *plan, const char *path) {
+    char norm[PLAN_LINE_MAX];
+    PlanPath *p, **bucket;
+
+    canonical_path(path, norm, sizeof(norm));
+    bucket = &plan->table[hash_path(norm) & (plan->table_len - 1)];
+    for (p = *bucket; p; p = p->next)
+        if (!strcmp(p->path, norm))
+            return p;
+
+    p = (PlanPath*) calloc(1, sizeof(PlanPath));
+    ALLOC_CHECK(p);
+    p->path = strdup(norm);
+    ALLOC_CHECK(p->path);
+    p->writer_line = -1;
+    p->next = *bucket;
+    *bucket = p;
+    return p;
+}
+
+/**
+* @brief Funkcija koja vraca indeks kljuca u planu i priprema kontekst kada se kljuc prvi put koristi.
+*/
+static int get_key(Plan *plan, Key *key) {
+    PlanKey *pkey;
+    int i;
+
+    for (i = 0; i < plan->n_keys; i++)
+        if (plan->keys[i]->key == key)
+            return i;
+
+    plan->keys = (PlanKey**) realloc(plan->keys, sizeof(PlanKey*) * (plan->n_keys + 1));
+    ALLOC_CHECK(plan->keys);
+    pkey = (PlanKey*) malloc(sizeof(PlanKey));
+    ALLOC_CHECK(pkey);
+    pkey->key = key;
+    pkey->status = cipherInit(&pkey->ctx, select_algorithm(key), key->key[0], key->key[1], key->key[2]);
+    plan->keys[plan->n_keys] = pkey;
+    return plan->n_keys++;
+}
+
+/**
+* @brief Funkcija koja postavlja ishod linije koji je poznat bez izvrsavanja.
+*/
+static void set_message(PlanLine *line, const char *format, const char *arg) {
+    line->kind = PLAN_MESSAGE;
+    line->message = (char*) malloc(strlen(format) + (arg ? strlen(arg) : 0) + 1);
+    ALLOC_CHECK(line->message);
+    sprintf(line->message, format, arg);
+}
+
+/**
+* @brief Funkcija koja odredjuje fazu komande za vise fajlova ili komande ciji izlaz nije poznat.
+*/
+static void plan_barrier(Plan *plan, PlanLine *line) {
+    line->stage = plan->barrier_stage = ++plan->last_stage;
+}
+
+/**
+* @brief Funkcija koja odredjuje fazu komande za jedan fajl i belezi putanje koje komanda koristi.
+* @param[in] plan Pokazivac na stanje planiranja
+* @param[in] index Indeks linije
+*/
+static void plan_single(Plan *plan, int index) {
+    PlanLine *line = &plan->lines[index];
+    PlanKey *pkey = plan->keys[line->key_index];
+    const char *in = line->argv[3];
+    char out[PLAN_LINE_MAX], *name, msg[64];
+    fileheader_t header;
+    PlanPath *in_path, *out_path;
+    int stage = plan->barrier_stage + 1;
+
+    if (line->encr_flag)
+        snprintf(out, sizeof(out), "%s.dat", in);
+    else if (!pkey->status && !streamReadHeader(&pkey->ctx, in, &header)) {
+        snprintf(out, sizeof(out), "%s", in);
+        name = get_filename_from_path(out);
+        snprintf(name, out + sizeof(out) - name, "%.*s", FILENAME_LEN_MAX, (char*)header.fileName);
+    }
+    else {
+        in_path = get_path(plan, in);
+        if (in_path->writer_line >= 0)
+            plan_barrier(plan, line);
+        else {
+            /// ulaz ne postoji i niko ga ne pravi, komanda ce samo prijaviti gresku
+            line->stage = stage;
+            if (stage > plan->last_stage)
+                plan->last_stage = stage;
+        }
+        return;
+    }
+
+    in_path = get_path(plan, in);
+    out_path = get_path(plan, out);
+
+    if (line->encr_flag && out_path->writer_line >= 0 && out_path->writer_encrypt) {
+        sprintf(msg, "Output conflicts with line %d", plan->lines[out_path->writer_line].number);
+        line->kind = PLAN_MESSAGE;
+        line->message = (char*) malloc(strlen(in) + strlen(msg) + 20);
+        ALLOC_CHECK(line->message);
+        sprintf(line->message, "Error with file %s:%s\n", in, msg);
+        return;
+    }
+
+    if (in_path->writer_line >= 0 && in_path->writer_stage >= stage)
+        stage = in_path->writer_stage + 1;
+    if (out_path->writer_line >= 0 && out_path->writer_stage >= stage)
+        stage = out_path->writer_stage + 1;
+    if (out_path->reader_stage >= stage)
+        stage = out_path->reader_stage + 1;
+    /// obrada u mestu menja i preimenuje ulaz, pa ide posle svih ranijih citanja ulaza
+    if (plan->in_place && in_path->reader_stage >= stage)
+        stage = in_path->reader_stage + 1;
+
+    line->stage = stage;
+    line->in_place = plan->in_place;
+    if (stage > plan->last_stage)
+        plan->last_stage = stage;
+    if (in_path->reader_stage < stage)
+        in_path->reader_stage = stage;
+    out_path->writer_line = index;
+    out_path->writer_stage = stage;
+    out_path->writer_encrypt = line->encr_flag;
+    if (plan->in_place) {
+        in_path->writer_line = index;
+        in_path->writer_stage = stage;
+        in_path->writer_encrypt = 0;
+    }
+}
+
+/**
+* @brief Funkcija koja cita i rasclanjuje jednu liniju.
+* @param[in] plan Pokazivac na stanje planiranja
+* @param[in] line Pokazivac na liniju
+* @param[in] text Tekst linije (bez znaka za novi red)
+* @param[in] key_list Pokazivac na listu kljuceva
+* @return 1 ukoliko je linija prazna i treba je preskociti, 0 u suprotnom
+*/
+static int parse_plan_line(Plan *plan, PlanLine *line, char *text, List *key_list) {
+    char copy[PLAN_LINE_MAX], *token;
+    Key *key;
+
+    memset(line, 0, sizeof(*line));
+    strcpy(copy, text);
+    for (token = strtok(copy, ARGS_SEPARATORS); token; token = strtok(NULL, ARGS_SEPARATORS)) {
+        if (line->argc == PLAN_MAX_ARGS) {
+            set_message(line, "Invalid command: %s\n", text);
+            return 0;
+        }
+        line->argv[line->argc] = strdup(token);
+        ALLOC_CHECK(line->argv[line->argc]);
+        line->argc++;
+    }
+
+    if (!line->argc)
+        return 1;
+
+    if (line->argc == 1)
+        set_message(line, INVALID_COMMAND_STR, NULL);
+    else if (line->argv[1][0] != '-')
+        set_message(line, "Invalid command: %s\n", text);
+    else if (line->argv[1][1] == 'b' || line->argv[1][1] == 'l')
+        set_message(line, "-[b/l] command not allowed: %s\n", text);
+    else if (line->argc == 4 && strlen(line->argv[1]) == 2 && (line->argv[1][1] == 'e' || line->argv[1][1] == 'd')) {
+        if (!(key = find_key_with_name(key_list, line->argv[2])))
+            set_message(line, "Key %s does not exist!\n", line->argv[2]);
+        else {
+            line->kind = PLAN_SINGLE;
+            line->encr_flag = line->argv[1][1] == 'e';
+            line->key_index = get_key(plan, key);
+        }
+    }
+    else
+        line->kind = PLAN_OTHER;
+
+    return 0;
+}
+
+/**
+* @brief Funkcija koja izvrsava jednu komandu za jedan fajl. Izvrsava je radna nit.
+* @param[in] arg Pokazivac na PlanLine
+*/
+static void run_single(void *arg) {
+    PlanLine *line = (PlanLine*)arg;
+
+    if ((line->exit_code = line->pkey->status))
+        return;
+    if (line->in_place && line->encr_flag)
+        line->exit_code = inplaceEncryptFile(&line->pkey->ctx, line->argv[3], NULL);
+    else if (line->in_place)
+        line->exit_code = inplaceDecryptFile(&line->pkey->ctx, line->argv[3], NULL);
+    else if (line->encr_flag)
+        line->exit_code = streamEncryptFile(&line->pkey->ctx, line->argv[3], NULL, NULL);
+    else
+        line->exit_code = streamDecryptFile(&line->pkey->ctx, line->argv[3], NULL, NULL);
+}
+
+/**
+* @brief Funkcija koja ispisuje ishod jedne linije.
+*/
+static void print_line(PlanLine *line, FILE *log) {
+    char error_msg[MAX_STR_LEN];
+
+    if (!log)
+        return;
+    if (line->kind == PLAN_MESSAGE)
+        fputs(line->message, log);
+    else if (line->kind == PLAN_SINGLE) {
+        if (set_error_msg(line->exit_code, error_msg))
+            fprintf(log, "Error with file %s:%s\n", line->argv[3], error_msg);
+        else
+            fprintf(log, "File %s %s\n", line->argv[3], line->encr_flag ? "encrypted" : "decrypted");
+    }
+}
+
+/**
+* @brief Plan cije se linije sortiraju (qsort ne prosledjuje dodatni argument).
+*/
+static Plan *sort_plan;
+
+/**
+* @brief Poredjenje linija za redosled izvrsavanja: po fazi, pa po kljucu, pa po redosledu u fajlu.
+*/
+static int compare_lines(const void *a, const void *b) {
+    PlanLine *x = &sort_plan->lines[*(const int*)a], *y = &sort_plan->lines[*(const int*)b];
+
+    if (x->stage != y->stage)
+        return x->stage - y->stage;
+    if (x->key_index != y->key_index)
+        return x->key_index - y->key_index;
+    return *(const int*)a - *(const int*)b;
+}
+
+/*********************** EXTERNAL FUNCTIONS ***********************/
+void plan_run(FILE *f, List *key_list, FILE *log, BatchOptions *opts, PlanCommand run_other, void *arg) {
+    BatchOptions default_opts;
+    Plan plan;
+    PlanPath *p, *next;
+    ThreadPool *pool;
+    char text[PLAN_LINE_MAX];
+    char *done;
+    int *order, n_order = 0, printed = 0, number = 0, i, j, jobs;
+    size_t len;
+
+    if (!opts) {
+        init_batch_options(&default_opts);
+        opts = &default_opts;
+    }
+
+    memset(&plan, 0, sizeof(plan));
+    plan.in_place = opts->in_place;
+    while (fgets(text, sizeof(text), f)) {
+        len = strlen(text);
+        while (len && (text[len - 1] == '\n' || text[len - 1] == '\r'))
+            text[--len] = '\0';
+
+        if (plan.n_lines == plan.cap_lines) {
+            plan.cap_lines = plan.cap_lines ? plan.cap_lines * 2 : 64;
+            plan.lines = (PlanLine*) realloc(plan.lines, sizeof(PlanLine) * plan.cap_lines);
+            ALLOC_CHECK(plan.lines);
+        }
+        number++;
+        if (!parse_plan_line(&plan, &plan.lines[plan.n_lines], text, key_list)) {
+            plan.lines[plan.n_lines].number = number;
+            plan.n_lines++;
+        }
+    }
+
+    for (plan.table_len = 16; plan.table_len < 2 * plan.n_lines; plan.table_len *= 2)
+        ;
+    plan.table = (PlanPath**) calloc(plan.table_len, sizeof(PlanPath*));
+    order = (int*) malloc(sizeof(int) * (plan.n_lines + 1));
+    done = (char*) calloc(plan.n_lines + 1, 1);
+    ALLOC_CHECK(plan.table);
+    ALLOC_CHECK(order);
+    ALLOC_CHECK(done);
+
+    for (i = 0; i < plan.n_lines; i++) {
+        if (plan.lines[i].kind == PLAN_SINGLE)
+            plan_single(&plan, i);
+        else if (plan.lines[i].kind == PLAN_OTHER)
+            plan_barrier(&plan, &plan.lines[i]);
+
+        if (plan.lines[i].kind == PLAN_MESSAGE)
+            done[i] = 1;
+        else
+            order[n_order++] = i;
+    }
+
+    sort_plan = &plan;
+    qsort(order, n_order, sizeof(int), compare_lines);
+
+    jobs = opts->jobs > 0 ? opts->jobs : pool_cpu_count();
+    pool = pool_create(jobs, jobs * BATCH_WINDOW_PER_JOB);
+
+    for (i = 0; i < n_order; i = j) {
+        PlanLine *line = &plan.lines[order[i]];
+
+        if (line->kind == PLAN_OTHER) {
+            /// sve ranije linije su zavrsene, pa njihovi ishodi idu u log pre ishoda ove komande
+            for (; printed < order[i]; printed++)
+                print_line(&plan.lines[printed], log);
+            if (log)
+                fflush(log);
+            run_other(line->argc - 1, line->argv + 1, arg);
+            done[order[i]] = 1;
+            j = i + 1;
+        }
+        else {
+            for (j = i; j < n_order && plan.lines[order[j]].stage == line->stage; j++) {
+                plan.lines[order[j]].pkey = plan.keys[plan.lines[order[j]].key_index];
+                pool_submit(pool, run_single, &plan.lines[order[j]]);
+            }
+            pool_wait(pool);
+            for (; i < j; i++)
+                done[order[i]] = 1;
+        }
+
+        for (; printed < plan.n_lines && done[printed]; printed++)
+            print_line(&plan.lines[printed], log);
+    }
+    for (; printed < plan.n_lines; printed++)
+        print_line(&plan.lines[printed], log);
+
+    pool_destroy(pool, NULL);
+
+    for (i = 0; i < plan.n_lines; i++) {
+        for (j = 0; j < plan.lines[i].argc; j++)
+            free(plan.lines[i].argv[j]);
+        free(plan.lines[i].message);
+    }
+    for (i = 0; i < plan.n_keys; i++) {
+        if (!plan.keys[i]->status)
+            cipherFree(&plan.keys[i]->ctx);
+        free(plan.keys[i]);
+    }
+    for (i = 0; i < plan.table_len; i++)
+        for (p = plan.table[i]; p; p = next) {
+            next = p->next;
+            free(p->path);
+            free(p);
+        }
+    free(plan.table);
+    free(plan.keys);
+    free(plan.lines);
+    free(order);
+    free(done);
+}
@@ -0,0 +1,42 @@
+/**
+* @file
+* @brief Zaglavlje za planiranje i izvrsavanje batch fajla sa komandama (-b).
+* @details Ceo fajl se prvo procita i rasclani. Komande za jedan fajl (-e/-d) se rasporedjuju u faze:
+* komanda ide u prvu fazu posle svih ranijih komandi sa kojima deli fajl (cita izlaz ranije komande
+* ili pise u fajl koji ranija komanda cita), pa se komande iste faze izvrsavaju paralelno. Za svaki
+* kljuc se kontekst algoritma pravi samo jednom, a komande jedne faze se zadaju grupisane po kljucu.
+* Dve enkripcije u isti izlaz su konflikt: kasnija se ne izvrsava i prijavljuje se greska.
+* Komande za vise fajlova (-[e/d][m/r/t]) imaju svoju fazu, posle svih ranijih komandi i pre svih kasnijih.
+* Ishod svake linije se ispisuje u log redosledom linija.
+*/
+
+#ifndef _PLAN_H
+#define _PLAN_H
+
+#include "list.h"
+#include "batch.h"
+#include <stdio.h>
+
+/**
+* @brief Maksimalan broj argumenata u jednoj liniji (naziv programa, komanda, kljuc, putanja).
+*/
+#define PLAN_MAX_ARGS 4
+
+/**
+* @brief Typedef pokazivaca na funkciju koja izvrsava komandu koju planer ne izvrsava sam
+* (komande za vise fajlova). Argumenti ne ukljucuju naziv programa.
+*/
+typedef void (*PlanCommand)(int argc, char *argv[], void *arg);
+
+/**
+* @brief Funkcija koja cita batch fajl, pravi plan i izvrsava ga.
+* @param[in] f Otvoren batch fajl
+* @param[in] key_list Pokazivac na listu ucitanih kljuceva
+* @param[out] log Fajl u koji se ispisuju ishodi linija
+* @param[in] opts Opcije (broj radnih niti), NULL za podrazumevane
+* @param[in] run_other Funkcija koja izvrsava ostale komande
+* @param[in] arg Argument koji se prosledjuje funkciji run_other
+*/
+void plan_run(FILE *f, List *key_list, FILE *log, BatchOptions *opts, PlanCommand run_other, void *arg);
+
+#endif // _PLAN_H
@@ -0,0 +1,334 @@
+/**
+* @file
+* @brief Funkcije za rad sa skupom radnih niti (thread pool) koji se koristi prilikom
+* enkripcije/dekripcije vise fajlova.
+* @details Radna nit trazi posao ovim redom: kraj sopstvenog reda (najnoviji zadatak, dobar za
+* delove fajla koje je upravo zadala), zajednicki ulazni red sa zadacima zadatim spolja (po redu
+* zadavanja) i na kraju pocetak reda neke druge niti (kradja). Tek kada nigde nema posla nit spava.
+*/
+
+#include "pool.h"
+#include "global.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+* @brief Pocetni kapacitet reda zadataka (mora biti stepen dvojke).
+*/
+#define DEQUE_INIT_CAP 64
+
+/**
+* @brief Red zadataka sa dva kraja. Vlasnik radi sa krajem (bottom), ostali kradu sa pocetka (top).
+*/
+typedef struct Deque {
+    Task *tasks;
+    long cap;
+    long top, bottom;
+    pthread_mutex_t lock;
+} Deque;
+
+/**
+* @brief Stanje jedne radne niti.
+*/
+typedef struct Worker {
+    struct ThreadPool *pool;
+    pthread_t thread;
+    Deque deque;
+    long tasks, steals;
+    double idle_sec;
+    unsigned seed;
+} Worker;
+
+struct ThreadPool {
+    int n_workers;
+    Worker *workers;
+    Deque inject;
+
+    long max_pending;
+    atomic_long queued;
+    atomic_long pending;
+    atomic_int sleeping;
+    atomic_int blocked;
+    int quit;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work, done;
+};
+
+/**
+* @brief Radna nit koja izvrsava tekuci kod, NULL ako to nije radna nit.
+*/
+static __thread Worker *current_worker = NULL;
+
+/*********************** INTERNAL FUNCTIONS ***********************/
+/**
+* @brief Funkcija koja vraca trenutno vreme u sekundama.
+*/
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void deque_init(Deque *d) {
+    d->cap = DEQUE_INIT_CAP;
+    d->top = d->bottom = 0;
+    d->tasks = (Task*) malloc(sizeof(Task) * d->cap);
+    ALLOC_CHECK(d->tasks);
+    pthread_mutex_init(&d->lock, NULL);
+}
+
+static void deque_free(Deque *d) {
+    pthread_mutex_destroy(&d->lock);
+    free(d->tasks);
+}
+
+/**
+* @brief Funkcija koja dodaje zadatak na kraj reda i po potrebi udvostrucuje kapacitet.
+*/
+static void deque_push(Deque *d, Task task) {
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom - d->top == d->cap) {
+        Task *tasks = (Task*) malloc(sizeof(Task) * d->cap * 2);
+        long i;
+        ALLOC_CHECK(tasks);
+        for (i = d->top; i < d->bottom; i++)
+            tasks[i & (d->cap * 2 - 1)] = d->tasks[i & (d->cap - 1)];
+        free(d->tasks);
+        d->tasks = tasks;
+        d->cap *= 2;
+    }
+    d->tasks[d->bottom & (d->cap - 1)] = task;
+    d->bottom++;
+    pthread_mutex_unlock(&d->lock);
+}
+
+/**
+* @brief Funkcija koja uzima zadatak sa kraja reda (najnoviji).
+* @return 1 ukoliko je zadatak uzet, 0 ukoliko je red prazan
+*/
+static int deque_pop(Deque *d, Task *task) {
+    int ok = 0;
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom > d->top) {
+        d->bottom--;
+        *task = d->tasks[d->bottom & (d->cap - 1)];
+        ok = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+/**
+* @brief Funkcija koja uzima zadatak sa pocetka reda (najstariji).
+* @return 1 ukoliko je zadatak uzet, 0 ukoliko je red prazan
+*/
+static int deque_steal(Deque *d, Task *task) {
+    int ok = 0;
+    pthread_mutex_lock(&d->lock);
+    if (d->bottom > d->top) {
+        *task = d->tasks[d->top & (d->cap - 1)];
+        d->top++;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+/**
+* @brief Funkcija koja pronalazi sledeci zadatak za radnu nit.
+* @return 1 ukoliko je zadatak pronadjen, 0 u suprotnom
+*/
+static int find_task(Worker *w, Task *task) {
+    ThreadPool *pool = w->pool;
+    int i, start;
+
+    if (deque_pop(&w->deque, task) || deque_steal(&pool->inject, task))
+        return 1;
+
+    start = rand_r(&w->seed) % pool->n_workers;
+    for (i = 0; i < pool->n_workers; i++) {
+        Worker *victim = &pool->workers[(start + i) % pool->n_workers];
+        if (victim != w && deque_steal(&victim->deque, task)) {
+            w->steals++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+* @brief Funkcija koja se poziva kada se zavrsi jedan zadatak.
+*/
+static void finish_task(ThreadPool *pool) {
+    if (atomic_fetch_sub(&pool->pending, 1) == 1 || atomic_load(&pool->blocked)) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_broadcast(&pool->done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/**
+* @brief Glavna funkcija radne niti.
+* @param[in] arg Pokazivac na Worker
+*/
+static void* worker_main(void *arg) {
+    Worker *w = (Worker*)arg;
+    ThreadPool *pool = w->pool;
+    Task task;
+    double idle_start;
+    int quit;
+
+    current_worker = w;
+    for (;;) {
+        if (find_task(w, &task)) {
+            atomic_fetch_sub(&pool->queued, 1);
+            task.func(task.arg);
+            w->tasks++;
+            finish_task(pool);
+            continue;
+        }
+
+        idle_start = now_sec();
+        pthread_mutex_lock(&pool->lock);
+        atomic_fetch_add(&pool->sleeping, 1);
+        while (!atomic_load(&pool->queued) && !pool->quit)
+            pthread_cond_wait(&pool->work, &pool->lock);
+        atomic_fetch_sub(&pool->sleeping, 1);
+        quit = pool->quit && !atomic_load(&pool->queued);
+        pthread_mutex_unlock(&pool->lock);
+        w->idle_sec += now_sec() - idle_start;
+
+        if (quit)
+            break;
+    }
+    return NULL;
+}
+
+/*********************** EXTERNAL FUNCTIONS ***********************/
+ThreadPool* pool_create(int n_workers, int max_pending) {
+    ThreadPool *pool = (ThreadPool*) calloc(1, sizeof(ThreadPool));
+    int i;
+    ALLOC_CHECK(pool);
+
+    pool->n_workers = n_workers > 1 ? n_workers : 0;
+    if (!pool->n_workers)
+        return pool;
+
+    pool->max_pending = max_pending > 0 ? max_pending : 1;
+    pool->workers = (Worker*) calloc(pool->n_workers, sizeof(Worker));
+    ALLOC_CHECK(pool->workers);
+
+    deque_init(&pool->inject);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (i = 0; i < pool->n_workers; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].seed = i + 1;
+        deque_init(&pool->workers[i].deque);
+    }
+    for (i = 0; i < pool->n_workers; i++)
+        pthread_create(&pool->workers[i].thread, NULL, worker_main, &pool->workers[i]);
+
+    return pool;
+}
+
+void pool_submit(ThreadPool *pool, TaskFunc func, void *arg) {
+    Worker *w = current_worker;
+    Task task;
+
+    if (!pool->n_workers) {
+        func(arg);
+        return;
+    }
+
+    task.func = func;
+    task.arg = arg;
+
+    if (w && w->pool == pool) {
+        atomic_fetch_add(&pool->pending, 1);
+        deque_push(&w->deque, task);
+    }
+    else {
+        if (atomic_load(&pool->pending) >= pool->max_pending) {
+            pthread_mutex_lock(&pool->lock);
+            atomic_fetch_add(&pool->blocked, 1);
+            while (atomic_load(&pool->pending) >= pool->max_pending)
+                pthread_cond_wait(&pool->done, &pool->lock);
+            atomic_fetch_sub(&pool->blocked, 1);
+            pthread_mutex_unlock(&pool->lock);
+        }
+        atomic_fetch_add(&pool->pending, 1);
+        deque_push(&pool->inject, task);
+    }
+
+    atomic_fetch_add(&pool->queued, 1);
+    if (atomic_load(&pool->sleeping)) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_signal(&pool->work);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+void pool_wait(ThreadPool *pool) {
+    if (!pool->n_workers)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    while (atomic_load(&pool->pending))
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int pool_workers(ThreadPool *pool) {
+    return pool->n_workers;
+}
+
+void pool_destroy(ThreadPool *pool, PoolStats *stats) {
+    int i;
+
+    if (stats) {
+        stats->n_workers = pool->n_workers;
+        stats->tasks = stats->steals = 0;
+        stats->idle_sec = 0;
+    }
+
+    if (pool->n_workers) {
+        pool_wait(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->quit = 1;
+        pthread_cond_broadcast(&pool->work);
+        pthread_mutex_unlock(&pool->lock);
+
+        for (i = 0; i < pool->n_workers; i++)
+            pthread_join(pool->workers[i].thread, NULL);
+
+        /* redovi se oslobadjaju tek kada su sve niti zavrsile, jer ih ostale niti jos mogu pretrazivati */
+        for (i = 0; i < pool->n_workers; i++) {
+            deque_free(&pool->workers[i].deque);
+            if (stats) {
+                stats->tasks += pool->workers[i].tasks;
+                stats->steals += pool->workers[i].steals;
+                stats->idle_sec += pool->workers[i].idle_sec;
+            }
+        }
+
+        deque_free(&pool->inject);
+        pthread_mutex_destroy(&pool->lock);
+        pthread_cond_destroy(&pool->work);
+        pthread_cond_destroy(&pool->done);
+        free(pool->workers);
+    }
+    free(pool);
+}
+
+int pool_cpu_count() {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
@@ -0,0 +1,85 @@
+/**
+* @file
+* @brief Zaglavlje za rad sa skupom radnih niti (thread pool) koji se koristi prilikom
+* enkripcije/dekripcije vise fajlova.
+* @details Svaka radna nit ima svoj red zadataka (deque). Nit uzima zadatke sa kraja svog reda,
+* a kada ostane bez posla krade najstariji zadatak sa pocetka reda neke druge niti (work stealing).
+* Zadaci koje zadaje sama radna nit (npr. delovi velikog fajla) idu u njen red, pa ih ostale niti
+* kradu cim ostanu bez posla.
+*/
+
+#ifndef _POOL_H
+#define _POOL_H
+
+/**
+* @brief Typedef pokazivaca na funkciju koju izvrsava radna nit.
+*/
+typedef void (*TaskFunc)(void *arg);
+
+/**
+* @brief Jedan zadatak u redu cekanja.
+*/
+typedef struct Task {
+    TaskFunc func;
+    void *arg;
+} Task;
+
+/**
+* @brief Statistika rada skupa niti.
+*/
+typedef struct PoolStats {
+    int n_workers;
+    long tasks;         /**< Broj izvrsenih zadataka */
+    long steals;        /**< Broj zadataka ukradenih iz tudjeg reda */
+    double idle_sec;    /**< Ukupno vreme koje su niti provele bez posla (u sekundama) */
+} PoolStats;
+
+/**
+* @brief Struktura skupa radnih niti.
+*/
+typedef struct ThreadPool ThreadPool;
+
+/**
+* @brief Funkcija za pravljenje novog skupa radnih niti.
+* @param[in] n_workers Broj radnih niti. Ukoliko je manji od 2, zadaci se izvrsavaju
+* odmah u niti koja ih zadaje i niti se ne prave.
+* @param[in] max_pending Maksimalan broj nezavrsenih zadataka zadatih van skupa niti; pool_submit
+* iz druge niti blokira dok se ne oslobodi mesto. Zadaci koje zadaju same radne niti nisu ograniceni.
+* @return Pokazivac na novi skup niti
+*/
+ThreadPool* pool_create(int n_workers, int max_pending);
+
+/**
+* @brief Funkcija za zadavanje novog zadatka.
+* @param[in] pool Pokazivac na skup niti
+* @param[in] func Funkcija koju treba izvrsiti
+* @param[in] arg Argument koji se prosledjuje funkciji
+*/
+void pool_submit(ThreadPool *pool, TaskFunc func, void *arg);
+
+/**
+* @brief Funkcija koja ceka da se zavrse svi zadati zadaci, ukljucujuci i one koje su zadale radne niti.
+* @param[in] pool Pokazivac na skup niti
+*/
+void pool_wait(ThreadPool *pool);
+
+/**
+* @brief Funkcija koja vraca broj radnih niti (0 ukoliko se zadaci izvrsavaju odmah).
+* @param[in] pool Pokazivac na skup niti
+*/
+int pool_workers(ThreadPool *pool);
+
+/**
+* @brief Funkcija koja ceka da se zavrse svi zadaci, zaustavlja niti i oslobadja skup.
+* @param[in] pool Pokazivac na skup niti
+* @param[out] stats Pokazivac na strukturu u koju se upisuje statistika rada niti, moze biti NULL
+*/
+void pool_destroy(ThreadPool *pool, PoolStats *stats);
+
+/**
+* @brief Funkcija koja vraca broj procesorskih jezgara na sistemu.
+* @return Broj jezgara (najmanje 1)
+*/
+int pool_cpu_count();
+
+#endif // _POOL_H
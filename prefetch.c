@@ -0,0 +1,160 @@
+/**
+* @file
+* @brief Funkcije za predcitavanje sledecih fajlova iz spiska.
+* @details Red je kruzni niz sa apsolutnim rednim brojevima putanja. Putanje sa rednim brojem manjim
+* od issued su predcitane (ili preskocene jer su vec zadate za obradu).
+*/
+
+/// O_NOATIME
+#define _GNU_SOURCE
+#include "prefetch.h"
+#include "global.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+* @brief Velicina kruznog niza.
+*/
+#define PREFETCH_RING_LEN (PREFETCH_MAX_DEPTH + 1)
+
+/**
+* @brief Maksimalna duzina putanje.
+*/
+#define PREFETCH_PATH_MAX 4096
+
+struct Prefetcher {
+    char *ring[PREFETCH_RING_LEN];
+    long head, tail;        /**< Redni broj prve putanje u redu i sledece koja se dodaje */
+    long issued;            /**< Redni broj sledece putanje koju nit treba da predcita */
+    int depth;
+    int hits;
+    int stop;
+    char next[PREFETCH_PATH_MAX];
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+};
+
+/*********************** INTERNAL FUNCTIONS ***********************/
+/**
+* @brief Funkcija koja otvara fajl i trazi od jezgra da ucita njegov pocetak.
+*/
+static void prefetch_file(const char *path) {
+    struct stat st;
+    int fd = -1;
+
+#ifdef O_NOATIME
+    fd = open(path, O_RDONLY | O_NOATIME);
+#endif
+    if (fd < 0 && (fd = open(path, O_RDONLY)) < 0)
+        return;
+#ifdef POSIX_FADV_WILLNEED
+    if (!fstat(fd, &st) && S_ISREG(st.st_mode))
+        posix_fadvise(fd, 0, st.st_size < PREFETCH_FILE_BYTES ? st.st_size : PREFETCH_FILE_BYTES,
+                      POSIX_FADV_WILLNEED);
+#endif
+    close(fd);
+}
+
+/**
+* @brief Glavna funkcija pomocne niti.
+* @param[in] arg Pokazivac na Prefetcher
+*/
+static void* prefetch_main(void *arg) {
+    Prefetcher *prefetch = (Prefetcher*)arg;
+    char path[PREFETCH_PATH_MAX];
+
+    pthread_mutex_lock(&prefetch->lock);
+    while (1) {
+        if (prefetch->issued < prefetch->head)
+            prefetch->issued = prefetch->head;
+        if (prefetch->issued == prefetch->tail) {
+            if (prefetch->stop)
+                break;
+            pthread_cond_wait(&prefetch->wake, &prefetch->lock);
+            continue;
+        }
+
+        strcpy(path, prefetch->ring[prefetch->issued % PREFETCH_RING_LEN]);
+        pthread_mutex_unlock(&prefetch->lock);
+        prefetch_file(path);
+        pthread_mutex_lock(&prefetch->lock);
+        if (prefetch->issued >= prefetch->head)
+            prefetch->issued++;
+    }
+    pthread_mutex_unlock(&prefetch->lock);
+    return NULL;
+}
+
+/*********************** EXTERNAL FUNCTIONS ***********************/
+Prefetcher* prefetch_start(void) {
+    Prefetcher *prefetch = (Prefetcher*) calloc(1, sizeof(Prefetcher));
+    ALLOC_CHECK(prefetch);
+
+    prefetch->depth = PREFETCH_MIN_DEPTH;
+    pthread_mutex_init(&prefetch->lock, NULL);
+    pthread_cond_init(&prefetch->wake, NULL);
+    pthread_create(&prefetch->thread, NULL, prefetch_main, prefetch);
+    return prefetch;
+}
+
+void prefetch_push(Prefetcher *prefetch, const char *path) {
+    char *copy = strdup(path);
+    ALLOC_CHECK(copy);
+
+    if (strlen(copy) >= PREFETCH_PATH_MAX)
+        copy[PREFETCH_PATH_MAX - 1] = '\0';
+
+    pthread_mutex_lock(&prefetch->lock);
+    prefetch->ring[prefetch->tail++ % PREFETCH_RING_LEN] = copy;
+    pthread_cond_signal(&prefetch->wake);
+    pthread_mutex_unlock(&prefetch->lock);
+}
+
+const char* prefetch_next(Prefetcher *prefetch, int drain) {
+    char *path;
+
+    pthread_mutex_lock(&prefetch->lock);
+    if (prefetch->head == prefetch->tail ||
+        (!drain && prefetch->tail - prefetch->head <= prefetch->depth && prefetch->tail - prefetch->head < PREFETCH_RING_LEN)) {
+        pthread_mutex_unlock(&prefetch->lock);
+        return NULL;
+    }
+
+    /// fajl koji nit jos nije predcitala znaci da je dubina premala za trenutnu brzinu obrade
+    if (!drain) {
+        if (prefetch->head >= prefetch->issued) {
+            prefetch->depth = 2 * prefetch->depth < PREFETCH_MAX_DEPTH ? 2 * prefetch->depth : PREFETCH_MAX_DEPTH;
+            prefetch->hits = 0;
+        }
+        else if (++prefetch->hits == PREFETCH_DECAY_HITS) {
+            prefetch->depth = prefetch->depth > PREFETCH_MIN_DEPTH ? prefetch->depth - 1 : PREFETCH_MIN_DEPTH;
+            prefetch->hits = 0;
+        }
+    }
+
+    path = prefetch->ring[prefetch->head++ % PREFETCH_RING_LEN];
+    pthread_mutex_unlock(&prefetch->lock);
+
+    strcpy(prefetch->next, path);
+    free(path);
+    return prefetch->next;
+}
+
+void prefetch_stop(Prefetcher *prefetch) {
+    pthread_mutex_lock(&prefetch->lock);
+    prefetch->stop = 1;
+    prefetch->head = prefetch->issued = prefetch->tail;
+    pthread_cond_signal(&prefetch->wake);
+    pthread_mutex_unlock(&prefetch->lock);
+    pthread_join(prefetch->thread, NULL);
+
+    pthread_mutex_destroy(&prefetch->lock);
+    pthread_cond_destroy(&prefetch->wake);
+    free(prefetch);
+}
@@ -0,0 +1,70 @@
+/**
+* @file
+* @brief Zaglavlje za predcitavanje sledecih fajlova iz spiska (--prefetch).
+* @details Putanje se prvo stavljaju u red predcitavanja, a za obradu se zadaju tek kada je u redu
+* iza njih jos "dubina" putanja. Pomocna nit u meduvremenu otvara fajlove iz reda, cime se ucitavaju
+* metapodaci (direktorijum, inode), i za pocetak svakog fajla poziva posix_fadvise(WILLNEED), pa
+* jezgro cita podatke dok se prethodni fajlovi jos enkriptuju.
+*
+* Dubina se prilagodjava brzini obrade: kada fajl dodje na red za obradu pre nego sto je predcitan,
+* dubina se udvostrucava (do PREFETCH_MAX_DEPTH), a posle PREFETCH_DECAY_HITS uzastopnih pogodaka
+* smanjuje se za jedan (do PREFETCH_MIN_DEPTH), tako da se kes ne puni vise nego sto je potrebno.
+*/
+
+#ifndef _PREFETCH_H
+#define _PREFETCH_H
+
+/**
+* @brief Najmanja dubina predcitavanja.
+*/
+#define PREFETCH_MIN_DEPTH 2
+
+/**
+* @brief Najveca dubina predcitavanja.
+*/
+#define PREFETCH_MAX_DEPTH 64
+
+/**
+* @brief Broj uzastopnih pogodaka posle kog se dubina smanjuje.
+*/
+#define PREFETCH_DECAY_HITS 32
+
+/**
+* @brief Najveci broj bajtova sa pocetka fajla za koje se trazi predcitavanje.
+*/
+#define PREFETCH_FILE_BYTES (2 * 1024 * 1024)
+
+/**
+* @brief Struktura predcitavanja.
+*/
+typedef struct Prefetcher Prefetcher;
+
+/**
+* @brief Funkcija koja pravi red predcitavanja i pokrece pomocnu nit.
+* @return Pokazivac na predcitavanje
+*/
+Prefetcher* prefetch_start(void);
+
+/**
+* @brief Funkcija koja dodaje putanju u red predcitavanja.
+* @param[in] prefetch Pokazivac na predcitavanje
+* @param[in] path Putanja fajla
+*/
+void prefetch_push(Prefetcher *prefetch, const char *path);
+
+/**
+* @brief Funkcija koja vraca sledecu putanju koju treba zadati za obradu.
+* @param[in] prefetch Pokazivac na predcitavanje
+* @param[in] drain 1 na kraju spiska (vraca se svaka putanja iz reda), 0 inace (samo ukoliko je
+* u redu vise putanja od trenutne dubine)
+* @return Putanja, vazi do sledeceg poziva; NULL ukoliko ne treba nista zadati
+*/
+const char* prefetch_next(Prefetcher *prefetch, int drain);
+
+/**
+* @brief Funkcija koja zaustavlja pomocnu nit i oslobadja predcitavanje.
+* @param[in] prefetch Pokazivac na predcitavanje
+*/
+void prefetch_stop(Prefetcher *prefetch);
+
+#endif // _PREFETCH_H
@@ -6,140 +6,156 @@
 */
 
 #include "process.h"
+#include "batch.h"
 #include "keys.h"
 #include "gui.h"
 #include "encryption.h"
 #include "global.h"
+#include "wildcard.h"
+#include "walker.h"
+#include "layout.h"
+#include "prefetch.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <dirent.h>
-#include <regex.h>
 
 /*********************** INTERNAL FUNCTIONS ***********************/
 /**
-* @brief Funkcija za ispitivanje koji algoritam treba koristiti za zadati kljuc.
-* @param[in] key Kljuc za koji treba pronaci algoritam
-* @return Algoritam koji treba koristiti
+* @brief Funkcija koja iz putanje uklanja naziv postavljanjem '\0' karaktera na odgovarajuce mesto u stringu.
+* @param[in] path Putanja iz koje treba ukloniti naziv fajla
 */
-static Algorithm select_algorithm(Key *key) {
-    Algorithm algo;
-    int aes16_flag = 0, aes24_flag = 0, aes32_flag = 0, des_flag = 0, tdes_flag = 0;
-    int ecb_flag = 0, cbc_flag = 0;
-
-    if (!strcmp(key->type, AES16_STR)) aes16_flag = 1;
-    else if (!strcmp(key->type, AES24_STR)) aes24_flag = 1;
-    else if (!strcmp(key->type, AES32_STR)) aes32_flag = 1;
-    else if (!strcmp(key->type, DES_STR)) des_flag = 1;
-    else tdes_flag = 1;
-
-    if (!strcmp(key->mode, MODE_ECB_STR)) ecb_flag = 1;
-    else cbc_flag = 1;
+static void remove_filename_from_path(char *path) {
+    char *pntr = path + strlen(path) - 1;
+    while (pntr >= path && *pntr != '/')
+        pntr--;
+    *(pntr + 1) = '\0';
+}
 
-    if (aes16_flag) {
-        if (ecb_flag) algo = aes128_ecb;
-        else algo = aes128_cbc;
-    }
-    else if (aes24_flag) {
-        if (ecb_flag) algo = aes192_ecb;
-        else algo = aes192_cbc;
-    }
-    else if (aes32_flag) {
-        if (ecb_flag) algo = aes256_ecb;
-        else algo = aes256_cbc;
-    }
-    else if (des_flag) {
-        if (ecb_flag) algo = des_ecb;
-        else algo = des_cbc;
-    }
-    else {
-        if (ecb_flag) algo = tdes_ecb;
-        else algo = tdes_cbc;
-    }
+/**
+* @brief Spisak fajlova koji se zadaju tek posle redjanja po fizickom polozaju (--physical)
+* i/ili posle predcitavanja (--prefetch).
+*/
+typedef struct FileList {
+    int collect;        /**< 0 ukoliko se fajlovi zadaju odmah */
+    char **paths;
+    long len, cap;
+    Prefetcher *prefetch;   /**< NULL bez predcitavanja */
+} FileList;
 
-    return algo;
+/**
+* @brief Funkcija koja pravi prazan spisak.
+* @param[out] list Pokazivac na spisak
+* @param[in] opts Opcije obrade, moze biti NULL
+*/
+static void list_init(FileList *list, BatchOptions *opts) {
+    memset(list, 0, sizeof(*list));
+    list->collect = opts && opts->physical_order;
+    if (opts && opts->prefetch)
+        list->prefetch = prefetch_start();
 }
 
 /**
-* @brief Funkcija koja zadati obrazac prevodi u obrazac za koji je moguce pozivati funkcije iz zaglavlja regex.h.
-* @param[in] pattern Obrazac koji treba izmeniti
+* @brief Funkcija koja zadaje fajl za obradu, uz predcitavanje tek kada je iza njega u redu dovoljno fajlova.
+* @param[in] run Pokazivac na stanje obrade
+* @param[in] list Pokazivac na spisak
+* @param[in] path Putanja fajla
 */
-static void build_regexp_string(char *pattern) {
-    char *filename_pntr = pattern + strlen(pattern) - 1;
-
-    /// find first char of filename
-    while (filename_pntr >= pattern && *filename_pntr != '/')
-        filename_pntr--;
-    filename_pntr++;
-
-    /// replacing * and ?
-    while (*filename_pntr) {
-        if (*filename_pntr == '*') {
-            memmove((void*)(filename_pntr + MULTICHAR_REGEX_LEN), (const void*)(filename_pntr + 1), strlen(filename_pntr + 1) + 1);
-            strncpy(filename_pntr, MULTICHAR_REGEX, MULTICHAR_REGEX_LEN);
-            filename_pntr += MULTICHAR_REGEX_LEN;
-        }
-        else if (*filename_pntr == '?') {
-            memmove((void*)(filename_pntr + SINGLECHAR_REGEX_LEN), (const void*)(filename_pntr + 1), strlen(filename_pntr + 1) + 1);
-            strncpy(filename_pntr, MULTICHAR_REGEX, SINGLECHAR_REGEX_LEN);
-            filename_pntr += SINGLECHAR_REGEX_LEN;
-        }
-        else if (*filename_pntr == '.') {
-            memmove((void*)(filename_pntr + 3), (const void*)(filename_pntr + 1), strlen(filename_pntr + 1) + 1);
-            strncpy(filename_pntr, "[.]", 3);
-            filename_pntr += 3;
-        }
-        else
-            filename_pntr++;
+static void list_pass(BatchRun *run, FileList *list, const char *path) {
+    const char *next;
+
+    if (!list->prefetch) {
+        batch_submit(run, path, NULL);
+        return;
     }
+
+    prefetch_push(list->prefetch, path);
+    while ((next = prefetch_next(list->prefetch, 0)))
+        batch_submit(run, next, NULL);
 }
 
 /**
-* @brief Funkcija koja iz putanje uklanja naziv postavljanjem '\0' karaktera na odgovarajuce mesto u stringu.
-* @param[in] path Putanja iz koje treba ukloniti naziv fajla
+* @brief Funkcija koja zadaje fajl za obradu ili ga dodaje u spisak.
+* @param[in] run Pokazivac na stanje obrade
+* @param[in] list Pokazivac na spisak
+* @param[in] path Putanja fajla
 */
-static void remove_filename_from_path(char *path) {
-    char *pntr = path + strlen(path) - 1;
-    while (pntr >= path && *pntr != '/')
-        pntr--;
-    *(pntr + 1) = '\0';
+static void list_submit(BatchRun *run, FileList *list, const char *path) {
+    if (!list->collect) {
+        list_pass(run, list, path);
+        return;
+    }
+
+    if (list->len == list->cap) {
+        list->cap = list->cap ? 2 * list->cap : 1024;
+        list->paths = (char**) realloc(list->paths, list->cap * sizeof(char*));
+        ALLOC_CHECK(list->paths);
+    }
+    list->paths[list->len] = strdup(path);
+    ALLOC_CHECK(list->paths[list->len]);
+    list->len++;
 }
 
 /**
-* @brief Funkcija koja u okviru zadate putanje pronalazi mesto na kome pocinje naziv fajla.
-* @param[in] file_path Putanja do fajla
-* @return Pokazivac na karakter gde pocinje naziv fajla
+* @brief Funkcija koja uredjuje spisak po fizickom polozaju fajlova, zadaje sve fajlove (i one iz reda
+* predcitavanja) i oslobadja spisak.
+* @param[in] run Pokazivac na stanje obrade
+* @param[in] list Pokazivac na spisak
 */
-static char* get_filename_from_path(char *file_path) {
-    char *pntr;
-    char *last_slash = file_path;
-
-    for (pntr = file_path; *pntr; pntr++)
-        if (*pntr == '/')
-            last_slash = pntr;
-
-    return last_slash == file_path ? file_path : last_slash + 1;
+static void list_flush(BatchRun *run, FileList *list) {
+    const char *next;
+    long i;
+
+    layout_sort(list->paths, list->len);
+    for (i = 0; i < list->len; i++) {
+        list_pass(run, list, list->paths[i]);
+        free(list->paths[i]);
+    }
+    free(list->paths);
+    list->paths = NULL;
+    list->len = list->cap = 0;
+
+    if (list->prefetch) {
+        while ((next = prefetch_next(list->prefetch, 1)))
+            batch_submit(run, next, NULL);
+        prefetch_stop(list->prefetch);
+        list->prefetch = NULL;
+    }
 }
 
 /**
-* @brief Funkcija koja vrsi pripremu za enkripciju/dekripciju vise fajlova pomocu regularnog izraza.
-* @param[in] file_path Putanja do fajla koji treba enkriptovati
+* @brief Funkcija koja enkriptuje/dekriptuje sve fajlove iz direktorijuma ciji naziv odgovara obrascu.
+* @details Direktorijum se cita samo jednom i svaki pronadjeni fajl se odmah zadaje za obradu (uz
+* --physical tek posle redjanja po polozaju na disku, uz --prefetch posle predcitavanja). Tip fajla
+* se uzima iz d_type, a fstatat u odnosu na otvoreni direktorijum se poziva samo kada tip nije poznat.
+* @param[in] file_path Putanja do direktorijuma sa obrascem na mestu naziva fajla
+* @param[in] key Pokazivac na kljuc koji treba koristiti
+* @param[in] encr_flag 1 za enkripciju, 0 za dekripciju
 * @param[out] error_msg String u koji ce biti upisana poruka o gresci
+* @param[out] log Pokazivac na fajl u koji treba ispisivati poruke o ishodu obrade svakog fajla
+* @param[in] opts Opcije obrade, NULL za podrazumevane
 * @return 0 ako nije doslo do greske, 1 u suprotnom
 */
-static int regex_preprocess(char *file_path, char *error_msg) {
-    struct re_pattern_buffer pattern_buf;
-    char regex_pattern[MAX_STR_LEN];
+static int process_regex_files(char *file_path, Key *key, int encr_flag, char *error_msg, FILE *log, BatchOptions *opts) {
+    Wildcard pattern;
     DIR *dir;
     struct dirent *entry;
     struct stat stats;
-    char stat_str[MAX_STR_LEN];
-    FILE *out_file = fopen(REGEX_TMP_FILE, "w");
-
-    /// getting pattern part from path
-    strcpy(regex_pattern, get_filename_from_path(file_path));
+    char path[MAX_STR_LEN];
+    size_t dir_len;
+    int is_reg;
+    BatchRun *run;
+    FileList list;
+
+    /// compiling pattern from filename part of path
+    if (wildcard_compile(&pattern, get_filename_from_path(file_path), WILDCARD_ALNUM)) {
+        strcpy(error_msg, "Invalid file pattern!");
+        return 1;
+    }
 
     /// finding directory
     remove_filename_from_path(file_path);
@@ -149,97 +165,240 @@ static int regex_preprocess(char *file_path, char *error_msg) {
     ///open directory
     dir = opendir(file_path);
     if (!dir) {
+        wildcard_free(&pattern);
         strcpy(error_msg, "Directory not found!");
         return 1;
     }
 
-    /// compiling pattern
-    re_syntax_options = RE_INTERVALS | RE_CHAR_CLASSES | RE_CONTEXT_INDEP_OPS;
-    build_regexp_string(regex_pattern);
-    pattern_buf.translate = pattern_buf.fastmap = pattern_buf.buffer = pattern_buf.allocated = 0;
-    re_compile_pattern(regex_pattern, strlen(regex_pattern), &pattern_buf);
+    strcpy(path, file_path);
+    dir_len = strlen(path);
 
     /// going through directory entries
-    while (entry = readdir(dir)) {
-        strcpy(stat_str, file_path);
-        strcat(stat_str, entry->d_name);
-
-        /// only files are being compared to regex
-        stat(stat_str, &stats);
-        if (S_ISREG(stats.st_mode) && re_match(&pattern_buf, entry->d_name, strlen(entry->d_name), 0, 0) == strlen(entry->d_name) && out_file)
-            fprintf(out_file, "%s\n", stat_str);
+    run = batch_begin(key, encr_flag, log, opts);
+    list_init(&list, opts);
+    while ((entry = readdir(dir))) {
+        if (!wildcard_match(&pattern, entry->d_name) || dir_len + strlen(entry->d_name) >= MAX_STR_LEN)
+            continue;
+
+        /// only regular files are processed
+#ifdef _DIRENT_HAVE_D_TYPE
+        if (entry->d_type != DT_UNKNOWN && entry->d_type != DT_LNK)
+            is_reg = entry->d_type == DT_REG;
+        else
+#endif
+            is_reg = !fstatat(dirfd(dir), entry->d_name, &stats, 0) && S_ISREG(stats.st_mode);
+
+        if (is_reg) {
+            strcpy(path + dir_len, entry->d_name);
+            list_submit(run, &list, path);
+        }
     }
+    list_flush(run, &list);
+    batch_end(run);
+
     closedir(dir);
-    fclose(out_file);
+    wildcard_free(&pattern);
+    return 0;
+}
+
+/**
+* @brief Stanje obrade stabla direktorijuma.
+*/
+typedef struct TreeRun {
+    BatchRun *batch;
+    int encr_flag;
+    const char *out_root;
+} TreeRun;
+
+/**
+* @brief Funkcija koja se poziva za svaki direktorijum i fajl pronadjen u stablu. Fajl se odmah zadaje
+* za obradu. Ukoliko je zadat izlazni koren, u njemu se pravi isti direktorijum, enkriptovani fajl dobija
+* istu relativnu putanju sa .dat ekstenzijom, a dekriptovani fajl originalno ime u istom direktorijumu.
+* @return 0 ako direktorijum treba obici, 1 ako ga treba preskociti
+*/
+static int visit_tree_entry(void *arg, const char *path, const char *rel, int is_dir) {
+    TreeRun *tree = (TreeRun*)arg;
+    char out[BATCH_PATH_MAX];
+    int len;
+
+    if (!tree->out_root) {
+        if (!is_dir)
+            batch_submit(tree->batch, path, NULL);
+        return 0;
+    }
+
+    if (is_dir) {
+        len = snprintf(out, sizeof(out), "%s/%s", tree->out_root, rel);
+        return len < 0 || (size_t)len >= sizeof(out) || (mkdir(out, 0777) && errno != EEXIST);
+    }
+
+    if (tree->encr_flag)
+        len = snprintf(out, sizeof(out), "%s/%s.dat", tree->out_root, rel);
+    else
+        len = snprintf(out, sizeof(out), "%s/%.*s", tree->out_root,
+                       (int)(get_filename_from_path((char*)rel) - rel), rel);
+
+    if (len >= 0 && (size_t)len < sizeof(out))
+        batch_submit(tree->batch, path, out);
     return 0;
 }
 
+/**
+* @brief Funkcija koja enkriptuje/dekriptuje sve fajlove u stablu direktorijuma.
+* @details Stablo obilazi vise niti (walker.h) i svaki pronadjeni fajl se odmah zadaje skupu radnih niti,
+* tako da se obilazak i enkripcija odvijaju istovremeno. Ukoliko za dekripciju nije zadat nijedan obrazac
+* za ukljucivanje, obradjuju se samo fajlovi sa .dat ekstenzijom. Prilikom enkripcije bez izlaznog korena
+* .dat fajlovi se preskacu, jer se novi .dat fajlovi pojavljuju u direktorijumima koji se jos citaju.
+* @param[in] dir_path Koren stabla
+* @param[in] key Pokazivac na kljuc koji treba koristiti
+* @param[in] encr_flag 1 za enkripciju, 0 za dekripciju
+* @param[out] error_msg String u koji ce biti upisana poruka o gresci
+* @param[out] log Pokazivac na fajl u koji treba ispisivati poruke o ishodu obrade svakog fajla
+* @param[in] opts Opcije obrade (obrasci i izlazni koren), NULL za podrazumevane
+* @return 0 ako nije doslo do greske, 1 u suprotnom
+*/
+static int process_tree_files(char *dir_path, Key *key, int encr_flag, char *error_msg, FILE *log, BatchOptions *opts) {
+    BatchOptions default_opts;
+    WalkOptions walk_opts;
+    TreeRun tree;
+    int i, exit_code;
+
+    if (!opts) {
+        init_batch_options(&default_opts);
+        opts = &default_opts;
+    }
+
+    memset(&walk_opts, 0, sizeof(walk_opts));
+    walk_opts.threads = opts->jobs > 0 ? opts->jobs : WALK_MAX_THREADS;
+    walk_opts.n_include = opts->n_include;
+    walk_opts.n_exclude = opts->n_exclude;
+    for (i = 0; i < opts->n_include; i++)
+        walk_opts.include[i] = opts->include[i];
+    for (i = 0; i < opts->n_exclude; i++)
+        walk_opts.exclude[i] = opts->exclude[i];
+    if (!encr_flag && !walk_opts.n_include)
+        walk_opts.include[walk_opts.n_include++] = "*.dat";
+    /// izlazi upisani pored ulaza mogu da se pojave u direktorijumima koji se jos citaju
+    if (encr_flag && !opts->out_root && walk_opts.n_exclude < WALK_MAX_GLOBS)
+        walk_opts.exclude[walk_opts.n_exclude++] = "*.dat";
+    walk_opts.skip_dir = opts->out_root;
+
+    tree.encr_flag = encr_flag;
+    tree.out_root = opts->out_root;
+    tree.batch = batch_begin(key, encr_flag, log, opts);
+    exit_code = walk_tree(dir_path, &walk_opts, visit_tree_entry, &tree);
+    batch_end(tree.batch);
+
+    if (exit_code == FILE_ERR)
+        strcpy(error_msg, "Directory not found!");
+    else if (exit_code)
+        strcpy(error_msg, "Invalid file pattern!");
+    return exit_code != 0;
+}
+
 /*********************** EXTERNAL FUNCTIONS ***********************/
+Algorithm select_algorithm(Key *key) {
+    Algorithm algo;
+    int aes16_flag = 0, aes24_flag = 0, aes32_flag = 0, des_flag = 0, tdes_flag = 0;
+    int ecb_flag = 0, cbc_flag = 0;
+
+    if (!strcmp(key->type, AES16_STR)) aes16_flag = 1;
+    else if (!strcmp(key->type, AES24_STR)) aes24_flag = 1;
+    else if (!strcmp(key->type, AES32_STR)) aes32_flag = 1;
+    else if (!strcmp(key->type, DES_STR)) des_flag = 1;
+    else tdes_flag = 1;
+
+    if (!strcmp(key->mode, MODE_ECB_STR)) ecb_flag = 1;
+    else cbc_flag = 1;
+
+    if (aes16_flag) {
+        if (ecb_flag) algo = aes128_ecb;
+        else algo = aes128_cbc;
+    }
+    else if (aes24_flag) {
+        if (ecb_flag) algo = aes192_ecb;
+        else algo = aes192_cbc;
+    }
+    else if (aes32_flag) {
+        if (ecb_flag) algo = aes256_ecb;
+        else algo = aes256_cbc;
+    }
+    else if (des_flag) {
+        if (ecb_flag) algo = des_ecb;
+        else algo = des_cbc;
+    }
+    else {
+        if (ecb_flag) algo = tdes_ecb;
+        else algo = tdes_cbc;
+    }
+
+    return algo;
+}
+
+int set_error_msg(int exit_code, char *error_msg) {
+    switch(exit_code) {
+    case 0:
+        error_msg[0] = '\0';
+        break;
+    case ALLOC_ERR:
+        strcpy(error_msg, "Bad allocation");
+        break;
+    case FILE_ERR:
+        strcpy(error_msg, "Unable to open file");
+        break;
+    case CRC_MISMATCH:
+        strcpy(error_msg, "Decryption unsuccessful");
+        break;
+    case UNKNOWN_ALG:
+        strcpy(error_msg, "Unknown encryption algorithm");
+        break;
+    case IO_ERR:
+        strcpy(error_msg, "Read/write error");
+        break;
+    }
+    return exit_code;
+}
+
 int encrypt_file(char *file_path, Key *key, char *error_msg) {
     Algorithm algo = select_algorithm(key);
     int exit_code = encryptFile(file_path, (key->key)[0], (key->key)[1], (key->key)[2], algo);
 
-    if (exit_code) {
-        switch(exit_code) {
-        case ALLOC_ERR:
-            strcpy(error_msg, "Bad allocation");
-            break;
-        case FILE_ERR:
-            strcpy(error_msg, "Unable to open file");
-            break;
-        case UNKNOWN_ALG:
-            strcpy(error_msg, "Unknown encryption algorithm");
-            break;
-        }
-
-        return exit_code;
-    }
-    error_msg[0] = '\0';
-    return 0;
+    return set_error_msg(exit_code, error_msg);
 }
 
 int decrypt_file(char *file_path, Key *key, char *error_msg) {
     Algorithm algo = select_algorithm(key);
     int exit_code = decryptFile(file_path, (key->key)[0], (key->key)[1], (key->key)[2], algo);
 
-    if (exit_code) {
-        switch(exit_code) {
-        case ALLOC_ERR:
-            strcpy(error_msg, "Bad allocation");
-            break;
-        case FILE_ERR:
-            strcpy(error_msg, "Unable to open file");
-            break;
-        case CRC_MISMATCH:
-            strcpy(error_msg, "Decryption unsuccessful");
-            break;
-        case UNKNOWN_ALG:
-            strcpy(error_msg, "Unknown encryption algorithm");
-            break;
-        }
+    return set_error_msg(exit_code, error_msg);
+}
 
-        return exit_code;
-    }
-    error_msg[0] = '\0';
-    return 0;
+int encrypt_file_in_place(char *file_path, Key *key, char *error_msg) {
+    Algorithm algo = select_algorithm(key);
+    int exit_code = encryptFileInPlace(file_path, (key->key)[0], (key->key)[1], (key->key)[2], algo);
+
+    return set_error_msg(exit_code, error_msg);
+}
+
+int decrypt_file_in_place(char *file_path, Key *key, char *error_msg) {
+    Algorithm algo = select_algorithm(key);
+    int exit_code = decryptFileInPlace(file_path, (key->key)[0], (key->key)[1], (key->key)[2], algo);
+
+    return set_error_msg(exit_code, error_msg);
 }
 
-int encrypt_more_files(char *file_path, Key *key, FILE *log) {
+int encrypt_more_files(char *file_path, Key *key, FILE *log, BatchOptions *opts) {
     char file[MAX_STR_LEN];
-    char error_msg[MAX_STR_LEN];
     FILE *f = fopen(file_path, "r");
+    FileList list;
 
     if (f) {
-        while (fscanf(f, "%s", file) != EOF) {
-            if (encrypt_file(file, key, error_msg)) {
-                if (log)
-                    fprintf(log, "Error with file %s:%s\n", file, error_msg);
-            }
-            else {
-                if (log)
-                    fprintf(log, "File %s encrypted\n", file);
-            }
-        }
+        BatchRun *run = batch_begin(key, 1, log, opts);
+        list_init(&list, opts);
+        while (fscanf(f, "%s", file) != EOF)
+            list_submit(run, &list, file);
+        list_flush(run, &list);
+        batch_end(run);
         fclose(f);
         return 0;
     }
@@ -247,22 +406,18 @@ int encrypt_more_files(char *file_path, Key *key, FILE *log) {
         return 1;
 }
 
-int decrypt_more_files(char *file_path, Key *key, FILE *log) {
+int decrypt_more_files(char *file_path, Key *key, FILE *log, BatchOptions *opts) {
     char file[MAX_STR_LEN];
-    char error_msg[MAX_STR_LEN];
     FILE *f = fopen(file_path, "r");
+    FileList list;
 
     if (f) {
-        while (fscanf(f, "%s", file) != EOF) {
-            if (decrypt_file(file, key, error_msg)) {
-                if (log)
-                    fprintf(log, "Error with file %s:%s\n", file, error_msg);
-            }
-            else {
-                if (log)
-                    fprintf(log, "File %s decrypted\n", file);
-            }
-        }
+        BatchRun *run = batch_begin(key, 0, log, opts);
+        list_init(&list, opts);
+        while (fscanf(f, "%s", file) != EOF)
+            list_submit(run, &list, file);
+        list_flush(run, &list);
+        batch_end(run);
         fclose(f);
         return 0;
     }
@@ -270,28 +425,18 @@ int decrypt_more_files(char *file_path, Key *key, FILE *log) {
         return 1;
 }
 
-int encrypt_regex_files(char *file_path, Key *key, char *error_msg, FILE *log) {
-    int exit_code = regex_preprocess(file_path, error_msg);
-
-    if (exit_code)
-        return 1;
-
-    if (encrypt_more_files(REGEX_TMP_FILE, key, log)) {
-        strcpy(error_msg, "Unable to open regex temporary file");
-        return 1;
-    }
-    return 0;
+int encrypt_regex_files(char *file_path, Key *key, char *error_msg, FILE *log, BatchOptions *opts) {
+    return process_regex_files(file_path, key, 1, error_msg, log, opts);
 }
 
-int decrypt_regex_files(char *file_path, Key *key, char *error_msg, FILE *log) {
-    int exit_code = regex_preprocess(file_path, error_msg);
+int decrypt_regex_files(char *file_path, Key *key, char *error_msg, FILE *log, BatchOptions *opts) {
+    return process_regex_files(file_path, key, 0, error_msg, log, opts);
+}
 
-    if (exit_code)
-        return 1;
+int encrypt_tree_files(char *dir_path, Key *key, char *error_msg, FILE *log, BatchOptions *opts) {
+    return process_tree_files(dir_path, key, 1, error_msg, log, opts);
+}
 
-    if (decrypt_more_files(REGEX_TMP_FILE, key, log)) {
-        strcpy(error_msg, "Unable to open regex temporary file");
-        return 1;
-    }
-    return 0;
+int decrypt_tree_files(char *dir_path, Key *key, char *error_msg, FILE *log, BatchOptions *opts) {
+    return process_tree_files(dir_path, key, 0, error_msg, log, opts);
 }
@@ -9,30 +9,24 @@
 #define _PROCESS_H
 
 #include "keys.h"
+#include "batch.h"
+#include "encryption.h"
 #include <stdio.h>
 
 /**
-* @brief Pomocni fajl u koji se ispisuju informacije potrebne za izvrsavanje naredbe
-* ukoliko je izabrana opcija enkriptovanja/dekriptovanja preko regularnih izraza.
+* @brief Funkcija za ispitivanje koji algoritam treba koristiti za zadati kljuc.
+* @param[in] key Kljuc za koji treba pronaci algoritam
+* @return Algoritam koji treba koristiti
 */
-#define REGEX_TMP_FILE "regex_tmp.txt"
+Algorithm select_algorithm(Key *key);
 
 /**
-* @brief Regularni izraz koji predstavlja nula ili vise pojavljivanja jednog karaktera.
+* @brief Funkcija koja upisuje poruku o gresci za zadati kod greske iz global.h.
+* @param[in] exit_code Kod greske (0 ako nije bilo greske)
+* @param[out] error_msg String u koji ce biti upisana poruka (prazan string za 0)
+* @return Zadati kod greske
 */
-#define MULTICHAR_REGEX "[a-zA-Z0-9]*"
-/**
-* @brief Duzina string MULTICHAR_REGEX
-*/
-#define MULTICHAR_REGEX_LEN 12
-/**
-* @brief Regularni izraz koji predstavlja tacno jedno pojavljivanje nekog karaktera.
-*/
-#define SINGLECHAR_REGEX "[a-zA-Z0-9]"
-/**
-* @brief Duzina string SINGLECHAR_REGEX
-*/
-#define SINGLECHAR_REGEX_LEN 11
+int set_error_msg(int exit_code, char *error_msg);
 
 /**
 * @brief Funkcija za enkripciju jednog fajla zadatim kljucem.
@@ -52,42 +46,86 @@ int encrypt_file(char *file_path, Key *key, char *error_msg);
 */
 int decrypt_file(char *file_path, Key *key, char *error_msg);
 
+/**
+* @brief Funkcija za enkripciju jednog fajla u mestu (--in-place, io/inplace.h).
+* @param[in] file_path Putanja do fajla koji treba enkriptovati
+* @param[in] key Pokazivac na kljuc koji treba koristiti prilikom enkripcije
+* @param[out] error_msg String u koji ce biti upisana poruka o gresci ukoliko enkripcija nije uspesna
+* @return 0 ako je enkripcija uspesna, broj razlicit od 0 u suprotnom
+*/
+int encrypt_file_in_place(char *file_path, Key *key, char *error_msg);
+
+/**
+* @brief Funkcija za dekripciju jednog fajla u mestu (--in-place, io/inplace.h).
+* @param[in] file_path Putanja do fajla koji treba dekriptovati
+* @param[in] key Pokazivac na kljuc koji treba koristiti prilikom dekripcije
+* @param[out] error_msg String u koji ce biti upisana poruka o gresci ukoliko dekripcija nije uspesna
+* @return 0 ako je dekripcija uspesna, broj razlicit od 0 u suprotnom
+*/
+int decrypt_file_in_place(char *file_path, Key *key, char *error_msg);
+
 /**
 * @brief Funkcija za enkripciju vise fajlova zadatim kljucem.
 * @param[in] file_path Putanja do fajla u kome se nalaze nazivi fajlova koje treba enkriptovati
 * @param[in] key Pokazivac na kljuc koji treba koristiti prilikom enkripcije
 * @param[out] log Pokazivac na fajl u koji treba ispisivati poruke o ishodu enkripcije svakog fajla
+* @param[in] opts Opcije obrade (broj radnih niti), NULL za podrazumevane
 * @return 0 ako je moguce otvoriti zadati fajl (file_path), 1 u suprotnom
 */
-int encrypt_more_files(char *file_path, Key *key, FILE *log);
+int encrypt_more_files(char *file_path, Key *key, FILE *log, BatchOptions *opts);
 
 /**
 * @brief Funkcija za dekripciju vise fajlova zadatim kljucem.
 * @param[in] file_path Putanja do fajla u kome se nalaze nazivi fajlova koje treba dekriptovati
 * @param[in] key Pokazivac na kljuc koji treba koristiti prilikom dekripcije
 * @param[out] log Pokazivac na fajl u koji treba ispisivati poruke o ishodu dekripcije svakog fajla
+* @param[in] opts Opcije obrade (broj radnih niti), NULL za podrazumevane
 * @return 0 ako je moguce otvoriti zadati fajl (file_path), 1 u suprotnom
 */
-int decrypt_more_files(char *file_path, Key *key, FILE *log);
+int decrypt_more_files(char *file_path, Key *key, FILE *log, BatchOptions *opts);
 
 /**
 * @brief Funkcija za enkripciju vise fajlova zadatim kljucem.
-* @param[in] file_path Regularni izraz kojem treba da odgovaraju fajlovi koje treba enkriptovati
+* @param[in] file_path Putanja sa obrascem (wildcard.h) kojem treba da odgovaraju nazivi fajlova koje treba enkriptovati
 * @param[in] key Pokazivac na kljuc koji treba koristiti prilikom enkripcije
 * @param[out] error_msg String u koji ce biti upisana poruka o gresci
 * @param[out] log Pokazivac na fajl u koji treba ispisivati poruke o ishodima enkripcije svakog fajla
+* @param[in] opts Opcije obrade (broj radnih niti), NULL za podrazumevane
 * @return 0 ako nije doslo do greske, 1 u suprotnom
 */
-int encrypt_regex_files(char *file_path, Key *key, char *error_msg, FILE *log);
+int encrypt_regex_files(char *file_path, Key *key, char *error_msg, FILE *log, BatchOptions *opts);
 
 /**
 * @brief Funkcija za dekripciju vise fajlova zadatim kljucem.
-* @param[in] file_path Regularni izraz kojem treba da odgovaraju fajlovi koje treba dekriptovati
+* @param[in] file_path Putanja sa obrascem (wildcard.h) kojem treba da odgovaraju nazivi fajlova koje treba dekriptovati
+* @param[in] key Pokazivac na kljuc koji treba koristiti prilikom dekripcije
+* @param[out] error_msg String u koji ce biti upisana poruka o gresci
+* @param[out] log Pokazivac na fajl u koji treba ispisivati poruke o ishodima dekripcije svakog fajla
+* @param[in] opts Opcije obrade (broj radnih niti), NULL za podrazumevane
+* @return 0 ako nije doslo do greske, 1 u suprotnom
+*/
+int decrypt_regex_files(char *file_path, Key *key, char *error_msg, FILE *log, BatchOptions *opts);
+
+/**
+* @brief Funkcija za enkripciju svih fajlova u stablu direktorijuma zadatim kljucem.
+* @param[in] dir_path Koren stabla
+* @param[in] key Pokazivac na kljuc koji treba koristiti prilikom enkripcije
+* @param[out] error_msg String u koji ce biti upisana poruka o gresci
+* @param[out] log Pokazivac na fajl u koji treba ispisivati poruke o ishodima enkripcije svakog fajla
+* @param[in] opts Opcije obrade (broj niti, obrasci -i/-x, izlazni koren -o), NULL za podrazumevane
+* @return 0 ako nije doslo do greske, 1 u suprotnom
+*/
+int encrypt_tree_files(char *dir_path, Key *key, char *error_msg, FILE *log, BatchOptions *opts);
+
+/**
+* @brief Funkcija za dekripciju svih fajlova u stablu direktorijuma zadatim kljucem.
+* @param[in] dir_path Koren stabla
 * @param[in] key Pokazivac na kljuc koji treba koristiti prilikom dekripcije
 * @param[out] error_msg String u koji ce biti upisana poruka o gresci
 * @param[out] log Pokazivac na fajl u koji treba ispisivati poruke o ishodima dekripcije svakog fajla
+* @param[in] opts Opcije obrade (broj niti, obrasci -i/-x, izlazni koren -o), NULL za podrazumevane
 * @return 0 ako nije doslo do greske, 1 u suprotnom
 */
-int decrypt_regex_files(char *file_path, Key *key, char *error_msg, FILE *log);
+int decrypt_tree_files(char *dir_path, Key *key, char *error_msg, FILE *log, BatchOptions *opts);
 
 #endif // _PROCESS_H
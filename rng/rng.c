@@ -0,0 +1,212 @@
+/**
+* @file
+* @brief Kriptografski siguran generator slucajnih brojeva za IV-ove i nonce-ove.
+* @details Generator je ChaCha20 u brojackom modu sa "fast key erasure" semom: svaki put
+* kada se bafer isprazni generisu se RNG_BLOCKS blokova, prvih 32 bajta postaju novi kljuc,
+* a ostatak se deli pozivaocima. Stanje je lokalno za nit i ponovo se inicijalizuje u detetu posle fork().
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "rng.h"
+
+#ifdef __linux__
+#include <sys/random.h>
+#endif
+
+/**
+* @brief Broj ChaCha20 blokova koji se generisu odjednom.
+*/
+#define RNG_BLOCKS 4
+
+/**
+* @brief Velicina bafera sa izlazom generatora u bajtovima.
+*/
+#define RNG_BUF_LEN (RNG_BLOCKS * 64)
+
+/**
+* @brief Duzina kljuca u bajtovima.
+*/
+#define RNG_KEY_LEN 32
+
+/**
+* @private
+*/
+typedef struct
+{
+    uint32_t key[8];
+    uint64_t nonce;
+    uint8_t  buf[RNG_BUF_LEN];
+    size_t   pos;
+    int      seeded;
+} rngstate_t;
+
+/** @private */
+static __thread rngstate_t rng;
+
+/** @private */
+static pthread_once_t rngAtforkOnce = PTHREAD_ONCE_INIT;
+
+#define ROTL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define QR(a, b, c, d) \
+    a += b; d ^= a; d = ROTL(d, 16); \
+    c += d; b ^= c; b = ROTL(b, 12); \
+    a += b; d ^= a; d = ROTL(d, 8);  \
+    c += d; b ^= c; b = ROTL(b, 7)
+
+/**
+* @brief Funkcija koja racuna jedan ChaCha20 blok.
+* @param[in] key Kljuc od 8 reci.
+* @param[in] counter Brojac bloka.
+* @param[in] nonce Nonce.
+* @param[out] out Izlaz od 64 bajta.
+*/
+static void chachaBlock(const uint32_t key[8], uint32_t counter, uint64_t nonce, uint8_t out[64])
+{
+    uint32_t in[16], x[16];
+    int i;
+
+    in[0] = 0x61707865; in[1] = 0x3320646e; in[2] = 0x79622d32; in[3] = 0x6b206574;
+    for (i = 0; i < 8; i++)
+        in[4 + i] = key[i];
+    in[12] = counter;
+    in[13] = 0;
+    in[14] = (uint32_t) nonce;
+    in[15] = (uint32_t) (nonce >> 32);
+
+    memcpy(x, in, sizeof(x));
+    for (i = 0; i < 10; i++)
+    {
+        QR(x[0], x[4], x[8],  x[12]);
+        QR(x[1], x[5], x[9],  x[13]);
+        QR(x[2], x[6], x[10], x[14]);
+        QR(x[3], x[7], x[11], x[15]);
+        QR(x[0], x[5], x[10], x[15]);
+        QR(x[1], x[6], x[11], x[12]);
+        QR(x[2], x[7], x[8],  x[13]);
+        QR(x[3], x[4], x[9],  x[14]);
+    }
+
+    for (i = 0; i < 16; i++)
+    {
+        uint32_t v = x[i] + in[i];
+        out[4 * i]     = v;
+        out[4 * i + 1] = v >> 8;
+        out[4 * i + 2] = v >> 16;
+        out[4 * i + 3] = v >> 24;
+    }
+}
+
+/**
+* @brief Funkcija koja ucitava seme iz operativnog sistema.
+* @param[out] seed Bafer za seme.
+* @param[in] len Duzina semena.
+* @details Na Linuxu se koristi getrandom(), inace /dev/urandom. Ako ni jedno nije
+* dostupno seme se pravi od vremena, pid-a i adrese steka, sto je samo poslednja odbrana.
+*/
+static void rngSeed(uint8_t *seed, size_t len)
+{
+    size_t got = 0;
+    FILE *urandom;
+
+#ifdef __linux__
+    while (got < len)
+    {
+        ssize_t n = getrandom(seed + got, len - got, 0);
+        if (n <= 0)
+            break;
+        got += n;
+    }
+#endif
+
+    if (got < len && (urandom = fopen("/dev/urandom", "rb")))
+    {
+        got += fread(seed + got, 1, len - got, urandom);
+        fclose(urandom);
+    }
+
+    if (got < len)
+    {
+        uint64_t mix[4];
+        size_t i;
+
+        mix[0] = (uint64_t) time(NULL);
+        mix[1] = (uint64_t) clock();
+        mix[2] = (uint64_t) getpid();
+        mix[3] = (uint64_t) (uintptr_t) &mix;
+        for (i = got; i < len; i++)
+            seed[i] ^= ((uint8_t*) mix)[i % sizeof(mix)];
+    }
+}
+
+/**
+* @brief Funkcija koja se poziva u detetu posle fork(), kako dete ne bi nastavilo
+* isti niz brojeva kao roditelj. U detetu postoji samo nit koja je pozvala fork().
+*/
+static void rngAtforkChild(void)
+{
+    memset(&rng, 0, sizeof(rng));
+}
+
+/**
+* @private
+*/
+static void rngRegisterAtfork(void)
+{
+    pthread_atfork(NULL, NULL, rngAtforkChild);
+}
+
+/**
+* @brief Funkcija koja puni bafer generatora i menja kljuc (fast key erasure).
+*/
+static void rngRefill(void)
+{
+    int i;
+
+    if (!rng.seeded)
+    {
+        pthread_once(&rngAtforkOnce, rngRegisterAtfork);
+        rngSeed((uint8_t*) rng.key, RNG_KEY_LEN);
+        rng.nonce = 0;
+        rng.seeded = 1;
+    }
+
+    for (i = 0; i < RNG_BLOCKS; i++)
+        chachaBlock(rng.key, i, rng.nonce, rng.buf + 64 * i);
+    rng.nonce++;
+
+    memcpy(rng.key, rng.buf, RNG_KEY_LEN);
+    memset(rng.buf, 0, RNG_KEY_LEN);
+    rng.pos = RNG_KEY_LEN;
+}
+
+void rngBytes(uint8_t *buf, size_t len)
+{
+    while (len)
+    {
+        size_t n;
+
+        if (!rng.seeded || rng.pos == RNG_BUF_LEN)
+            rngRefill();
+
+        n = RNG_BUF_LEN - rng.pos;
+        if (n > len)
+            n = len;
+
+        memcpy(buf, rng.buf + rng.pos, n);
+        memset(rng.buf + rng.pos, 0, n);
+        rng.pos += n;
+        buf += n;
+        len -= n;
+    }
+}
+
+uint32_t rngU32(void)
+{
+    uint32_t v;
+    rngBytes((uint8_t*) &v, sizeof(v));
+    return v;
+}
@@ -0,0 +1,28 @@
+/**
+* @file
+* @brief Kriptografski siguran generator slucajnih brojeva za IV-ove i nonce-ove.
+* @details Svaka nit ima sopstveno stanje (ChaCha20 DRBG) koje se jednom inicijalizuje
+* iz getrandom(), tako da generisanje IV-a ne zahteva zakljucavanje i traje svega
+* nekoliko desetina nanosekundi po fajlu.
+*/
+
+#ifndef _RNG_H_
+#define _RNG_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+* @brief Funkcija koja popunjava bafer slucajnim bajtovima.
+* @param[out] buf Bafer koji treba popuniti.
+* @param[in] len Broj bajtova.
+*/
+void     rngBytes(uint8_t *buf, size_t len);
+
+/**
+* @brief Funkcija koja vraca slucajan 32-bitni broj.
+* @return Slucajan broj.
+*/
+uint32_t rngU32(void);
+
+#endif // _RNG_H_
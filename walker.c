@@ -0,0 +1,377 @@
+/**
+* @file
+* @brief Funkcije za paralelni obilazak stabla direktorijuma.
+* @details Direktorijumi koje treba procitati se cuvaju na zajednickom steku (obilazak u dubinu, pa
+* broj direktorijuma koji cekaju ostaje mali). Svaka nit uzima direktorijum sa steka, otvara ga
+* pomocu openat u odnosu na otvoreni koren i cita ga pomocu getdents64; tip fajla se uzima iz
+* d_type, a fstatat se poziva samo kada tip nije poznat ili je u pitanju simbolicki link.
+* Simbolicki linkovi ka direktorijumima se ne prate, pa obilazak ne moze da upadne u petlju.
+*/
+
+#include "walker.h"
+#include "global.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+/**
+* @brief Velicina bafera za citanje stavki direktorijuma u bajtovima.
+*/
+#define WALK_DENTS_LEN (32 * 1024)
+
+/**
+* @brief Direktorijum koji ceka da bude procitan.
+*/
+typedef struct WalkDir {
+    struct WalkDir *next;
+    char *rel;
+} WalkDir;
+
+/**
+* @brief Stanje jednog obilaska.
+*/
+typedef struct Walk {
+    int root_fd;
+    char root[WALK_PATH_MAX];
+    size_t root_len;
+
+    int n_include, n_exclude;
+    Wildcard include[WALK_MAX_GLOBS], exclude[WALK_MAX_GLOBS];
+    int include_rel[WALK_MAX_GLOBS], exclude_rel[WALK_MAX_GLOBS];
+
+    int has_skip;
+    dev_t skip_dev;
+    ino_t skip_ino;
+
+    WalkVisit visit;
+    void *arg;
+
+    WalkDir *stack;
+    int active;     /**< Broj direktorijuma na steku i onih koji se upravo citaju */
+    pthread_mutex_t lock;
+    pthread_cond_t more;
+} Walk;
+
+#ifdef __linux__
+/**
+* @brief Stavka direktorijuma u formatu koji vraca getdents64.
+*/
+struct linux_dirent64 {
+    unsigned long long d_ino;
+    long long d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+#endif
+
+/**
+* @brief Citac stavki jednog direktorijuma.
+*/
+typedef struct DirReader {
+    int fd;
+#ifdef __linux__
+    char buf[WALK_DENTS_LEN];
+    long pos, len;
+#else
+    DIR *dir;
+#endif
+} DirReader;
+
+/*********************** INTERNAL FUNCTIONS ***********************/
+#ifdef __linux__
+static int reader_open(DirReader *r, int fd) {
+    r->fd = fd;
+    r->pos = r->len = 0;
+    return 0;
+}
+
+/**
+* @brief Funkcija koja vraca sledecu stavku direktorijuma.
+* @return 1 ukoliko postoji sledeca stavka, 0 na kraju direktorijuma ili u slucaju greske
+*/
+static int reader_next(DirReader *r, const char **name, unsigned char *type) {
+    struct linux_dirent64 *d;
+
+    if (r->pos >= r->len) {
+        r->len = syscall(SYS_getdents64, r->fd, r->buf, sizeof(r->buf));
+        r->pos = 0;
+        if (r->len <= 0)
+            return 0;
+    }
+
+    d = (struct linux_dirent64*)(r->buf + r->pos);
+    r->pos += d->d_reclen;
+    *name = d->d_name;
+    *type = d->d_type;
+    return 1;
+}
+
+static void reader_close(DirReader *r) {
+    close(r->fd);
+}
+#else
+static int reader_open(DirReader *r, int fd) {
+    r->fd = fd;
+    if (!(r->dir = fdopendir(fd))) {
+        close(fd);
+        return 1;
+    }
+    return 0;
+}
+
+static int reader_next(DirReader *r, const char **name, unsigned char *type) {
+    struct dirent *entry = readdir(r->dir);
+
+    if (!entry)
+        return 0;
+    *name = entry->d_name;
+#ifdef _DIRENT_HAVE_D_TYPE
+    *type = entry->d_type;
+#else
+    *type = DT_UNKNOWN;
+#endif
+    return 1;
+}
+
+static void reader_close(DirReader *r) {
+    closedir(r->dir);
+}
+#endif
+
+/**
+* @brief Funkcija koja proverava da li fajl odgovara nekom od obrazaca.
+*/
+static int match_any(Wildcard *globs, int *rel_flags, int n, const char *rel, const char *name) {
+    int i;
+    for (i = 0; i < n; i++)
+        if (wildcard_match(&globs[i], rel_flags[i] ? rel : name))
+            return 1;
+    return 0;
+}
+
+/**
+* @brief Funkcija koja prevodi obrasce iz opcija.
+* @return 0 ako su svi obrasci ispravni, 1 u suprotnom
+*/
+static int compile_globs(char **patterns, int n, Wildcard *globs, int *rel_flags) {
+    int i;
+
+    for (i = 0; i < n; i++) {
+        rel_flags[i] = strchr(patterns[i], '/') != NULL;
+        if (wildcard_compile(&globs[i], patterns[i], rel_flags[i] ? WILDCARD_PATH : 0)) {
+            while (i--)
+                wildcard_free(&globs[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+* @brief Funkcija koja dodaje direktorijum na stek.
+*/
+static void push_dir(Walk *walk, const char *rel) {
+    WalkDir *dir = (WalkDir*) malloc(sizeof(WalkDir));
+    ALLOC_CHECK(dir);
+    dir->rel = strdup(rel);
+    ALLOC_CHECK(dir->rel);
+
+    pthread_mutex_lock(&walk->lock);
+    dir->next = walk->stack;
+    walk->stack = dir;
+    walk->active++;
+    pthread_cond_signal(&walk->more);
+    pthread_mutex_unlock(&walk->lock);
+}
+
+/**
+* @brief Funkcija koja cita jedan direktorijum, prosledjuje fajlove i dodaje poddirektorijume na stek.
+* @param[in] walk Pokazivac na stanje obilaska
+* @param[in] rel Putanja direktorijuma u odnosu na koren
+*/
+static void read_dir(Walk *walk, const char *rel) {
+    DirReader *reader;
+    struct stat st;
+    const char *name;
+    unsigned char type;
+    char path[WALK_PATH_MAX], *child;
+    size_t rel_len = strlen(rel), name_len;
+    int fd, is_dir;
+
+    fd = openat(walk->root_fd, rel[0] ? rel : ".", O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0)
+        return;
+
+    if (walk->has_skip && !fstat(fd, &st) && st.st_dev == walk->skip_dev && st.st_ino == walk->skip_ino) {
+        close(fd);
+        return;
+    }
+
+    reader = (DirReader*) malloc(sizeof(DirReader));
+    ALLOC_CHECK(reader);
+    if (reader_open(reader, fd)) {
+        free(reader);
+        return;
+    }
+
+    /// putanja je koren + rel + '/' + ime; child pokazuje na deo rel
+    memcpy(path, walk->root, walk->root_len);
+    child = path + walk->root_len;
+    memcpy(child, rel, rel_len);
+    if (rel_len)
+        child[rel_len++] = '/';
+
+    while (reader_next(reader, &name, &type)) {
+        if (!strcmp(name, ".") || !strcmp(name, ".."))
+            continue;
+
+        name_len = strlen(name);
+        if (walk->root_len + rel_len + name_len >= WALK_PATH_MAX)
+            continue;
+        memcpy(child + rel_len, name, name_len + 1);
+
+        if (type == DT_DIR)
+            is_dir = 1;
+        else if (type == DT_REG)
+            is_dir = 0;
+        else if (type == DT_UNKNOWN || type == DT_LNK) {
+            /// simbolicki linkovi se prate samo do regularnih fajlova
+            if (fstatat(fd, name, &st, type == DT_LNK ? 0 : AT_SYMLINK_NOFOLLOW))
+                continue;
+            if (S_ISREG(st.st_mode))
+                is_dir = 0;
+            else if (S_ISDIR(st.st_mode) && type == DT_UNKNOWN)
+                is_dir = 1;
+            else
+                continue;
+        }
+        else
+            continue;
+
+        if (match_any(walk->exclude, walk->exclude_rel, walk->n_exclude, child, name))
+            continue;
+
+        if (is_dir) {
+            if (!walk->visit(walk->arg, path, child, 1))
+                push_dir(walk, child);
+        }
+        else if (!walk->n_include || match_any(walk->include, walk->include_rel, walk->n_include, child, name))
+            walk->visit(walk->arg, path, child, 0);
+    }
+
+    reader_close(reader);
+    free(reader);
+}
+
+/**
+* @brief Glavna funkcija niti koja obilazi stablo.
+* @param[in] arg Pokazivac na Walk
+*/
+static void* walk_thread(void *arg) {
+    Walk *walk = (Walk*)arg;
+    WalkDir *dir;
+
+    for (;;) {
+        pthread_mutex_lock(&walk->lock);
+        while (!walk->stack && walk->active)
+            pthread_cond_wait(&walk->more, &walk->lock);
+        dir = walk->stack;
+        if (dir)
+            walk->stack = dir->next;
+        pthread_mutex_unlock(&walk->lock);
+
+        if (!dir)
+            break;
+
+        read_dir(walk, dir->rel);
+        free(dir->rel);
+        free(dir);
+
+        pthread_mutex_lock(&walk->lock);
+        if (!--walk->active)
+            pthread_cond_broadcast(&walk->more);
+        pthread_mutex_unlock(&walk->lock);
+    }
+    return NULL;
+}
+
+/*********************** EXTERNAL FUNCTIONS ***********************/
+int walk_tree(const char *root, WalkOptions *opts, WalkVisit visit, void *arg) {
+    Walk *walk = (Walk*) calloc(1, sizeof(Walk));
+    pthread_t threads[WALK_MAX_THREADS];
+    struct stat st;
+    int n_threads, i;
+    ALLOC_CHECK(walk);
+
+    if (compile_globs(opts->include, opts->n_include, walk->include, walk->include_rel)) {
+        free(walk);
+        return 1;
+    }
+    if (compile_globs(opts->exclude, opts->n_exclude, walk->exclude, walk->exclude_rel)) {
+        for (i = 0; i < opts->n_include; i++)
+            wildcard_free(&walk->include[i]);
+        free(walk);
+        return 1;
+    }
+    walk->n_include = opts->n_include;
+    walk->n_exclude = opts->n_exclude;
+
+    walk->root_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (walk->root_fd < 0 || strlen(root) + 2 >= WALK_PATH_MAX) {
+        if (walk->root_fd >= 0)
+            close(walk->root_fd);
+        for (i = 0; i < walk->n_include; i++)
+            wildcard_free(&walk->include[i]);
+        for (i = 0; i < walk->n_exclude; i++)
+            wildcard_free(&walk->exclude[i]);
+        free(walk);
+        return FILE_ERR;
+    }
+
+    strcpy(walk->root, root);
+    walk->root_len = strlen(root);
+    if (walk->root[walk->root_len - 1] != '/')
+        walk->root[walk->root_len++] = '/';
+    walk->root[walk->root_len] = '\0';
+
+    if (opts->skip_dir && !stat(opts->skip_dir, &st)) {
+        walk->has_skip = 1;
+        walk->skip_dev = st.st_dev;
+        walk->skip_ino = st.st_ino;
+    }
+
+    walk->visit = visit;
+    walk->arg = arg;
+    pthread_mutex_init(&walk->lock, NULL);
+    pthread_cond_init(&walk->more, NULL);
+
+    if (!visit(arg, root, "", 1)) {
+        push_dir(walk, "");
+
+        n_threads = opts->threads < 1 ? 1 : (opts->threads > WALK_MAX_THREADS ? WALK_MAX_THREADS : opts->threads);
+        for (i = 1; i < n_threads; i++)
+            pthread_create(&threads[i], NULL, walk_thread, walk);
+        walk_thread(walk);
+        for (i = 1; i < n_threads; i++)
+            pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&walk->lock);
+    pthread_cond_destroy(&walk->more);
+    close(walk->root_fd);
+    for (i = 0; i < walk->n_include; i++)
+        wildcard_free(&walk->include[i]);
+    for (i = 0; i < walk->n_exclude; i++)
+        wildcard_free(&walk->exclude[i]);
+    free(walk);
+    return 0;
+}
@@ -0,0 +1,65 @@
+/**
+* @file
+* @brief Zaglavlje za paralelni obilazak stabla direktorijuma.
+* @details Vise niti istovremeno cita direktorijume (openat u odnosu na koren i getdents64), a
+* svaki pronadjeni fajl koji prodje filtere se odmah prosledjuje funkciji posetioca, tako da
+* obrada fajlova pocinje pre nego sto je obilazak zavrsen.
+*/
+
+#ifndef _WALKER_H
+#define _WALKER_H
+
+#include "wildcard.h"
+
+/**
+* @brief Maksimalan broj obrazaca za ukljucivanje, odnosno iskljucivanje fajlova.
+*/
+#define WALK_MAX_GLOBS 16
+
+/**
+* @brief Maksimalan broj niti koje obilaze stablo.
+*/
+#define WALK_MAX_THREADS 4
+
+/**
+* @brief Maksimalna duzina relativne putanje u stablu.
+*/
+#define WALK_PATH_MAX 4096
+
+/**
+* @brief Typedef pokazivaca na funkciju koja se poziva za svaki pronadjeni direktorijum i fajl.
+* Moze biti pozvana istovremeno iz vise niti.
+* @param[in] arg Argument zadat funkciji walk_tree
+* @param[in] path Putanja do fajla (koren spojen sa relativnom putanjom)
+* @param[in] rel Putanja u odnosu na koren (prazan string za sam koren)
+* @param[in] is_dir 1 za direktorijum, 0 za fajl
+* @return Za direktorijum: 0 ako ga treba obici, broj razlicit od 0 ako ga treba preskociti
+*/
+typedef int (*WalkVisit)(void *arg, const char *path, const char *rel, int is_dir);
+
+/**
+* @brief Opcije obilaska stabla.
+* @details Obrazac bez '/' se poredi sa nazivom fajla, a obrazac sa '/' sa putanjom u odnosu na koren.
+* Ukoliko nema obrazaca za ukljucivanje, ukljucuju se svi fajlovi. Obrasci za iskljucivanje vaze
+* i za direktorijume (iskljuceni direktorijum se ne obilazi).
+*/
+typedef struct WalkOptions {
+    int threads;
+    int n_include, n_exclude;
+    char *include[WALK_MAX_GLOBS];
+    char *exclude[WALK_MAX_GLOBS];
+    const char *skip_dir;   /**< Direktorijum koji se ne obilazi (npr. izlazni direktorijum unutar stabla), moze biti NULL */
+} WalkOptions;
+
+/**
+* @brief Funkcija koja obilazi stablo direktorijuma.
+* @param[in] root Koren stabla
+* @param[in] opts Opcije obilaska
+* @param[in] visit Funkcija koja se poziva za koren, svaki direktorijum i svaki obican fajl
+* @param[in] arg Argument koji se prosledjuje funkciji visit
+* @return 0 ako je obilazak uspesan, 1 ukoliko neki obrazac nije ispravan,
+* FILE_ERR ukoliko koren ne postoji ili nije direktorijum
+*/
+int walk_tree(const char *root, WalkOptions *opts, WalkVisit visit, void *arg);
+
+#endif // _WALKER_H
@@ -0,0 +1,203 @@
+/**
+* @file
+* @brief Funkcije za rezim pracenja direktorijuma (watch) preko inotify-a.
+* @details Jedna nit cita dogadjaje i prikuplja putanje; kada se dogadjaji smire, prikupljene putanje se
+* zadaju istoj obradi kao kod ostalih komandi za vise fajlova (batch.h), pa se rezultati ispisuju u log
+* redosledom zadavanja. Obrada traje sve dok ne stigne SIGINT ili SIGTERM, posle cega se zavrsavaju
+* vec zadati fajlovi.
+*/
+
+#include "watch.h"
+#include "global.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+/**
+* @brief Velicina bafera za citanje dogadjaja.
+*/
+#define WATCH_EVENTS_LEN (64 * 1024)
+
+/**
+* @brief Najduze cekanje na dogadjaj (u milisekundama). Signal moze stici bilo kojoj niti, pa se
+* zastavica za kraj proverava i kada poll nije prekinut.
+*/
+#define WATCH_IDLE_MS 1000
+
+/**
+* @brief Postavlja se na 1 kada stigne signal za kraj pracenja.
+*/
+static volatile sig_atomic_t watch_stop = 0;
+
+/*********************** INTERNAL FUNCTIONS ***********************/
+static void watch_signal(int sig) {
+    (void)sig;
+    watch_stop = 1;
+}
+
+/**
+* @brief Funkcija koja vraca trenutno vreme u milisekundama.
+*/
+static long now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+/**
+* @brief Funkcija koja proverava da li fajl sa zadatim nazivom treba obraditi.
+*/
+static int wanted_name(const char *name, int encr_flag) {
+    size_t len = strlen(name);
+    int is_dat = len > 4 && !strcmp(name + len - 4, ".dat");
+
+    if (name[0] == '.')
+        return 0;
+    return encr_flag ? !is_dat : is_dat;
+}
+
+/**
+* @brief Funkcija koja zadaje sve prikupljene fajlove koji jos postoje i prazni spisak.
+*/
+static void flush_pending(BatchRun *run, char **pending, int *n_pending) {
+    struct stat st;
+    int i;
+
+    for (i = 0; i < *n_pending; i++) {
+        if (!stat(pending[i], &st) && S_ISREG(st.st_mode))
+            batch_submit(run, pending[i], NULL);
+        free(pending[i]);
+    }
+    *n_pending = 0;
+    batch_flush(run);
+}
+
+/**
+* @brief Funkcija koja dodaje putanju na spisak prikupljenih fajlova ukoliko vec nije na njemu.
+*/
+static void add_pending(char **pending, int *n_pending, const char *dir, const char *name) {
+    char *path = (char*) malloc(strlen(dir) + strlen(name) + 2);
+    int i;
+    ALLOC_CHECK(path);
+
+    sprintf(path, "%s/%s", dir, name);
+    for (i = 0; i < *n_pending; i++)
+        if (!strcmp(pending[i], path)) {
+            free(path);
+            return;
+        }
+    pending[(*n_pending)++] = path;
+}
+
+/*********************** EXTERNAL FUNCTIONS ***********************/
+int watch_directories(char **dirs, int n_dirs, Key *key, int encr_flag, char *error_msg, FILE *log, BatchOptions *opts) {
+    char *buf, *pending[WATCH_BATCH_MAX];
+    int wds[WATCH_MAX_DIRS];
+    int fd, i, n_pending = 0, timeout;
+    long first_event = 0, last_event = 0, now;
+    ssize_t len;
+    struct pollfd pfd;
+    struct sigaction sa, old_int, old_term;
+    struct inotify_event *ev;
+    BatchRun *run;
+
+    if (n_dirs < 1 || n_dirs > WATCH_MAX_DIRS) {
+        strcpy(error_msg, "Invalid number of directories!");
+        return 1;
+    }
+
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        strcpy(error_msg, "Unable to start watching!");
+        return 1;
+    }
+
+    for (i = 0; i < n_dirs; i++) {
+        wds[i] = inotify_add_watch(fd, dirs[i], IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR);
+        if (wds[i] < 0) {
+            sprintf(error_msg, "Unable to watch directory %.400s!", dirs[i]);
+            close(fd);
+            return 1;
+        }
+    }
+
+    buf = (char*) malloc(WATCH_EVENTS_LEN);
+    ALLOC_CHECK(buf);
+
+    watch_stop = 0;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = watch_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &old_int);
+    sigaction(SIGTERM, &sa, &old_term);
+
+    run = batch_begin(key, encr_flag, log, opts);
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+
+    while (!watch_stop) {
+        if (n_pending) {
+            now = now_ms();
+            timeout = (int)(last_event + WATCH_DEBOUNCE_MS - now);
+            if (first_event + WATCH_MAX_DELAY_MS - now < timeout)
+                timeout = (int)(first_event + WATCH_MAX_DELAY_MS - now);
+            if (timeout <= 0) {
+                flush_pending(run, pending, &n_pending);
+                continue;
+            }
+        }
+        else
+            timeout = WATCH_IDLE_MS;
+
+        if (poll(&pfd, 1, timeout) <= 0)
+            continue;
+
+        while ((len = read(fd, buf, WATCH_EVENTS_LEN)) > 0) {
+            for (ev = (struct inotify_event*)buf; (char*)ev < buf + len;
+                 ev = (struct inotify_event*)((char*)ev + sizeof(*ev) + ev->len)) {
+                if (ev->mask & IN_Q_OVERFLOW)
+                    fprintf(stderr, "Watch: event queue overflow, some files were missed\n");
+                if (!ev->len || (ev->mask & IN_ISDIR) || !wanted_name(ev->name, encr_flag))
+                    continue;
+
+                for (i = 0; i < n_dirs && wds[i] != ev->wd; i++)
+                    ;
+                if (i == n_dirs)
+                    continue;
+
+                if (!n_pending)
+                    first_event = now_ms();
+                last_event = now_ms();
+                add_pending(pending, &n_pending, dirs[i], ev->name);
+                if (n_pending == WATCH_BATCH_MAX)
+                    flush_pending(run, pending, &n_pending);
+            }
+        }
+    }
+
+    flush_pending(run, pending, &n_pending);
+    batch_end(run);
+
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+    free(buf);
+    close(fd);
+    return 0;
+}
+
+#else
+
+int watch_directories(char **dirs, int n_dirs, Key *key, int encr_flag, char *error_msg, FILE *log, BatchOptions *opts) {
+    strcpy(error_msg, "Watch mode is supported only on Linux!");
+    return 1;
+}
+
+#endif // __linux__
@@ -0,0 +1,51 @@
+/**
+* @file
+* @brief Zaglavlje za rezim pracenja direktorijuma (watch). Fajlovi koji se pojave u pracenim
+* direktorijumima se enkriptuju/dekriptuju cim budu zatvoreni posle pisanja ili premesteni u direktorijum.
+*/
+
+#ifndef _WATCH_H
+#define _WATCH_H
+
+#include "keys.h"
+#include "batch.h"
+#include <stdio.h>
+
+/**
+* @brief Vreme bez novih dogadjaja (u milisekundama) posle koga se prikupljeni fajlovi zadaju za obradu.
+*/
+#define WATCH_DEBOUNCE_MS 50
+
+/**
+* @brief Najduze vreme (u milisekundama) koje prvi prikupljeni fajl ceka, i ako dogadjaji stalno stizu.
+*/
+#define WATCH_MAX_DELAY_MS 500
+
+/**
+* @brief Najveci broj fajlova koji se prikupljaju pre zadavanja.
+*/
+#define WATCH_BATCH_MAX 256
+
+/**
+* @brief Maksimalan broj pracenih direktorijuma.
+*/
+#define WATCH_MAX_DIRS 64
+
+/**
+* @brief Funkcija koja prati zadate direktorijume dok program ne primi SIGINT ili SIGTERM.
+* @details Prati se IN_CLOSE_WRITE i IN_MOVED_TO. Dogadjaji se prikupljaju dok ne prodje WATCH_DEBOUNCE_MS
+* bez novih dogadjaja (ili WATCH_MAX_DELAY_MS od prvog), isti fajl se zadaje samo jednom, a zatim se svi
+* zadaju skupu radnih niti. Prilikom enkripcije se preskacu .dat fajlovi (izlazi same enkripcije) i skriveni
+* fajlovi, a prilikom dekripcije se obradjuju samo .dat fajlovi.
+* @param[in] dirs Niz putanja do direktorijuma
+* @param[in] n_dirs Broj direktorijuma
+* @param[in] key Pokazivac na kljuc koji treba koristiti
+* @param[in] encr_flag 1 za enkripciju, 0 za dekripciju
+* @param[out] error_msg String u koji ce biti upisana poruka o gresci
+* @param[out] log Pokazivac na fajl u koji treba ispisivati poruke o ishodu obrade svakog fajla
+* @param[in] opts Opcije obrade (broj niti, sta uraditi sa originalom), NULL za podrazumevane
+* @return 0 ako je pracenje regularno zavrseno, 1 ukoliko pracenje nije moguce zapoceti
+*/
+int watch_directories(char **dirs, int n_dirs, Key *key, int encr_flag, char *error_msg, FILE *log, BatchOptions *opts);
+
+#endif // _WATCH_H
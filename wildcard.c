@@ -0,0 +1,194 @@
+/**
+* @file
+* @brief Funkcije za poredjenje naziva fajlova sa obrascem (glob).
+* @details Poredjenje simulira nedeterministicki automat ciji su cvorovi pozicije u nizu tokena,
+* tako da je vreme poredjenja linearno u duzini naziva puta broj tokena, bez vracanja unazad.
+*/
+
+#include "wildcard.h"
+#include "global.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/**
+* @brief Broj tokena do kog se stanja automata cuvaju na steku.
+*/
+#define WILDCARD_STACK_TOKENS 128
+
+/*********************** INTERNAL FUNCTIONS ***********************/
+static void set_add(unsigned char *set, unsigned char c) {
+    set[c >> 3] |= 1 << (c & 7);
+}
+
+static int set_has(const unsigned char *set, unsigned char c) {
+    return set[c >> 3] & (1 << (c & 7));
+}
+
+/**
+* @brief Funkcija koja proverava da li '*' ili '?' sme da odgovara zadatom karakteru.
+*/
+static int any_allowed(const Wildcard *wc, unsigned char c) {
+    if ((wc->flags & WILDCARD_ALNUM) && !isalnum(c))
+        return 0;
+    if ((wc->flags & WILDCARD_PATH) && c == '/')
+        return 0;
+    return 1;
+}
+
+/**
+* @brief Funkcija koja prevodi klasu karaktera koja pocinje iza '['.
+* @return Pokazivac na karakter iza ']', NULL ukoliko klasa nije zatvorena
+*/
+static const char* compile_class(WildcardToken *token, const char *p) {
+    int negate = 0, i;
+
+    if (*p == '!' || *p == '^') {
+        negate = 1;
+        p++;
+    }
+
+    /// ']' na pocetku klase je obican karakter
+    if (*p == ']')
+        set_add(token->set, *p++);
+
+    while (*p && *p != ']') {
+        if (p[1] == '-' && p[2] && p[2] != ']') {
+            for (i = (unsigned char)p[0]; i <= (unsigned char)p[2]; i++)
+                set_add(token->set, i);
+            p += 3;
+        }
+        else
+            set_add(token->set, *p++);
+    }
+
+    if (!*p)
+        return NULL;
+
+    if (negate)
+        for (i = 0; i < 32; i++)
+            token->set[i] = ~token->set[i];
+    return p + 1;
+}
+
+/**
+* @brief Funkcija koja dodaje u skup stanja sva stanja dostizna preskakanjem '*' tokena.
+*/
+static void closure(const Wildcard *wc, char *states) {
+    int t;
+    for (t = 0; t < wc->n_tokens; t++)
+        if (states[t] && wc->tokens[t].type == WC_STAR)
+            states[t + 1] = 1;
+}
+
+/*********************** EXTERNAL FUNCTIONS ***********************/
+int wildcard_compile(Wildcard *wc, const char *pattern, int flags) {
+    WildcardToken *token;
+    const char *p = pattern;
+
+    wc->flags = flags;
+    wc->n_tokens = 0;
+    wc->tokens = (WildcardToken*) calloc(strlen(pattern) + 1, sizeof(WildcardToken));
+    ALLOC_CHECK(wc->tokens);
+
+    while (*p) {
+        token = &wc->tokens[wc->n_tokens];
+
+        if (*p == '*') {
+            /// vise uzastopnih '*' je isto sto i jedna
+            if (!wc->n_tokens || wc->tokens[wc->n_tokens - 1].type != WC_STAR) {
+                token->type = WC_STAR;
+                wc->n_tokens++;
+            }
+            p++;
+            continue;
+        }
+
+        if (*p == '?') {
+            token->type = WC_ANY;
+            p++;
+        }
+        else if (*p == '[') {
+            token->type = WC_CLASS;
+            if (!(p = compile_class(token, p + 1))) {
+                wildcard_free(wc);
+                return 1;
+            }
+        }
+        else {
+            token->type = WC_CHAR;
+            token->c = *p++;
+        }
+        wc->n_tokens++;
+    }
+
+    return 0;
+}
+
+int wildcard_match(const Wildcard *wc, const char *name) {
+    char stack_states[2][WILDCARD_STACK_TOKENS + 1];
+    char *cur = stack_states[0], *next = stack_states[1], *tmp;
+    const unsigned char *c;
+    const WildcardToken *token;
+    int t, alive, result;
+
+    if (wc->n_tokens > WILDCARD_STACK_TOKENS) {
+        cur = (char*) malloc(2 * (wc->n_tokens + 1));
+        ALLOC_CHECK(cur);
+        next = cur + wc->n_tokens + 1;
+    }
+
+    memset(cur, 0, wc->n_tokens + 1);
+    cur[0] = 1;
+    closure(wc, cur);
+
+    for (c = (const unsigned char*)name; *c; c++) {
+        memset(next, 0, wc->n_tokens + 1);
+        alive = 0;
+
+        for (t = 0; t < wc->n_tokens; t++) {
+            if (!cur[t])
+                continue;
+            token = &wc->tokens[t];
+
+            switch (token->type) {
+            case WC_STAR:
+                if (any_allowed(wc, *c))
+                    alive = next[t] = 1;
+                break;
+            case WC_ANY:
+                if (any_allowed(wc, *c))
+                    alive = next[t + 1] = 1;
+                break;
+            case WC_CLASS:
+                if (set_has(token->set, *c))
+                    alive = next[t + 1] = 1;
+                break;
+            default:
+                if (token->c == *c)
+                    alive = next[t + 1] = 1;
+                break;
+            }
+        }
+
+        if (!alive)
+            break;
+
+        closure(wc, next);
+        tmp = cur;
+        cur = next;
+        next = tmp;
+    }
+
+    result = !*c && cur[wc->n_tokens];
+
+    if (wc->n_tokens > WILDCARD_STACK_TOKENS)
+        free(cur < next ? cur : next);
+    return result;
+}
+
+void wildcard_free(Wildcard *wc) {
+    free(wc->tokens);
+    wc->tokens = NULL;
+    wc->n_tokens = 0;
+}
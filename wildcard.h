@@ -0,0 +1,70 @@
+/**
+* @file
+* @brief Zaglavlje za poredjenje naziva fajlova sa obrascem (glob). Obrazac se jednom prevodi
+* u niz tokena, a zatim se poredi sa svakim nazivom bez pravljenja regularnog izraza.
+* @details Podrzani su '*' (nula ili vise karaktera), '?' (tacno jedan karakter) i klase
+* karaktera "[abc]", "[a-z]", "[!a-z]" ili "[^a-z]". Ostali karakteri se porede doslovno.
+*/
+
+#ifndef _WILDCARD_H
+#define _WILDCARD_H
+
+/**
+* @brief '*' i '?' odgovaraju samo slovima i ciframa (ponasanje komandi -er/-dr).
+*/
+#define WILDCARD_ALNUM 1
+
+/**
+* @brief '*' i '?' ne odgovaraju karakteru '/', pa se obrazac moze porediti sa relativnom putanjom.
+*/
+#define WILDCARD_PATH 2
+
+/**
+* @brief Vrste tokena prevedenog obrasca.
+*/
+typedef enum WildcardTokenType {
+    WC_CHAR, WC_ANY, WC_STAR, WC_CLASS
+} WildcardTokenType;
+
+/**
+* @brief Jedan token prevedenog obrasca. Klasa karaktera je bit mapa od 256 bita.
+*/
+typedef struct WildcardToken {
+    WildcardTokenType type;
+    unsigned char c;
+    unsigned char set[32];
+} WildcardToken;
+
+/**
+* @brief Preveden obrazac.
+*/
+typedef struct Wildcard {
+    int n_tokens;
+    int flags;
+    WildcardToken *tokens;
+} Wildcard;
+
+/**
+* @brief Funkcija koja prevodi obrazac.
+* @param[out] wc Pokazivac na strukturu u koju se upisuje preveden obrazac
+* @param[in] pattern Obrazac
+* @param[in] flags Kombinacija WILDCARD_ALNUM i WILDCARD_PATH (ili 0)
+* @return 0 ako je obrazac ispravan, 1 ukoliko klasa karaktera nije zatvorena
+*/
+int wildcard_compile(Wildcard *wc, const char *pattern, int flags);
+
+/**
+* @brief Funkcija koja proverava da li ceo zadati naziv odgovara obrascu.
+* @param[in] wc Pokazivac na preveden obrazac
+* @param[in] name Naziv fajla
+* @return 1 ako naziv odgovara obrascu, 0 u suprotnom
+*/
+int wildcard_match(const Wildcard *wc, const char *name);
+
+/**
+* @brief Funkcija koja oslobadja preveden obrazac.
+* @param[in] wc Pokazivac na preveden obrazac
+*/
+void wildcard_free(Wildcard *wc);
+
+#endif // _WILDCARD_H